@@ -0,0 +1,272 @@
+/**
+ *  \file dist_matrix.c
+ *  \brief Distributed matrix descriptors and redistribution for Proj1
+ *
+ *  Rows and columns are distributed independently, so the elements
+ *  one process holds in a source layout and another holds in a target
+ *  layout are a set of rows times a set of columns. Each side is
+ *  described by an indexed datatype over runs of consecutive local
+ *  rows, resized to one column, inside an indexed datatype over runs
+ *  of local columns. Both sides list the rows and columns in global
+ *  order, so the two datatypes match element for element.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+#include "dist_matrix.h"
+
+/**
+ * Owner of global row (or column) i
+ **/
+int dist_matrix_owner(int i, int block, int procs) {
+
+    return (i / block) % procs;
+}
+
+/**
+ * Local index of global row (or column) i on its owner
+ **/
+int dist_matrix_local(int i, int block, int procs) {
+
+    return (i / (block * procs)) * block + i % block;
+}
+
+/**
+ * Number of rows (or columns) of n that process index holds
+ **/
+int dist_matrix_count(int n, int block, int index, int procs) {
+
+    int blocks = n / block;
+    int count = (blocks / procs) * block;
+    int extra = blocks % procs;
+
+    if(index < extra)
+        count += block;
+    else if(index == extra)
+        count += n % block;
+
+    return count;
+}
+
+/**
+ * Sets up a descriptor and allocates this process's part
+ **/
+void dist_matrix_init(dist_matrix_t *mat, int m, int n, int procGridX,
+        int procGridY, int rowBlock, int colBlock) {
+
+    int rank = summa_grid_rank();
+    int procs;
+
+    MPI_Comm_size(summa_comm(), &procs);
+    assert(procGridX * procGridY <= procs);
+
+    if(rowBlock == 0)
+    {
+        assert(m % procGridX == 0);
+        rowBlock = m / procGridX;
+    }
+    if(colBlock == 0)
+    {
+        assert(n % procGridY == 0);
+        colBlock = n / procGridY;
+    }
+
+    mat->m = m;
+    mat->n = n;
+    mat->procGridX = procGridX;
+    mat->procGridY = procGridY;
+    mat->rowBlock = rowBlock;
+    mat->colBlock = colBlock;
+    mat->data = NULL;
+
+    if(rank < procGridX * procGridY)
+    {
+        mat->indexX = rank % procGridX;
+        mat->indexY = rank / procGridX;
+        mat->localRows = dist_matrix_count(m, rowBlock, mat->indexX, procGridX);
+        mat->localCols = dist_matrix_count(n, colBlock, mat->indexY, procGridY);
+        if(mat->localRows > 0 && mat->localCols > 0)
+            mat->data = allocate_matrix(mat->localRows, mat->localCols);
+    }
+    else
+    {
+        mat->indexX = -1;
+        mat->indexY = -1;
+        mat->localRows = 0;
+        mat->localCols = 0;
+    }
+}
+
+/**
+ * Releases the local storage
+ **/
+void dist_matrix_free(dist_matrix_t *mat) {
+
+    if(mat->data != NULL)
+        deallocate_matrix(mat->data);
+    mat->data = NULL;
+}
+
+/**
+ * Runs of local indices, in layout a if inA is set and in layout b
+ *  otherwise, of the rows (or columns) of n that index fromA holds in
+ *  a and index toB holds in b; returns the number of runs
+ *
+ *  starts and lengths need room for one entry per row held.
+ **/
+static int shared_runs(int n, int blockA, int procsA, int fromA, int blockB,
+        int procsB, int toB, int inA, int *starts, int *lengths) {
+
+    int li, runs = 0;
+    int count = dist_matrix_count(n, blockA, fromA, procsA);
+
+    for(li = 0; li < count; ++li)
+    {
+        int i = ((li / blockA) * procsA + fromA) * blockA + li % blockA;
+        int local;
+
+        if(dist_matrix_owner(i, blockB, procsB) != toB)
+            continue;
+
+        local = inA ? li : dist_matrix_local(i, blockB, procsB);
+        if(runs > 0 && starts[runs - 1] + lengths[runs - 1] == local)
+        {
+            lengths[runs - 1]++;
+        }
+        else
+        {
+            starts[runs] = local;
+            lengths[runs] = 1;
+            runs++;
+        }
+    }
+
+    return runs;
+}
+
+/**
+ * Datatype of the elements a process with coordinates (fromX, fromY)
+ *  in a holds and one with (toX, toY) in b holds, laid out in the
+ *  local storage of a (inA) or of b; MPI_DATATYPE_NULL if there are none
+ **/
+static MPI_Datatype shared_type(const dist_matrix_t *a, int fromX, int fromY,
+        const dist_matrix_t *b, int toX, int toY, int inA, int *buffer) {
+
+    int rowRuns, colRuns;
+    int ld = inA ? a->localRows : b->localRows;
+    int held = (a->m > a->n) ? a->m : a->n;
+    int *rowStarts = buffer, *rowLengths = buffer + held;
+    int *colStarts = buffer + 2 * held, *colLengths = buffer + 3 * held;
+    MPI_Datatype rows, column, type;
+
+    if(fromX < 0 || toX < 0)
+        return MPI_DATATYPE_NULL;
+
+    rowRuns = shared_runs(a->m, a->rowBlock, a->procGridX, fromX, b->rowBlock,
+            b->procGridX, toX, inA, rowStarts, rowLengths);
+    colRuns = shared_runs(a->n, a->colBlock, a->procGridY, fromY, b->colBlock,
+            b->procGridY, toY, inA, colStarts, colLengths);
+    if(rowRuns == 0 || colRuns == 0)
+        return MPI_DATATYPE_NULL;
+
+    MPI_Type_indexed(rowRuns, rowLengths, rowStarts, MPI_DOUBLE, &rows);
+    MPI_Type_create_resized(rows, 0, (MPI_Aint) ld * sizeof(double), &column);
+    MPI_Type_indexed(colRuns, colLengths, colStarts, column, &type);
+    MPI_Type_commit(&type);
+
+    MPI_Type_free(&rows);
+    MPI_Type_free(&column);
+
+    return type;
+}
+
+/**
+ * Copies src into dst, which may have another grid and block size
+ **/
+void dist_matrix_redistribute(const dist_matrix_t *src, dist_matrix_t *dst) {
+
+    int p, procs;
+    int held = (src->m > src->n) ? src->m : src->n;
+    int *counts[2], *displs;
+    MPI_Datatype *types[2];
+    int *buffer;
+    double dummy;
+
+    assert(src->m == dst->m && src->n == dst->n);
+
+    MPI_Comm_size(summa_comm(), &procs);
+
+    counts[0] = (int *) malloc(2 * procs * sizeof(int));
+    counts[1] = counts[0] + procs;
+    displs = (int *) calloc(procs, sizeof(int));
+    types[0] = (MPI_Datatype *) malloc(2 * procs * sizeof(MPI_Datatype));
+    types[1] = types[0] + procs;
+    buffer = (int *) malloc(4 * held * sizeof(int));
+    assert(counts[0] != NULL && displs != NULL && types[0] != NULL && buffer != NULL);
+
+    for(p = 0; p < procs; ++p)
+    {
+        /* p's coordinates in both grids */
+        int srcX = (p < src->procGridX * src->procGridY) ? p % src->procGridX : -1;
+        int srcY = p / src->procGridX;
+        int dstX = (p < dst->procGridX * dst->procGridY) ? p % dst->procGridX : -1;
+        int dstY = p / dst->procGridX;
+
+        /* What this process holds in src and p holds in dst */
+        types[0][p] = shared_type(src, src->indexX, src->indexY, dst, dstX,
+                dstY, 1, buffer);
+        /* What p holds in src and this process holds in dst */
+        types[1][p] = shared_type(src, srcX, srcY, dst, dst->indexX,
+                dst->indexY, 0, buffer);
+
+        counts[0][p] = (types[0][p] != MPI_DATATYPE_NULL);
+        counts[1][p] = (types[1][p] != MPI_DATATYPE_NULL);
+        if(!counts[0][p])
+            types[0][p] = MPI_DOUBLE;
+        if(!counts[1][p])
+            types[1][p] = MPI_DOUBLE;
+    }
+
+    /* The datatypes carry every offset; displacements are all 0 */
+    MPI_Alltoallw((src->data != NULL) ? src->data : &dummy, counts[0], displs,
+            types[0], (dst->data != NULL) ? dst->data : &dummy, counts[1],
+            displs, types[1], summa_comm());
+
+    for(p = 0; p < procs; ++p)
+    {
+        if(counts[0][p])
+            MPI_Type_free(&types[0][p]);
+        if(counts[1][p])
+            MPI_Type_free(&types[1][p]);
+    }
+
+    free(counts[0]);
+    free(displs);
+    free(types[0]);
+    free(buffer);
+}
+
+/**
+ * summa() on descriptors, C = A*B + C
+ **/
+void summa_dist(const dist_matrix_t *A, const dist_matrix_t *B,
+        dist_matrix_t *C, int blockSize) {
+
+    int px = C->procGridX;
+    int py = C->procGridY;
+
+    assert(A->m == C->m && B->n == C->n && A->n == B->m);
+    assert(A->procGridX == px && B->procGridX == px);
+    assert(A->procGridY == py && B->procGridY == py);
+    assert(A->rowBlock * px == A->m && A->colBlock * py == A->n);
+    assert(B->rowBlock * px == B->m && B->colBlock * py == B->n);
+    assert(C->rowBlock * px == C->m && C->colBlock * py == C->n);
+
+    summa(C->m, C->n, A->n, A->data, B->data, C->data, px, py, blockSize);
+}
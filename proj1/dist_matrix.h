@@ -0,0 +1,84 @@
+/**
+ *  \file dist_matrix.h
+ *  \brief Distributed matrix descriptors and redistribution for Proj1
+ *
+ *  A dist_matrix_t records how an m by n matrix is spread over a
+ *  procGridX by procGridY process grid: in 2D block-cyclic layout,
+ *  blocks of rowBlock by colBlock elements dealt out round-robin,
+ *  row blocks over indexX and column blocks over indexY. With
+ *  rowBlock = m / procGridX and colBlock = n / procGridY every process
+ *  holds one block, the layout summa() expects, so the local storage
+ *  of such a matrix can be passed to summa() directly.
+ *
+ *  Grid coordinates come from summa_grid_rank(), indexX = rank %
+ *  procGridX; a grid may use fewer processes than summa_comm() has,
+ *  and the others then hold no part of the matrix.
+ */
+
+#ifndef DIST_MATRIX_H
+#define DIST_MATRIX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  int m, n; /* global dimensions */
+  int procGridX, procGridY;
+  int rowBlock, colBlock; /* block-cyclic block size */
+  int indexX, indexY; /* grid coordinates, -1 if not in the grid */
+  int localRows, localCols; /* local storage, column-major, ld = localRows */
+  double *data;
+} dist_matrix_t;
+
+/**
+ * Sets up a descriptor and allocates this process's part
+ *
+ *  rowBlock or colBlock 0 selects the block layout of summa(),
+ *  m / procGridX or n / procGridY, which must then divide evenly.
+ *  The local storage is not initialized.
+ **/
+void dist_matrix_init(dist_matrix_t *mat, int m, int n, int procGridX,
+    int procGridY, int rowBlock, int colBlock);
+
+/**
+ * Releases the local storage
+ **/
+void dist_matrix_free(dist_matrix_t *mat);
+
+/**
+ * Local index of global row (or column) i on its owner, and the owner
+ **/
+int dist_matrix_owner(int i, int block, int procs);
+int dist_matrix_local(int i, int block, int procs);
+
+/**
+ * Number of rows (or columns) of n a process holds, as ScaLAPACK's
+ *  numroc
+ **/
+int dist_matrix_count(int n, int block, int index, int procs);
+
+/**
+ * Copies src into dst, which may have another grid and block size
+ *
+ *  Both descriptors must describe the same m by n matrix. Every
+ *  process sends each other process, in one MPI_Alltoallw, the
+ *  elements it holds in src and the other holds in dst, described
+ *  in place by indexed datatypes on both sides; nothing is gathered
+ *  or packed. Collective over summa_comm().
+ **/
+void dist_matrix_redistribute(const dist_matrix_t *src, dist_matrix_t *dst);
+
+/**
+ * summa() on descriptors, C = A*B + C
+ *
+ *  A, B and C must be in the block layout of one grid.
+ **/
+void summa_dist(const dist_matrix_t *A, const dist_matrix_t *B,
+    dist_matrix_t *C, int blockSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DIST_MATRIX_H */
@@ -0,0 +1,303 @@
+/**
+ *  \file local_mm.cpp
+ *  \brief Matrix Multiply file for Proj1
+ *  \author Kent Czechowski <kentcz@gatech...>, Rich Vuduc <richie@gatech...>
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <omp.h>
+
+#include "local_mm.h"
+#include "mm_blas.h"
+#include "mm_epilogue.h"
+#include "mm_jit.h"
+#include "mm_core.hpp"
+
+#ifdef USE_MKL
+#include <mkl.h>
+#endif
+
+static int complex_algorithm = MM_COMPLEX_4M;
+
+
+extern "C" void report_num_threads(int level);
+
+    void
+report_num_threads(int level)
+{ 
+#pragma omp single 
+    {
+        printf("Level %d: number of threads in the team - %d\n", level, omp_get_num_threads()); 
+    }
+}
+
+/**
+ *
+ *  Local Matrix Multiply
+ *   Computes C = alpha * A * B + beta * C
+ *
+ *
+ *  Similar to the DGEMM routine in BLAS
+ *
+ *
+ *  alpha and beta are double-precision scalars
+ *
+ *  A, B, and C are matrices of double-precision elements
+ *  stored in column-major format 
+ *
+ *  The output is stored in C
+ *  A and B are not modified during computation
+ *
+ *
+ *  m - number of rows of matrix A and rows of C
+ *  n - number of columns of matrix B and columns of C
+ *  k - number of columns of matrix A and rows of B
+ * 
+ *  lda, ldb, and ldc specifies the size of the first dimension of the matrices
+ *
+ *  Without USE_MKL every variant below is an instantiation of
+ *   mm::gemm() in mm_core.hpp; local_mm() itself runs on the BLAS
+ *   backend MM_BLAS selects (see mm_blas.h), native by default.
+ *
+ **/
+#ifndef EXTERNAL_LOCAL_MM
+void local_mm(const int m, const int n, const int k, const double alpha,
+    const double *A, const int lda, const double *B, const int ldb,
+    const double beta, double *C, const int ldc) {
+
+  /* Verify the sizes of lda, ladb, and ldc */
+  assert(lda >= m);
+  assert(ldb >= k);
+  assert(ldc >= m);
+
+#ifdef USE_MKL
+
+  printf("Using MKL...\n");
+  char transa[1] = {'N'};
+  char transb[1] = {'N'};
+
+  dgemm(transa,
+          transb,
+          &m,
+          &n,
+          &k,
+          &alpha,
+          A,
+          &lda,
+          B,
+          &ldb,
+          &beta,
+          C,
+          &ldc);
+
+#else
+  /* The backend MM_BLAS selects, native unless set */
+  int backend = mm_blas_choose(m, n, k);
+
+  if (backend != MM_BLAS_NATIVE) {
+    mm_blas_dgemm(backend, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+    return;
+  }
+  local_mm_native(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+#endif
+
+}
+#endif /* EXTERNAL_LOCAL_MM */
+
+/**
+ *
+ *  local_mm() on the built-in kernel, whatever backend is selected
+ *
+ **/
+void local_mm_native(const int m, const int n, const int k,
+    const double alpha, const double *A, const int lda, const double *B,
+    const int ldb, const double beta, double *C, const int ldc) {
+
+  /* A small shape seen before runs its generated kernel */
+  mm_jit_kernel_t kernel = mm_jit_lookup(m, n, k, lda, ldb, ldc, alpha, beta);
+
+  if (kernel != NULL) {
+    const double alphaBeta[2] = {alpha, beta};
+
+    kernel(A, B, C, alphaBeta);
+    return;
+  }
+  mm::gemm<double>(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+/**
+ *
+ *  Local Matrix Multiply with a fused epilogue
+ *   Computes C = epilogue(alpha * A * B + beta * C)
+ *
+ *  Arguments as in local_mm(). Each tile of C goes through the
+ *  epilogue right after its last update; with MKL the epilogue is a
+ *  separate pass after dgemm.
+ *
+ **/
+void local_mm_epilogue(const int m, const int n, const int k,
+    const double alpha, const double *A, const int lda, const double *B,
+    const int ldb, const double beta, double *C, const int ldc,
+    const mm_epilogue_t *epilogue) {
+
+  assert(lda >= m);
+  assert(ldb >= k);
+  assert(ldc >= m);
+
+#ifdef USE_MKL
+  local_mm(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+  mm_epilogue_apply(epilogue, 0, 0, m, n, C, ldc);
+#else
+  mm::gemm<double>(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, epilogue);
+#endif
+}
+
+/**
+ *
+ *  Single-precision Local Matrix Multiply
+ *
+ *  Similar to the SGEMM routine in BLAS, arguments as in local_mm()
+ *
+ **/
+void local_mm_f(const int m, const int n, const int k, const float alpha,
+    const float *A, const int lda, const float *B, const int ldb,
+    const float beta, float *C, const int ldc) {
+
+#ifdef USE_MKL
+  char transa[1] = {'N'};
+  char transb[1] = {'N'};
+
+  sgemm(transa, transb, &m, &n, &k, &alpha, A, &lda, B, &ldb, &beta, C, &ldc);
+#else
+  mm::gemm<float>(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+#endif
+}
+
+/**
+ *
+ *  Mixed-precision Local Matrix Multiply
+ *
+ *  A and B are single-precision, C, alpha and beta double-precision.
+ *  The product of two floats is exact in double precision, so the
+ *  only rounding is in the double-precision accumulation.
+ *
+ **/
+void local_mm_mixed(const int m, const int n, const int k, const double alpha,
+    const float *A, const int lda, const float *B, const int ldb,
+    const double beta, double *C, const int ldc) {
+
+  mm::gemm<float, double, mm::traits<double>::MR, mm::traits<double>::NR>(
+      m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+/**
+ *
+ *  Single-precision complex Local Matrix Multiply
+ *
+ *  Similar to the CGEMM routine in BLAS, arguments as in local_mm()
+ *
+ **/
+void local_mm_c(const int m, const int n, const int k,
+    const mm_complex_float alpha, const mm_complex_float *A, const int lda,
+    const mm_complex_float *B, const int ldb, const mm_complex_float beta,
+    mm_complex_float *C, const int ldc) {
+
+  if (complex_algorithm == MM_COMPLEX_3M) {
+    mm::gemm_3m<float>(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+  } else {
+    mm::gemm<mm_complex_float>(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+  }
+}
+
+/**
+ *
+ *  Double-precision complex Local Matrix Multiply
+ *
+ *  Similar to the ZGEMM routine in BLAS, arguments as in local_mm()
+ *  Under MM_COMPLEX_3M this and local_mm_c() split A and B into real
+ *  and imaginary planes and take three real products, mm::gemm_3m().
+ *
+ **/
+void local_mm_z(const int m, const int n, const int k,
+    const mm_complex_double alpha, const mm_complex_double *A, const int lda,
+    const mm_complex_double *B, const int ldb, const mm_complex_double beta,
+    mm_complex_double *C, const int ldc) {
+
+  if (complex_algorithm == MM_COMPLEX_3M) {
+    mm::gemm_3m<double>(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+  } else {
+    mm::gemm<mm_complex_double>(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+  }
+}
+
+/**
+ *
+ *  Planar double-precision complex Local Matrix Multiply
+ *
+ *  As local_mm_z() with every complex matrix held as two real ones,
+ *  X = Xr + i Xi, each plane with the leading dimension of X. The
+ *  product is made of real local_mm() calls, four or three depending
+ *  on local_mm_set_complex().
+ *
+ **/
+void local_mm_zp(const int m, const int n, const int k,
+    const mm_complex_double alpha, const double *Ar, const double *Ai,
+    const int lda, const double *Br, const double *Bi, const int ldb,
+    const mm_complex_double beta, double *Cr, double *Ci, const int ldc) {
+
+  mm::gemm_planar<double>(complex_algorithm, m, n, k, alpha, Ar, Ai, lda, Br,
+      Bi, ldb, beta, Cr, Ci, ldc);
+}
+
+void local_mm_set_complex(int algorithm) {
+  assert(algorithm == MM_COMPLEX_4M || algorithm == MM_COMPLEX_3M);
+  complex_algorithm = algorithm;
+}
+
+int local_mm_get_complex(void) {
+  return complex_algorithm;
+}
+
+/**
+ *
+ *  Triangular Local Matrix Multiply
+ *   Computes C = alpha * L * B + beta * C
+ *
+ *  Similar to the DTRMM routine in BLAS (side left, lower, no
+ *  transpose) but accumulating into C. L is the lower triangle of the
+ *  m by m matrix A; its strictly upper triangle is not referenced.
+ *  B and C are m by n.
+ *
+ **/
+void local_mm_trmm(const int m, const int n, const double alpha,
+    const double *A, const int lda, const double *B, const int ldb,
+    const double beta, double *C, const int ldc) {
+
+  assert(lda >= m);
+  assert(ldb >= m);
+  assert(ldc >= m);
+
+  mm::trmm<double>(m, n, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+/**
+ *
+ *  Symmetric rank-k Local Matrix Multiply
+ *   Computes C = alpha * A * A^T + beta * C
+ *
+ *  Similar to the DSYRK routine in BLAS (lower, no transpose). A is
+ *  n by k; only the lower triangle of the n by n matrix C is read and
+ *  written.
+ *
+ **/
+void local_mm_syrk(const int n, const int k, const double alpha,
+    const double *A, const int lda, const double beta, double *C,
+    const int ldc) {
+
+  assert(lda >= n);
+  assert(ldc >= n);
+
+  mm::syrk<double>(n, k, alpha, A, lda, beta, C, ldc);
+}
@@ -1,4 +1,101 @@
+/**
+ *  \file local_mm.h
+ *  \brief Local Matrix Multiply for Proj1
+ *
+ *  Every variant computes C = alpha * A * B + beta * C on column-major
+ *  matrices, with the arguments of local_mm(). local_mm_trmm() and
+ *  local_mm_syrk() exploit a triangular A or a symmetric C and take
+ *  the arguments of the BLAS routines they follow.
+ *
+ *  Complex matrices are either interleaved, one mm_complex_double per
+ *  element as in ZGEMM, or planar, a real and an imaginary matrix.
+ *  local_mm_set_complex() picks how the complex variants multiply.
+ */
+
+#ifndef LOCAL_MM_H
+#define LOCAL_MM_H
+
+#ifdef __cplusplus
+#include <complex>
+typedef std::complex<float> mm_complex_float;
+typedef std::complex<double> mm_complex_double;
+extern "C" {
+#else
+#include <complex.h>
+typedef float _Complex mm_complex_float;
+typedef double _Complex mm_complex_double;
+#endif
+
 void local_mm(const int m, const int n, const int k, const double alpha,
     const double *A, const int lda, const double *B, const int ldb,
     const double beta, double *C, const int ldc);
 
+void local_mm_f(const int m, const int n, const int k, const float alpha,
+    const float *A, const int lda, const float *B, const int ldb,
+    const float beta, float *C, const int ldc);
+
+void local_mm_mixed(const int m, const int n, const int k, const double alpha,
+    const float *A, const int lda, const float *B, const int ldb,
+    const double beta, double *C, const int ldc);
+
+void local_mm_c(const int m, const int n, const int k,
+    const mm_complex_float alpha, const mm_complex_float *A, const int lda,
+    const mm_complex_float *B, const int ldb, const mm_complex_float beta,
+    mm_complex_float *C, const int ldc);
+
+void local_mm_z(const int m, const int n, const int k,
+    const mm_complex_double alpha, const mm_complex_double *A, const int lda,
+    const mm_complex_double *B, const int ldb, const mm_complex_double beta,
+    mm_complex_double *C, const int ldc);
+
+#define MM_COMPLEX_4M 0 /*!< Four real products, or the native complex kernel */
+#define MM_COMPLEX_3M 1 /*!< Three real products (Karatsuba), 25% fewer multiplies */
+
+/**
+ * Selects the complex algorithm of local_mm_c(), local_mm_z(),
+ *  local_mm_zp() and so of summa_c(), summa_z() and summa_zp()
+ *
+ *  Under MM_COMPLEX_4M interleaved matrices go through the complex
+ *  microkernel and planar ones through four real products. Under
+ *  MM_COMPLEX_3M both are three real products, interleaved matrices
+ *  being split into planes first. Every process of a SUMMA call must
+ *  make the same selection.
+ **/
+void local_mm_set_complex(int algorithm);
+
+/**
+ * Returns the selection made by local_mm_set_complex()
+ **/
+int local_mm_get_complex(void);
+
+/**
+ * C = alpha * A * B + beta * C on planar complex matrices
+ *
+ *  A = Ar + i Ai, B = Br + i Bi and C = Cr + i Ci; the two planes of a
+ *  matrix share its leading dimension.
+ **/
+void local_mm_zp(const int m, const int n, const int k,
+    const mm_complex_double alpha, const double *Ar, const double *Ai,
+    const int lda, const double *Br, const double *Bi, const int ldb,
+    const mm_complex_double beta, double *Cr, double *Ci, const int ldc);
+
+/**
+ * C = alpha * L * B + beta * C, L the lower triangle of the m by m A
+ **/
+void local_mm_trmm(const int m, const int n, const double alpha,
+    const double *A, const int lda, const double *B, const int ldb,
+    const double beta, double *C, const int ldc);
+
+/**
+ * C = alpha * A * A^T + beta * C on the lower triangle of the n by n C,
+ *  A n by k
+ **/
+void local_mm_syrk(const int n, const int k, const double alpha,
+    const double *A, const int lda, const double beta, double *C,
+    const int ldc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOCAL_MM_H */
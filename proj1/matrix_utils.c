@@ -6,11 +6,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <time.h>
 #include <math.h>
 #include <mpi.h>
 
+#include "mm_numa.h"
+
 /**
  * Matrix Utility Functions
  *  
@@ -22,10 +25,15 @@
 
 /**
  * Allocates a matrix
+ *
+ *  Pages are placed by mm_alloc(): first touched by the threads
+ *  that compute on them unless MM_ALLOC says otherwise. The
+ *  generators below then fill the matrix from one thread, which no
+ *  longer decides where it lives.
  **/
 double *allocate_matrix(int rows, int cols) {
   double *mat = NULL;
-  mat = malloc(sizeof(double) * rows * cols);
+  mat = mm_alloc(rows, cols, sizeof(double));
   assert(mat != NULL);
   return (mat);
 }
@@ -37,6 +45,38 @@ void deallocate_matrix(double *mat) {
   free(mat);
 }
 
+/**
+ * Allocates a single-precision matrix
+ **/
+float *allocate_matrix_f(int rows, int cols) {
+  float *mat = NULL;
+  mat = mm_alloc(rows, cols, sizeof(float));
+  assert(mat != NULL);
+  return (mat);
+}
+
+/**
+ * Deallocates a single-precision matrix
+ **/
+void deallocate_matrix_f(float *mat) {
+  free(mat);
+}
+
+/**
+ * Rounds a double-precision matrix to single precision
+ **/
+float *convert_matrix_f(int rows, int cols, double *mat) {
+
+  int i;
+  float *dest = allocate_matrix_f(rows, cols);
+
+  for (i = 0; i < rows * cols; i++) {
+    dest[i] = (float) mat[i];
+  }
+
+  return dest;
+}
+
 /**
  * Print the elements of the matrix
  **/
@@ -95,6 +135,28 @@ double *random_matrix_bin(int rows, int cols) {
   return mat;
 }
 
+/**
+ * Sets each element to a random value with probability density,
+ *  to 0 otherwise
+ **/
+double *random_matrix_sparse(int rows, int cols, double density) {
+
+  int r, c;
+  double *mat = allocate_matrix(rows, cols);
+
+  for (c = 0; c < cols; c++) {
+    for (r = 0; r < rows; r++) {
+      int index = (c * rows) + r;
+      if (rand() / (RAND_MAX + 1.0) < density)
+        mat[index] = 1.0 + round(9.0 * rand() / (RAND_MAX + 1.0));
+      else
+        mat[index] = 0.0;
+    } /* r */
+  } /* c */
+
+  return mat;
+}
+
 /**
  * Sets each element of the matrix to 1
  **/
@@ -211,16 +273,13 @@ void write_csv(int rows, int cols, double *mat, char *filename) {
 }
 
 /**
- * Copy a block of a matrix mat to dest
- *  
- * mat is a m by n matrix
- * block size is determined by procGridX and procGridY
- * rank is used to pick the block to copy 
+ * Copy a block of a matrix of elemSize-byte elements,
+ *  see copy_block()
  */
-void copy_block(int procGridX, int procGridY, int rank, int n, int m,
-    double *mat, double *dest) {
+static void copy_block_bytes(int procGridX, int procGridY, int rank, int n,
+    int m, const char *mat, char *dest, size_t elemSize) {
 
-  int row, col;
+  int col;
   int block_index = 0;
 
   int block_rows = n / procGridX;
@@ -236,26 +295,34 @@ void copy_block(int procGridX, int procGridY, int rank, int n, int m,
   assert(n % procGridX == 0);
   assert(m % procGridY == 0);
 
-  /* Loop over the columns in the block*/
+  /* Loop over the columns in the block, rows are contiguous */
   for (col = proc_y * block_cols; col < (proc_y + 1) * block_cols; col++) {
-
-    /* Loop over the rows in the block*/
-    for (row = proc_x * block_rows; row < (proc_x + 1) * block_rows; row++) {
-      int mat_index = (col * n) + row;
-      dest[block_index] = mat[mat_index];
-      block_index++;
-    } /* row */
+    size_t mat_index = ((size_t) col * n) + proc_x * block_rows;
+    memcpy(dest + block_index * elemSize, mat + mat_index * elemSize,
+        block_rows * elemSize);
+    block_index += block_rows;
   } /* col */
 }
 
 /**
- * Reoder a matrix so that block elements are contiguous 
- * 
- * src is the original matrix 
- * dest is the reordered matrix
+ * Copy a block of a matrix mat to dest
+ *  
+ * mat is a m by n matrix
+ * block size is determined by procGridX and procGridY
+ * rank is used to pick the block to copy 
  */
-void reorder_matrix(int procGridX, int procGridY, int n, int m, double *src,
-    double *dest) {
+void copy_block(int procGridX, int procGridY, int rank, int n, int m,
+    double *mat, double *dest) {
+
+  copy_block_bytes(procGridX, procGridY, rank, n, m, (const char *) mat,
+      (char *) dest, sizeof(double));
+}
+
+/**
+ * Reorder a matrix of elemSize-byte elements, see reorder_matrix()
+ */
+static void reorder_matrix_bytes(int procGridX, int procGridY, int n, int m,
+    const char *src, char *dest, size_t elemSize) {
 
   int block;
   int num_blocks = procGridX * procGridY;
@@ -270,11 +337,24 @@ void reorder_matrix(int procGridX, int procGridY, int n, int m, double *src,
 
   /* Loop over all blocks */
   for (block = 0; block < num_blocks; block++) {
-    copy_block(procGridX, procGridY, block, n, m, src, &(dest[block_size
-        * block]));
+    copy_block_bytes(procGridX, procGridY, block, n, m, src,
+        &(dest[(size_t) block_size * block * elemSize]), elemSize);
   } /* block */
 }
 
+/**
+ * Reoder a matrix so that block elements are contiguous 
+ * 
+ * src is the original matrix 
+ * dest is the reordered matrix
+ */
+void reorder_matrix(int procGridX, int procGridY, int n, int m, double *src,
+    double *dest) {
+
+  reorder_matrix_bytes(procGridX, procGridY, n, m, (const char *) src,
+      (char *) dest, sizeof(double));
+}
+
 /**
  * Distributes the a blocks of the matrix 
  *  to each process
@@ -285,31 +365,72 @@ void reorder_matrix(int procGridX, int procGridY, int n, int m, double *src,
  *  
  * The appropiate block of the matrix
  *  is saved to the block buffer
+ *
+ * type is the MPI datatype of one element; block b goes to rank b of
+ *  comm, and mat is read on rank root of comm
  */
-void distribute_matrix(int procGridX, int procGridY, int n, int m, double *mat,
-    double *block, int rank) {
+static void distribute_matrix_type(int procGridX, int procGridY, int n,
+    int m, void *mat, void *block, MPI_Datatype type, MPI_Comm comm,
+    int root) {
 
-  double *buffer = NULL;
+  char *buffer = NULL;
+  int elemSize;
+  int rank;
 
   int num_procs = procGridX * procGridY;
   int block_size = m * n / num_procs;
 
-  if (rank == 0) {
+  MPI_Type_size(type, &elemSize);
+  MPI_Comm_rank(comm, &rank);
+
+  if (rank == root) {
     /* Allocate a buffer for the reordered matrix */
-    buffer = malloc(sizeof(double) * m * n);
+    buffer = malloc((size_t) elemSize * m * n);
     assert(buffer != NULL);
 
-    reorder_matrix(procGridX, procGridY, n, m, mat, buffer);
+    reorder_matrix_bytes(procGridX, procGridY, n, m, mat, buffer, elemSize);
   }
 
-  MPI_Scatter(buffer, block_size, MPI_DOUBLE, block, block_size, MPI_DOUBLE, 0,
-      MPI_COMM_WORLD);
+  MPI_Scatter(buffer, block_size, type, block, block_size, type, root,
+      comm);
 
-  if (rank == 0) {
+  if (rank == root) {
     free(buffer);
   }
 }
 
+/**
+ * Distributes a double-precision matrix, see distribute_matrix_type()
+ */
+void distribute_matrix(int procGridX, int procGridY, int n, int m, double *mat,
+    double *block, int rank) {
+
+  (void) rank;
+  distribute_matrix_type(procGridX, procGridY, n, m, mat, block, MPI_DOUBLE,
+      MPI_COMM_WORLD, 0);
+}
+
+/**
+ * distribute_matrix() over comm, see distribute_matrix_type()
+ */
+void distribute_matrix_comm(int procGridX, int procGridY, int n, int m,
+    double *mat, double *block, MPI_Comm comm, int root) {
+
+  distribute_matrix_type(procGridX, procGridY, n, m, mat, block, MPI_DOUBLE,
+      comm, root);
+}
+
+/**
+ * Single-precision distribute_matrix()
+ */
+void distribute_matrix_f(int procGridX, int procGridY, int n, int m,
+    float *mat, float *block, int rank) {
+
+  (void) rank;
+  distribute_matrix_type(procGridX, procGridY, n, m, mat, block, MPI_FLOAT,
+      MPI_COMM_WORLD, 0);
+}
+
 #define EPSILON 0.00001
 
 /**
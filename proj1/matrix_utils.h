@@ -4,6 +4,8 @@
  *  \author Kent Czechowski <kentcz@gatech...>
  */
 
+#include <mpi.h>
+
 
 /**
  * Matrix Utility Functions
@@ -24,6 +26,21 @@ double *allocate_matrix(int rows, int cols);
  **/
 void deallocate_matrix(double *mat);
 
+/**
+ * Allocates a single-precision matrix
+ **/
+float *allocate_matrix_f(int rows, int cols);
+
+/**
+ * Deallocates a single-precision matrix
+ **/
+void deallocate_matrix_f(float *mat);
+
+/**
+ * Rounds a double-precision matrix to a new single-precision matrix
+ **/
+float *convert_matrix_f(int rows, int cols, double *mat);
+
 /**
  * Print the elements of the matrix
  **/
@@ -39,6 +56,12 @@ double *random_matrix(int rows, int cols);
  **/
 double *random_matrix_bin(int rows, int cols);
 
+/**
+ * Sets each element to a random value with probability density,
+ *  to 0 otherwise
+ **/
+double *random_matrix_sparse(int rows, int cols, double density);
+
 /**
  * Sets each element of the matrix to 1
  **/
@@ -98,6 +121,19 @@ void reorder_matrix(int procGridX, int procGridY, int n, int m, double *src,
 void distribute_matrix(int procGridX, int procGridY, int n, int m, double *mat,
     double *block, int rank);
 
+/**
+ * distribute_matrix() over comm: block b goes to rank b of comm,
+ *  and the full matrix is read on rank root of comm
+ */
+void distribute_matrix_comm(int procGridX, int procGridY, int n, int m,
+    double *mat, double *block, MPI_Comm comm, int root);
+
+/**
+ * Single-precision distribute_matrix()
+ */
+void distribute_matrix_f(int procGridX, int procGridY, int n, int m,
+    float *mat, float *block, int rank);
+
 /**
  * Verifies that two numbers are REASONABLY close
  **/
@@ -0,0 +1,287 @@
+/**
+ *  \file mm_blas.c
+ *  \brief Run-time selectable BLAS backends for local_mm()
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+#include <dlfcn.h>
+
+#include "mm_blas.h"
+
+/**
+ * Fortran DGEMM; the two trailing lengths are the hidden lengths of
+ *  the character arguments, which C implementations ignore
+ **/
+typedef void (*dgemm_fn)(const char *transa, const char *transb,
+    const int *m, const int *n, const int *k, const double *alpha,
+    const double *A, const int *lda, const double *B, const int *ldb,
+    const double *beta, double *C, const int *ldc, size_t, size_t);
+
+typedef struct {
+  char name[32];
+  void *handle;
+  dgemm_fn dgemm;
+} backend_t;
+
+typedef struct {
+  int m, n, k, backend;
+} shape_t;
+
+/** Libraries tried, in this order, before MM_BLAS_LIBS */
+static const char *candidates[] = {
+  "libopenblas.so.0", "libopenblas.so", "libblis.so.4", "libblis.so",
+  "libmkl_rt.so.2", "libmkl_rt.so", "libblas.so.3", "libblas.so", NULL
+};
+
+static backend_t backends[MM_BLAS_MAX];
+static int count = 0;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+static int selected = -2; /*!< -2 until set or read from MM_BLAS */
+
+static shape_t shapes[MM_BLAS_SHAPES];
+static int nshapes = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Adds the library at path unless it is missing, has no dgemm_ or is
+ *  one already added
+ **/
+static void add(const char *path) {
+
+  const char *file = strrchr(path, '/');
+  void *handle;
+  dgemm_fn dgemm;
+  char *end;
+  int i;
+
+  if (count == MM_BLAS_MAX) {
+    return;
+  }
+  if ((handle = dlopen(path, RTLD_NOW | RTLD_LOCAL)) == NULL) {
+    return;
+  }
+  dgemm = (dgemm_fn) dlsym(handle, "dgemm_");
+  for (i = 1; i < count && dgemm != NULL; i++) {
+    if (backends[i].dgemm == dgemm) {
+      dgemm = NULL;
+    }
+  }
+  if (dgemm == NULL) {
+    dlclose(handle);
+    return;
+  }
+
+  /* libopenblas.so.0 is "openblas" */
+  file = (file == NULL) ? path : file + 1;
+  if (strncmp(file, "lib", 3) == 0) {
+    file += 3;
+  }
+  snprintf(backends[count].name, sizeof(backends[count].name), "%s", file);
+  if ((end = strstr(backends[count].name, ".so")) != NULL) {
+    *end = '\0';
+  }
+  backends[count].handle = handle;
+  backends[count].dgemm = dgemm;
+  count++;
+}
+
+static void discover(void) {
+
+  const char *env = getenv("MM_BLAS_LIBS");
+  int i;
+
+  snprintf(backends[0].name, sizeof(backends[0].name), "native");
+  backends[0].handle = NULL;
+  backends[0].dgemm = NULL;
+  count = 1;
+
+  for (i = 0; candidates[i] != NULL; i++) {
+    add(candidates[i]);
+  }
+
+  if (env != NULL) {
+    char *list = strdup(env);
+    char *save = NULL;
+    char *path;
+
+    assert(list != NULL);
+    for (path = strtok_r(list, ":", &save); path != NULL;
+        path = strtok_r(NULL, ":", &save)) {
+      add(path);
+    }
+    free(list);
+  }
+}
+
+int mm_blas_count(void) {
+  pthread_once(&once, discover);
+  return count;
+}
+
+const char *mm_blas_name(int backend) {
+  assert(backend >= 0 && backend < mm_blas_count());
+  return backends[backend].name;
+}
+
+int mm_blas_find(const char *name) {
+
+  int i;
+
+  for (i = 0; i < mm_blas_count(); i++) {
+    if (strcmp(backends[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int mm_blas_select(int backend) {
+
+  int previous = mm_blas_selected();
+
+  assert(backend == MM_BLAS_AUTO
+      || (backend >= 0 && backend < mm_blas_count()));
+  selected = backend;
+  return previous;
+}
+
+int mm_blas_selected(void) {
+
+  if (selected == -2) {
+    const char *env = getenv("MM_BLAS");
+
+    selected = MM_BLAS_NATIVE;
+    if (env != NULL && strcmp(env, "auto") == 0) {
+      selected = MM_BLAS_AUTO;
+    } else if (env != NULL && mm_blas_find(env) >= 0) {
+      selected = mm_blas_find(env);
+    } else if (env != NULL) {
+      fprintf(stderr, "MM_BLAS=%s not found, using native\n", env);
+    }
+  }
+  return selected;
+}
+
+void mm_blas_dgemm(int backend, int m, int n, int k, double alpha,
+    const double *A, int lda, const double *B, int ldb, double beta,
+    double *C, int ldc) {
+
+  assert(backend >= 0 && backend < mm_blas_count());
+
+  if (backend == MM_BLAS_NATIVE) {
+    local_mm_native(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+  } else {
+    backends[backend].dgemm("N", "N", &m, &n, &k, &alpha, A, &lda, B, &ldb,
+        &beta, C, &ldc, 1, 1);
+  }
+}
+
+static double now(void) {
+
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+/**
+ * The backend that multiplies scratch m by k and k by n matrices
+ *  fastest, best of a few runs after a warm-up
+ **/
+static int fastest(int m, int n, int k) {
+
+  double *A = (double *) malloc((size_t) m * k * sizeof(double));
+  double *B = (double *) malloc((size_t) k * n * sizeof(double));
+  double *C = (double *) malloc((size_t) m * n * sizeof(double));
+  int reps = (2.0 * m * n * k > 1e9) ? 1 : 3;
+  int b, r, best = MM_BLAS_NATIVE;
+  double bestTime = 0.0;
+  size_t i;
+
+  assert(A != NULL && B != NULL && C != NULL);
+  for (i = 0; i < (size_t) m * k; i++) {
+    A[i] = 1.0 / (1.0 + i % 7);
+  }
+  for (i = 0; i < (size_t) k * n; i++) {
+    B[i] = 1.0 / (1.0 + i % 5);
+  }
+
+  for (b = 0; b < mm_blas_count(); b++) {
+    double time = 0.0;
+
+    mm_blas_dgemm(b, m, n, k, 1.0, A, m, B, k, 0.0, C, m);
+    for (r = 0; r < reps; r++) {
+      double start = now();
+
+      mm_blas_dgemm(b, m, n, k, 1.0, A, m, B, k, 0.0, C, m);
+      if (r == 0 || now() - start < time) {
+        time = now() - start;
+      }
+    }
+    if (b == 0 || time < bestTime) {
+      best = b;
+      bestTime = time;
+    }
+  }
+
+  free(A);
+  free(B);
+  free(C);
+  return best;
+}
+
+int mm_blas_choose(int m, int n, int k) {
+
+  int i, backend = mm_blas_selected();
+
+  /* Nothing to multiply: native only scales C, and needs no timing */
+  if (m == 0 || n == 0 || k == 0) {
+    return MM_BLAS_NATIVE;
+  }
+  if (backend != MM_BLAS_AUTO) {
+    return backend;
+  }
+  if (mm_blas_count() == 1) {
+    return MM_BLAS_NATIVE;
+  }
+
+  pthread_mutex_lock(&lock);
+  for (i = 0; i < nshapes; i++) {
+    if (shapes[i].m == m && shapes[i].n == n && shapes[i].k == k) {
+      backend = shapes[i].backend;
+      pthread_mutex_unlock(&lock);
+      return backend;
+    }
+  }
+  pthread_mutex_unlock(&lock);
+
+  /* Past MM_BLAS_SHAPES shapes, new ones are not timed */
+  if (i == MM_BLAS_SHAPES) {
+    return MM_BLAS_NATIVE;
+  }
+
+  /* Timed without the lock; a shape timed twice at once is kept once */
+  backend = fastest(m, n, k);
+
+  pthread_mutex_lock(&lock);
+  for (i = 0; i < nshapes; i++) {
+    if (shapes[i].m == m && shapes[i].n == n && shapes[i].k == k) {
+      break;
+    }
+  }
+  if (i == nshapes && nshapes < MM_BLAS_SHAPES) {
+    shapes[nshapes].m = m;
+    shapes[nshapes].n = n;
+    shapes[nshapes].k = k;
+    shapes[nshapes].backend = backend;
+    nshapes++;
+  }
+  pthread_mutex_unlock(&lock);
+  return backend;
+}
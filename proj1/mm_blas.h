@@ -0,0 +1,88 @@
+/**
+ *  \file mm_blas.h
+ *  \brief Run-time selectable BLAS backends for local_mm()
+ *
+ *  On first use the registry looks for BLAS libraries with dlopen():
+ *  OpenBLAS, BLIS, MKL (through libmkl_rt) and the system libblas, plus
+ *  any paths listed, colon-separated, in MM_BLAS_LIBS. A library counts
+ *  once however many names it answers to. Backend 0, "native", is the
+ *  built-in kernel of mm_core.hpp (and mm_jit.h); every other backend
+ *  is the library's Fortran dgemm_.
+ *
+ *  MM_BLAS picks the backend local_mm() uses: a backend name, "native"
+ *  (the default), or "auto", which times every backend on the first
+ *  call of each shape and keeps the fastest for that shape. A shape
+ *  with m, n or k 0 has nothing to multiply or time and runs natively,
+ *  which also keeps the leading dimensions of 0 local_mm() allows for
+ *  such shapes away from dgemm_, which rejects them.
+ *
+ *  The compile-time USE_MKL build links MKL directly and ignores the
+ *  registry.
+ */
+
+#ifndef MM_BLAS_H
+#define MM_BLAS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MM_BLAS_NATIVE 0 /*!< The built-in kernel */
+#define MM_BLAS_AUTO -1 /*!< The fastest backend for each shape */
+#define MM_BLAS_MAX 8 /*!< Backends, native included */
+#define MM_BLAS_SHAPES 64 /*!< Shapes "auto" remembers */
+
+/**
+ * Number of backends found, native included
+ **/
+int mm_blas_count(void);
+
+/**
+ * Name of a backend: "native", "openblas", "blis", "mkl_rt", "blas" or
+ *  the file name of a library from MM_BLAS_LIBS without "lib" and ".so"
+ **/
+const char *mm_blas_name(int backend);
+
+/**
+ * The backend called name, or -1
+ **/
+int mm_blas_find(const char *name);
+
+/**
+ * Makes local_mm() use backend, or MM_BLAS_AUTO; returns the previous
+ *  choice
+ **/
+int mm_blas_select(int backend);
+
+/**
+ * The current choice, read from MM_BLAS on first use
+ **/
+int mm_blas_selected(void);
+
+/**
+ * The backend local_mm() runs an m by n by k product on; under
+ *  MM_BLAS_AUTO the first call for a shape times every backend on
+ *  scratch matrices of that shape
+ **/
+int mm_blas_choose(int m, int n, int k);
+
+/**
+ * C = alpha * A * B + beta * C on the given backend, arguments as in
+ *  local_mm()
+ **/
+void mm_blas_dgemm(int backend, int m, int n, int k, double alpha,
+    const double *A, int lda, const double *B, int ldb, double beta,
+    double *C, int ldc);
+
+/**
+ * local_mm() on the built-in kernel, whatever the selection
+ **/
+void local_mm_native(const int m, const int n, const int k,
+    const double alpha, const double *A, const int lda, const double *B,
+    const int ldb, const double beta, double *C, const int ldc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MM_BLAS_H */
@@ -0,0 +1,846 @@
+/**
+ *  \file mm_core.hpp
+ *  \brief Type-generic template core of local_mm() and summa() for Proj1
+ *
+ *  Header-only. The element type T is float, double,
+ *  std::complex<float> or std::complex<double>; the C entry points in
+ *  local_mm.cpp and summa.cpp are instantiations of these templates.
+ *
+ *  C += A*B is computed one MR by NR tile of C at a time. MR and NR
+ *  are template parameters, so the microkernel's loops have constant
+ *  trip counts and the compiler unrolls them and keeps the tile in
+ *  vector registers. Partial tiles at the edges of C go through the
+ *  same code with runtime bounds.
+ */
+
+#ifndef MM_CORE_HPP
+#define MM_CORE_HPP
+
+#include <assert.h>
+#include <stdlib.h>
+#include <complex>
+#include <mpi.h>
+
+#include "local_mm.h"
+#include "mm_epilogue.h"
+#include "mm_numa.h"
+#include "mm_pool.h"
+#include "summa_internal.h"
+#include "summa_trace.h"
+
+namespace mm {
+
+#define MM_KC 256 /*!< Depth of one pass over k, keeps A and B tiles in cache */
+
+/**
+ * Per-type parameters: default tile shape, MPI datatype and the
+ *  number of real flops in one multiply-add
+ **/
+template <typename T> struct traits;
+
+template <> struct traits<float> {
+  enum { MR = 16, NR = 4, FLOPS = 2 };
+  static MPI_Datatype mpi_type() { return MPI_FLOAT; }
+};
+
+template <> struct traits<double> {
+  enum { MR = 8, NR = 4, FLOPS = 2 };
+  static MPI_Datatype mpi_type() { return MPI_DOUBLE; }
+};
+
+template <> struct traits<std::complex<float> > {
+  enum { MR = 8, NR = 2, FLOPS = 8 };
+  static MPI_Datatype mpi_type() { return MPI_C_FLOAT_COMPLEX; }
+};
+
+template <> struct traits<std::complex<double> > {
+  enum { MR = 4, NR = 2, FLOPS = 8 };
+  static MPI_Datatype mpi_type() { return MPI_C_DOUBLE_COMPLEX; }
+};
+
+/**
+ * acc += a * b
+ *
+ *  The complex overload spells out the real arithmetic, so it
+ *  vectorizes and skips the NaN/Inf recovery of operator*.
+ **/
+template <typename TC, typename TA>
+inline void mul_add(TC &acc, const TA &a, const TA &b) {
+  acc += (TC) a * (TC) b;
+}
+
+template <typename R>
+inline void mul_add(std::complex<R> &acc, const std::complex<R> &a,
+    const std::complex<R> &b) {
+  acc = std::complex<R>(
+      acc.real() + a.real() * b.real() - a.imag() * b.imag(),
+      acc.imag() + a.real() * b.imag() + a.imag() * b.real());
+}
+
+/**
+ * Writes C = alpha * acc + beta * C; C is not read when beta is zero
+ **/
+template <typename TC>
+inline void update(TC &c, const TC &acc, const TC &alpha, const TC &beta) {
+  if (beta == TC(0)) {
+    c = alpha * acc;
+  } else {
+    c = alpha * acc + beta * c;
+  }
+}
+
+/**
+ * One full MR by NR tile: C = alpha * A * B + beta * C
+ *
+ *  A has MR rows and k columns (leading dimension lda),
+ *  B has k rows and NR columns (leading dimension ldb).
+ **/
+template <typename TA, typename TC, int MR, int NR>
+inline void micro_kernel(int k, TC alpha, const TA *A, int lda, const TA *B,
+    int ldb, TC beta, TC *C, int ldc) {
+
+  TC acc[NR][MR];
+  int i, j, p;
+
+  for (j = 0; j < NR; j++) {
+    for (i = 0; i < MR; i++) {
+      acc[j][i] = TC(0);
+    }
+  }
+
+  /* Iterate over column of A, row of B */
+  for (p = 0; p < k; p++) {
+    const TA *a = A + (long) p * lda;
+
+    for (j = 0; j < NR; j++) {
+      const TA b = B[(long) j * ldb + p];
+
+      /* Vectorize across the rows of the tile, not along k */
+      #pragma omp simd
+      for (i = 0; i < MR; i++) {
+        mul_add(acc[j][i], a[i], b);
+      }
+    }
+  } /* p */
+
+  for (j = 0; j < NR; j++) {
+    for (i = 0; i < MR; i++) {
+      update(C[(long) j * ldc + i], acc[j][i], alpha, beta);
+    }
+  }
+}
+
+/**
+ * A partial tile of mr <= MR rows and nr <= NR columns
+ **/
+template <typename TA, typename TC, int MR, int NR>
+inline void edge_kernel(int mr, int nr, int k, TC alpha, const TA *A, int lda,
+    const TA *B, int ldb, TC beta, TC *C, int ldc) {
+
+  TC acc[NR][MR];
+  int i, j, p;
+
+  for (j = 0; j < nr; j++) {
+    for (i = 0; i < mr; i++) {
+      acc[j][i] = TC(0);
+    }
+  }
+
+  for (p = 0; p < k; p++) {
+    const TA *a = A + (long) p * lda;
+
+    for (j = 0; j < nr; j++) {
+      const TA b = B[(long) j * ldb + p];
+
+      for (i = 0; i < mr; i++) {
+        mul_add(acc[j][i], a[i], b);
+      }
+    }
+  } /* p */
+
+  for (j = 0; j < nr; j++) {
+    for (i = 0; i < mr; i++) {
+      update(C[(long) j * ldc + i], acc[j][i], alpha, beta);
+    }
+  }
+}
+
+/**
+ * Applies an epilogue to a tile of C; epilogues exist for double only
+ **/
+inline void epilogue_tile(const mm_epilogue_t *epilogue, int row, int col,
+    int rows, int cols, double *C, int ldc) {
+  mm_epilogue_apply(epilogue, row, col, rows, cols, C, ldc);
+}
+
+template <typename TC>
+inline void epilogue_tile(const mm_epilogue_t *epilogue, int, int, int, int,
+    TC *, int) {
+  assert(epilogue == NULL);
+}
+
+/**
+ * C = alpha * A * B + beta * C on a block of tiles
+ *
+ *  Columns [col0, col1) of C, all m rows, one MM_KC-deep pass over k
+ *  at a time. Arguments otherwise as in local_mm(). The epilogue, if
+ *  any, is applied to each tile in the last pass, right after it is
+ *  written; row0 is the row of C the block starts at.
+ **/
+template <typename TA, typename TC, int MR, int NR>
+void gemm_columns(int m, int col0, int col1, int k, TC alpha, const TA *A,
+    int lda, const TA *B, int ldb, TC beta, TC *C, int ldc,
+    const mm_epilogue_t *epilogue = NULL, int row0 = 0) {
+
+  int kc, row, col;
+
+  for (kc = 0; kc < k; kc += MM_KC) {
+    int depth = (k - kc < MM_KC) ? k - kc : MM_KC;
+    TC beta_kc = (kc == 0) ? beta : TC(1);
+    bool last = (epilogue != NULL && kc + depth == k);
+    const TA *Ak = A + (long) kc * lda;
+    const TA *Bk = B + kc;
+
+    for (col = col0; col < col1; col += NR) {
+      int nr = (col1 - col < NR) ? col1 - col : NR;
+
+      for (row = 0; row < m; row += MR) {
+        int mr = (m - row < MR) ? m - row : MR;
+        const TA *a = Ak + row;
+        const TA *b = Bk + (long) col * ldb;
+        TC *c = C + (long) col * ldc + row;
+
+        if (mr == MR && nr == NR) {
+          micro_kernel<TA, TC, MR, NR>(depth, alpha, a, lda, b, ldb, beta_kc,
+              c, ldc);
+        } else {
+          edge_kernel<TA, TC, MR, NR>(mr, nr, depth, alpha, a, lda, b, ldb,
+              beta_kc, c, ldc);
+        }
+
+        if (last) {
+          epilogue_tile(epilogue, row0 + row, col, mr, nr, c, ldc);
+        }
+      } /* row */
+    } /* col */
+  } /* kc */
+}
+
+#define MM_TASKS_PER_THREAD 4 /*!< Tiles per pool thread, room for stealing */
+#define MM_MIN_WORK 32768 /*!< m*n*k below which a multiply stays on the caller */
+
+/**
+ * A multiply split into pool tasks: rowTiles by colTiles tiles of C,
+ *  times kSplits slices of k
+ *
+ *  Slice 0 updates C; slice s > 0 writes alpha * A_s * B_s into
+ *  partial + (s - 1) * m * n, which gemm_reduce() adds to C. The
+ *  epilogue goes with the last update of C: slice 0 when k is not
+ *  split, gemm_reduce() when it is.
+ **/
+template <typename TA, typename TC>
+struct gemm_job {
+  int m, n, k;
+  TC alpha, beta;
+  const TA *A;
+  int lda;
+  const TA *B;
+  int ldb;
+  TC *C;
+  int ldc;
+  int rowTile, colTile, rowTiles, colTiles;
+  int kChunk, kSplits;
+  TC *partial;
+  const mm_epilogue_t *epilogue;
+};
+
+/**
+ * Pool task: one tile of C over one slice of k
+ *
+ *  Tasks run down the tiles of a column block first, so each thread's
+ *  share of the tasks covers whole columns, as mm_alloc() touched them.
+ **/
+template <typename TA, typename TC, int MR, int NR>
+void gemm_task(void *arg, int task) {
+
+  gemm_job<TA, TC> *job = (gemm_job<TA, TC> *) arg;
+  int tiles = job->rowTiles * job->colTiles;
+  int slice = task / tiles;
+  int tile = task % tiles;
+  int row0 = (tile % job->rowTiles) * job->rowTile;
+  int col0 = (tile / job->rowTiles) * job->colTile;
+  int k0 = slice * job->kChunk;
+  int rows = (job->m - row0 < job->rowTile) ? job->m - row0 : job->rowTile;
+  int col1 = (job->n - col0 < job->colTile) ? job->n : col0 + job->colTile;
+  int depth = (job->k - k0 < job->kChunk) ? job->k - k0 : job->kChunk;
+  const TA *A = job->A + (long) k0 * job->lda + row0;
+  const TA *B = job->B + k0;
+
+  if (slice == 0) {
+    gemm_columns<TA, TC, MR, NR>(rows, col0, col1, depth, job->alpha, A,
+        job->lda, B, job->ldb, job->beta, job->C + row0, job->ldc,
+        (job->kSplits == 1) ? job->epilogue : NULL, row0);
+  } else {
+    TC *P = job->partial + (long) (slice - 1) * job->m * job->n;
+
+    gemm_columns<TA, TC, MR, NR>(rows, col0, col1, depth, job->alpha, A,
+        job->lda, B, job->ldb, TC(0), P + row0, job->m);
+  }
+}
+
+/**
+ * Pool task: adds the partial products of one column block to C,
+ *  then applies the epilogue to each finished column
+ **/
+template <typename TA, typename TC>
+void gemm_reduce(void *arg, int task) {
+
+  gemm_job<TA, TC> *job = (gemm_job<TA, TC> *) arg;
+  int col0 = task * job->colTile;
+  int col1 = (job->n - col0 < job->colTile) ? job->n : col0 + job->colTile;
+  int slice, row, col;
+
+  for (col = col0; col < col1; col++) {
+    TC *c = job->C + (long) col * job->ldc;
+
+    for (slice = 1; slice < job->kSplits; slice++) {
+      const TC *P = job->partial + (long) (slice - 1) * job->m * job->n
+          + (long) col * job->m;
+
+      for (row = 0; row < job->m; row++) {
+        c[row] += P[row];
+      }
+    }
+
+    if (job->epilogue != NULL) {
+      epilogue_tile(job->epilogue, 0, col, job->m, 1, c, job->ldc);
+    }
+  }
+}
+
+/**
+ * Local Matrix Multiply, C = alpha * A * B + beta * C
+ *
+ *  TA is the type of A and B, TC the type of C, alpha, beta and of
+ *  the accumulators (they differ for mixed precision).
+ *
+ *  C is cut into about MM_TASKS_PER_THREAD tiles per thread of the
+ *  persistent pool (mm_pool.h), columns first and rows when C is
+ *  too narrow. When even that leaves threads idle, as for the
+ *  m by n by pb products of summa() with small blocks, k is split as
+ *  well and the slices are summed into C afterwards.
+ *
+ *  A non-NULL epilogue (TC double only) is applied to every tile of C
+ *  after its last update, see mm_epilogue.h.
+ **/
+template <typename TA, typename TC, int MR, int NR>
+void gemm(int m, int n, int k, TC alpha, const TA *A, int lda, const TA *B,
+    int ldb, TC beta, TC *C, int ldc, const mm_epilogue_t *epilogue = NULL) {
+
+  int threads;
+  int target;
+  int blocks;
+  gemm_job<TA, TC> job;
+
+  /* Verify the sizes of lda, ladb, and ldc */
+  assert(lda >= m);
+  assert(ldb >= k);
+  assert(ldc >= m);
+
+  if (m == 0 || n == 0) {
+    return;
+  }
+
+  /* No product to add: C = beta * C, not read when beta is zero */
+  if (k == 0) {
+    int row, col;
+
+    for (col = 0; col < n; col++) {
+      TC *c = C + (long) col * ldc;
+
+      for (row = 0; row < m; row++) {
+        c[row] = (beta == TC(0)) ? TC(0) : beta * c[row];
+      }
+    }
+    if (epilogue != NULL) {
+      epilogue_tile(epilogue, 0, 0, m, n, C, ldc);
+    }
+    return;
+  }
+
+  threads = mm_pool_threads();
+  if (threads == 1 || (double) m * n * k < MM_MIN_WORK) {
+    gemm_columns<TA, TC, MR, NR>(m, 0, n, k, alpha, A, lda, B, ldb, beta, C,
+        ldc, epilogue);
+    return;
+  }
+
+  job.m = m;
+  job.n = n;
+  job.k = k;
+  job.alpha = alpha;
+  job.beta = beta;
+  job.A = A;
+  job.lda = lda;
+  job.B = B;
+  job.ldb = ldb;
+  job.C = C;
+  job.ldc = ldc;
+  job.partial = NULL;
+  job.epilogue = epilogue;
+  target = MM_TASKS_PER_THREAD * threads;
+
+  /* Column blocks, whole NR tiles each */
+  blocks = (n + NR - 1) / NR;
+  job.colTile = NR * ((blocks + target - 1) / target);
+  job.colTiles = (n + job.colTile - 1) / job.colTile;
+
+  /* Row blocks when there are too few columns, at least 4 MR tall */
+  blocks = (m + MR - 1) / MR;
+  job.rowTiles = (target + job.colTiles - 1) / job.colTiles;
+  job.rowTile = MR * ((blocks + job.rowTiles - 1) / job.rowTiles);
+  if (job.rowTile < 4 * MR) {
+    job.rowTile = 4 * MR;
+  }
+  job.rowTiles = (m + job.rowTile - 1) / job.rowTile;
+
+  /* Slices of k when the tiles cannot keep every thread busy */
+  job.kSplits = 1;
+  if (job.rowTiles * job.colTiles < threads && k >= 2 * MM_KC) {
+    job.kSplits = threads / (job.rowTiles * job.colTiles);
+    if (job.kSplits > k / MM_KC) {
+      job.kSplits = k / MM_KC;
+    }
+  }
+  job.kChunk = (k + job.kSplits - 1) / job.kSplits;
+  job.kSplits = (k + job.kChunk - 1) / job.kChunk;
+
+  if (job.kSplits > 1) {
+    job.partial = (TC *) malloc(sizeof(TC) * (job.kSplits - 1) * m * n);
+    assert(job.partial != NULL);
+  }
+
+  mm_pool_run(gemm_task<TA, TC, MR, NR>, &job,
+      job.kSplits * job.rowTiles * job.colTiles);
+
+  if (job.kSplits > 1) {
+    mm_pool_run(gemm_reduce<TA, TC>, &job, job.colTiles);
+    free(job.partial);
+  }
+}
+
+/**
+ * gemm() with the default tile shape of T
+ **/
+template <typename T>
+inline void gemm(int m, int n, int k, T alpha, const T *A, int lda,
+    const T *B, int ldb, T beta, T *C, int ldc,
+    const mm_epilogue_t *epilogue = NULL) {
+  gemm<T, T, traits<T>::MR, traits<T>::NR>(m, n, k, alpha, A, lda, B, ldb,
+      beta, C, ldc, epilogue);
+}
+
+/**
+ * The C entry points, so summa() picks up whatever backs local_mm()
+ **/
+inline void local(int m, int n, int k, float alpha, const float *A, int lda,
+    const float *B, int ldb, float beta, float *C, int ldc) {
+  local_mm_f(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+inline void local(int m, int n, int k, double alpha, const double *A,
+    int lda, const double *B, int ldb, double beta, double *C, int ldc) {
+  local_mm(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+inline void local(int m, int n, int k, std::complex<float> alpha,
+    const std::complex<float> *A, int lda, const std::complex<float> *B,
+    int ldb, std::complex<float> beta, std::complex<float> *C, int ldc) {
+  local_mm_c(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+inline void local(int m, int n, int k, std::complex<double> alpha,
+    const std::complex<double> *A, int lda, const std::complex<double> *B,
+    int ldb, std::complex<double> beta, std::complex<double> *C, int ldc) {
+  local_mm_z(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+/**
+ * local() followed by an epilogue, fused for double
+ **/
+inline void local(int m, int n, int k, double alpha, const double *A,
+    int lda, const double *B, int ldb, double beta, double *C, int ldc,
+    const mm_epilogue_t *epilogue) {
+  local_mm_epilogue(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, epilogue);
+}
+
+template <typename T>
+inline void local(int m, int n, int k, T alpha, const T *A, int lda,
+    const T *B, int ldb, T beta, T *C, int ldc,
+    const mm_epilogue_t *epilogue) {
+  assert(epilogue == NULL);
+  local(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+#define MM_TRI_BLOCK 64 /*!< Diagonal block of trmm() and syrk() */
+
+/**
+ * Triangular multiply, C = alpha * L * B + beta * C
+ *
+ *  L is the lower triangle of the m by m matrix A, whose strictly
+ *  upper triangle is not referenced; B and C are m by n. Row block
+ *  [r0, r1) of C needs only columns [0, r1) of A: one local() call for
+ *  the part left of the diagonal block and one for the diagonal block,
+ *  copied with its upper triangle zeroed, so about half the flops of a
+ *  full multiply are done.
+ **/
+template <typename T>
+void trmm(int m, int n, T alpha, const T *A, int lda, const T *B, int ldb,
+    T beta, T *C, int ldc) {
+
+  int r0, i, j;
+  T *diag = (T *) malloc(sizeof(T) * MM_TRI_BLOCK * MM_TRI_BLOCK);
+
+  assert(diag != NULL);
+
+  for (r0 = 0; r0 < m; r0 += MM_TRI_BLOCK) {
+    int rb = (m - r0 < MM_TRI_BLOCK) ? m - r0 : MM_TRI_BLOCK;
+
+    for (j = 0; j < rb; j++) {
+      for (i = 0; i < rb; i++) {
+        diag[j * rb + i] = (i >= j) ? A[(long) (r0 + j) * lda + r0 + i] : T(0);
+      }
+    }
+
+    local(rb, n, rb, alpha, diag, rb, B + r0, ldb, beta, C + r0, ldc);
+    if (r0 > 0) {
+      local(rb, n, r0, alpha, A + r0, lda, B, ldb, T(1), C + r0, ldc);
+    }
+  } /* r0 */
+
+  free(diag);
+}
+
+/**
+ * Symmetric rank-k update, C = alpha * A * A^T + beta * C, on the
+ *  lower triangle of the n by n matrix C
+ *
+ *  A is n by k. A^T is formed once, so each column block of C below
+ *  the diagonal block is one local() call; the diagonal block goes
+ *  through a scratch tile and only its lower triangle is written. The
+ *  strictly upper triangle of C is neither read nor written.
+ **/
+template <typename T>
+void syrk(int n, int k, T alpha, const T *A, int lda, T beta, T *C,
+    int ldc) {
+
+  int c0, i, j, p;
+  T *At, *diag;
+
+  if (n == 0) {
+    return;
+  }
+
+  /* No product to add: the lower triangle becomes beta * C */
+  if (k == 0) {
+    for (j = 0; j < n; j++) {
+      for (i = j; i < n; i++) {
+        T &c = C[(long) j * ldc + i];
+
+        c = (beta == T(0)) ? T(0) : beta * c;
+      }
+    }
+    return;
+  }
+
+  At = (T *) malloc(sizeof(T) * k * n);
+  diag = (T *) malloc(sizeof(T) * MM_TRI_BLOCK * MM_TRI_BLOCK);
+  assert(At != NULL && diag != NULL);
+
+  for (j = 0; j < n; j++) {
+    for (p = 0; p < k; p++) {
+      At[(long) j * k + p] = A[(long) p * lda + j];
+    }
+  }
+
+  for (c0 = 0; c0 < n; c0 += MM_TRI_BLOCK) {
+    int cb = (n - c0 < MM_TRI_BLOCK) ? n - c0 : MM_TRI_BLOCK;
+    int below = n - c0 - cb;
+
+    local(cb, cb, k, alpha, A + c0, lda, At + (long) c0 * k, k, T(0), diag,
+        cb);
+    for (j = 0; j < cb; j++) {
+      for (i = j; i < cb; i++) {
+        update(C[(long) (c0 + j) * ldc + c0 + i], diag[j * cb + i], T(1),
+            beta);
+      }
+    }
+
+    if (below > 0) {
+      local(below, cb, k, alpha, A + c0 + cb, lda, At + (long) c0 * k, k,
+          beta, C + (long) c0 * ldc + c0 + cb, ldc);
+    }
+  } /* c0 */
+
+  free(At);
+  free(diag);
+}
+
+/**
+ * Complex product on planar storage, P = A * B
+ *
+ *  A = Ar + i Ai is m by k, B = Br + i Bi is k by n, and the real and
+ *  imaginary planes of P are m by n with leading dimension m. The
+ *  product is made of real local() calls. MM_COMPLEX_4M takes four:
+ *  Pr = Ar Br - Ai Bi and Pi = Ar Bi + Ai Br. MM_COMPLEX_3M takes
+ *  three, T1 = Ar Br, T2 = Ai Bi and T3 = (Ar + Ai)(Br + Bi), then
+ *  Pr = T1 - T2 and Pi = T3 - T1 - T2: a quarter fewer multiplies
+ *  for O(mk + kn + mn) additions, with a larger rounding error in Pi
+ *  when the real and imaginary parts differ much in size.
+ **/
+template <typename R>
+void complex_product(int algorithm, int m, int n, int k, const R *Ar,
+    const R *Ai, int lda, const R *Br, const R *Bi, int ldb, R *Pr, R *Pi) {
+
+  int i, j;
+  R *sumA, *sumB, *T2;
+
+  if (k == 0) {
+    for (i = 0; i < m * n; i++) {
+      Pr[i] = Pi[i] = R(0);
+    }
+    return;
+  }
+
+  if (algorithm == MM_COMPLEX_4M) {
+    local(m, n, k, R(1), Ar, lda, Br, ldb, R(0), Pr, m);
+    local(m, n, k, R(-1), Ai, lda, Bi, ldb, R(1), Pr, m);
+    local(m, n, k, R(1), Ar, lda, Bi, ldb, R(0), Pi, m);
+    local(m, n, k, R(1), Ai, lda, Br, ldb, R(1), Pi, m);
+    return;
+  }
+
+  sumA = (R *) mm_alloc(m, k, sizeof(R));
+  sumB = (R *) mm_alloc(k, n, sizeof(R));
+  T2 = (R *) mm_alloc(m, n, sizeof(R));
+  assert(sumA != NULL && sumB != NULL && T2 != NULL);
+
+  for (j = 0; j < k; j++) {
+    for (i = 0; i < m; i++) {
+      sumA[(long) j * m + i] = Ar[(long) j * lda + i] + Ai[(long) j * lda + i];
+    }
+  }
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < k; i++) {
+      sumB[(long) j * k + i] = Br[(long) j * ldb + i] + Bi[(long) j * ldb + i];
+    }
+  }
+
+  local(m, n, k, R(1), Ar, lda, Br, ldb, R(0), Pr, m);
+  local(m, n, k, R(1), Ai, lda, Bi, ldb, R(0), T2, m);
+  local(m, n, k, R(1), sumA, m, sumB, k, R(0), Pi, m);
+
+  for (i = 0; i < m * n; i++) {
+    R t1 = Pr[i];
+
+    Pr[i] = t1 - T2[i];
+    Pi[i] -= t1 + T2[i];
+  }
+
+  free(sumA);
+  free(sumB);
+  free(T2);
+}
+
+/**
+ * Complex multiply on planar storage, C = alpha * A * B + beta * C
+ *
+ *  Arguments as in complex_product(), with C = Cr + i Ci of leading
+ *  dimension ldc. The C += A*B of summa_zp() under MM_COMPLEX_4M
+ *  accumulates straight into Cr and Ci; anything else forms the
+ *  product in scratch planes first.
+ **/
+template <typename R>
+void gemm_planar(int algorithm, int m, int n, int k, std::complex<R> alpha,
+    const R *Ar, const R *Ai, int lda, const R *Br, const R *Bi, int ldb,
+    std::complex<R> beta, R *Cr, R *Ci, int ldc) {
+
+  int i, j;
+  R *Pr, *Pi;
+
+  assert(lda >= m);
+  assert(ldb >= k);
+  assert(ldc >= m);
+
+  if (m == 0 || n == 0) {
+    return;
+  }
+
+  if (algorithm == MM_COMPLEX_4M && alpha == std::complex<R>(1)
+      && beta == std::complex<R>(1)) {
+    local(m, n, k, R(1), Ar, lda, Br, ldb, R(1), Cr, ldc);
+    local(m, n, k, R(-1), Ai, lda, Bi, ldb, R(1), Cr, ldc);
+    local(m, n, k, R(1), Ar, lda, Bi, ldb, R(1), Ci, ldc);
+    local(m, n, k, R(1), Ai, lda, Br, ldb, R(1), Ci, ldc);
+    return;
+  }
+
+  Pr = (R *) mm_alloc(m, 2 * n, sizeof(R));
+  assert(Pr != NULL);
+  Pi = Pr + (long) m * n;
+
+  complex_product<R>(algorithm, m, n, k, Ar, Ai, lda, Br, Bi, ldb, Pr, Pi);
+
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < m; i++) {
+      long c = (long) j * ldc + i;
+      std::complex<R> value(0);
+
+      if (beta != std::complex<R>(0)) {
+        value = std::complex<R>(Cr[c], Ci[c]);
+      }
+      update(value, std::complex<R>(Pr[(long) j * m + i], Pi[(long) j * m + i]),
+          alpha, beta);
+      Cr[c] = value.real();
+      Ci[c] = value.imag();
+    }
+  }
+
+  free(Pr);
+}
+
+/**
+ * 3M complex multiply on interleaved storage, C = alpha * A * B + beta * C
+ *
+ *  Splits A and B into planes, forms the product with complex_product()
+ *  and applies it to C, arguments as in local_mm_z().
+ **/
+template <typename R>
+void gemm_3m(int m, int n, int k, std::complex<R> alpha,
+    const std::complex<R> *A, int lda, const std::complex<R> *B, int ldb,
+    std::complex<R> beta, std::complex<R> *C, int ldc) {
+
+  int i, j;
+  R *Ar, *Br, *Pr;
+
+  assert(lda >= m);
+  assert(ldb >= k);
+  assert(ldc >= m);
+
+  if (m == 0 || n == 0) {
+    return;
+  }
+
+  Ar = (R *) mm_alloc(m, 2 * k, sizeof(R));
+  Br = (R *) mm_alloc(k, 2 * n, sizeof(R));
+  Pr = (R *) mm_alloc(m, 2 * n, sizeof(R));
+  assert(Ar != NULL && Br != NULL && Pr != NULL);
+
+  for (j = 0; j < k; j++) {
+    for (i = 0; i < m; i++) {
+      Ar[(long) j * m + i] = A[(long) j * lda + i].real();
+      Ar[(long) (k + j) * m + i] = A[(long) j * lda + i].imag();
+    }
+  }
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < k; i++) {
+      Br[(long) j * k + i] = B[(long) j * ldb + i].real();
+      Br[(long) (n + j) * k + i] = B[(long) j * ldb + i].imag();
+    }
+  }
+
+  complex_product<R>(MM_COMPLEX_3M, m, n, k, Ar, Ar + (long) m * k, m, Br,
+      Br + (long) k * n, k, Pr, Pr + (long) m * n);
+
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < m; i++) {
+      update(C[(long) j * ldc + i], std::complex<R>(Pr[(long) j * m + i],
+          Pr[(long) (n + j) * m + i]), alpha, beta);
+    }
+  }
+
+  free(Ar);
+  free(Br);
+  free(Pr);
+}
+
+/**
+ * Distributed Matrix Multiply using the SUMMA algorithm
+ *  Computes C = A*B + C, arguments as in summa()
+ *
+ *  A non-NULL epilogue is fused into the multiply of the last panel.
+ **/
+template <typename T>
+void summa(int m, int n, int k, T *Ablock, T *Bblock, T *Cblock,
+    int procGridX, int procGridY, int pb,
+    const mm_epilogue_t *epilogue = NULL) {
+
+  int i;
+  int rows = m / procGridX;
+  int cols = n / procGridY;
+  double t_start = 0.0;
+  T *bufferA[2];
+  T *bufferB[2];
+  summa_grid_t grid;
+
+  assert(k % pb == 0);
+
+  if (summa_trace_enabled) {
+    summa_trace_call(m, n, k, procGridX, procGridY, pb);
+  }
+
+  summa_grid_create(procGridX, procGridY, &grid);
+
+  /* Two buffers per panel, so panel i + 1 can arrive while the
+   * ring broadcast engine still forwards panel i */
+  for (i = 0; i < 2; i++) {
+    bufferA[i] = (T *) mm_alloc(rows, pb, sizeof(T));
+    bufferB[i] = (T *) mm_alloc(pb, cols, sizeof(T));
+    assert(bufferA[i] != NULL && bufferB[i] != NULL);
+  }
+
+  for (i = 0; i < k / pb; i++) {
+    T *panelA = bufferA[i % 2];
+    T *panelB = bufferB[i % 2];
+
+    summa_bcast_panel_A(&grid, rows, k / procGridY, i * pb, pb, Ablock, rows,
+        panelA, rows, traits<T>::mpi_type(), i);
+    summa_bcast_panel_B(&grid, cols, k / procGridX, i * pb, pb, Bblock,
+        k / procGridX, panelB, pb, traits<T>::mpi_type(), i);
+
+    /* Multiply */
+    if (summa_trace_enabled) {
+      t_start = MPI_Wtime();
+    }
+
+    if (epilogue != NULL && i == k / pb - 1) {
+      local(rows, cols, pb, T(1), panelA, rows, panelB, pb, T(1), Cblock,
+          rows, epilogue);
+    } else {
+      local(rows, cols, pb, T(1), panelA, rows, panelB, pb, T(1), Cblock,
+          rows);
+    }
+
+    if (summa_trace_enabled) {
+      summa_trace_compute(i, t_start, MPI_Wtime(),
+          (double) traits<T>::FLOPS * rows * (double) cols * pb);
+    }
+  } /* i */
+
+  if (epilogue != NULL && k == 0) {
+    local(rows, cols, 0, T(1), bufferA[0], rows, bufferB[0], 1, T(1), Cblock,
+        rows, epilogue);
+  }
+
+  /* Completes the sends still reading from the buffers */
+  summa_grid_free(&grid);
+
+  for (i = 0; i < 2; i++) {
+    free(bufferA[i]);
+    free(bufferB[i]);
+  }
+}
+
+} /* namespace mm */
+
+#endif /* MM_CORE_HPP */
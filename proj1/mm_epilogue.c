@@ -0,0 +1,117 @@
+/**
+ *  \file mm_epilogue.c
+ *  \brief Elementwise epilogues fused into local_mm() and summa()
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "mm_epilogue.h"
+
+/**
+ * Appends an operation and returns it
+ **/
+static mm_epilogue_op_t *append(mm_epilogue_t *epilogue, int op) {
+
+  mm_epilogue_op_t *entry;
+
+  assert(epilogue->count < MM_EPILOGUE_MAX);
+  entry = &epilogue->ops[epilogue->count++];
+  entry->op = op;
+  entry->a = 0.0;
+  entry->b = 0.0;
+  entry->vector = NULL;
+  entry->fn = NULL;
+  entry->arg = NULL;
+  return entry;
+}
+
+void mm_epilogue_init(mm_epilogue_t *epilogue) {
+  epilogue->count = 0;
+}
+
+void mm_epilogue_scale(mm_epilogue_t *epilogue, double scale) {
+  append(epilogue, MM_EPILOGUE_SCALE)->a = scale;
+}
+
+void mm_epilogue_bias_rows(mm_epilogue_t *epilogue, const double *bias) {
+  append(epilogue, MM_EPILOGUE_BIAS_ROW)->vector = bias;
+}
+
+void mm_epilogue_bias_cols(mm_epilogue_t *epilogue, const double *bias) {
+  append(epilogue, MM_EPILOGUE_BIAS_COL)->vector = bias;
+}
+
+void mm_epilogue_clamp(mm_epilogue_t *epilogue, double low, double high) {
+
+  mm_epilogue_op_t *entry = append(epilogue, MM_EPILOGUE_CLAMP);
+
+  assert(low <= high);
+  entry->a = low;
+  entry->b = high;
+}
+
+void mm_epilogue_relu(mm_epilogue_t *epilogue) {
+  append(epilogue, MM_EPILOGUE_RELU);
+}
+
+void mm_epilogue_callback(mm_epilogue_t *epilogue, mm_epilogue_fn fn,
+    void *arg) {
+
+  mm_epilogue_op_t *entry = append(epilogue, MM_EPILOGUE_CALLBACK);
+
+  entry->fn = fn;
+  entry->arg = arg;
+}
+
+/**
+ * Applies each operation to the whole tile before the next; the tile
+ *  is a few kilobytes, so every pass after the first hits L1
+ **/
+void mm_epilogue_apply(const mm_epilogue_t *epilogue, int row, int col,
+    int rows, int cols, double *C, int ldc) {
+
+  int e, i, j;
+
+  if (epilogue == NULL) {
+    return;
+  }
+
+  for (e = 0; e < epilogue->count; e++) {
+    const mm_epilogue_op_t *op = &epilogue->ops[e];
+
+    if (op->op == MM_EPILOGUE_CALLBACK) {
+      op->fn(row, col, rows, cols, C, ldc, op->arg);
+      continue;
+    }
+
+    for (j = 0; j < cols; j++) {
+      double *c = C + (size_t) j * ldc;
+
+      switch (op->op) {
+        case MM_EPILOGUE_SCALE:
+          for (i = 0; i < rows; i++)
+            c[i] *= op->a;
+          break;
+        case MM_EPILOGUE_BIAS_ROW:
+          for (i = 0; i < rows; i++)
+            c[i] += op->vector[row + i];
+          break;
+        case MM_EPILOGUE_BIAS_COL:
+          for (i = 0; i < rows; i++)
+            c[i] += op->vector[col + j];
+          break;
+        case MM_EPILOGUE_CLAMP:
+          for (i = 0; i < rows; i++)
+            c[i] = (c[i] < op->a) ? op->a : ((c[i] > op->b) ? op->b : c[i]);
+          break;
+        case MM_EPILOGUE_RELU:
+          for (i = 0; i < rows; i++)
+            c[i] = (c[i] > 0.0) ? c[i] : 0.0;
+          break;
+        default:
+          assert(0);
+      }
+    } /* j */
+  } /* e */
+}
@@ -0,0 +1,112 @@
+/**
+ *  \file mm_epilogue.h
+ *  \brief Elementwise epilogues fused into local_mm() and summa()
+ *
+ *  An mm_epilogue_t is a short list of elementwise operations on C:
+ *  scaling, a bias per row or per column, clamping, ReLU, or a user
+ *  callback. local_mm_epilogue() applies it to each tile of C right
+ *  after the tile's last update, while the tile is still in cache,
+ *  instead of in separate passes over the whole matrix afterwards.
+ *  summa_epilogue() does the same in the multiply of its last panel.
+ *
+ *  Operations run in the order they were added. Row and column
+ *  indices are those of the C passed in (for summa_epilogue(), of
+ *  Cblock), so a bias has one entry per row or column of that C.
+ */
+
+#ifndef MM_EPILOGUE_H
+#define MM_EPILOGUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MM_EPILOGUE_MAX 8 /*!< Operations in one epilogue */
+
+#define MM_EPILOGUE_SCALE 0 /*!< C = a * C */
+#define MM_EPILOGUE_BIAS_ROW 1 /*!< C(i, j) += vector[i] */
+#define MM_EPILOGUE_BIAS_COL 2 /*!< C(i, j) += vector[j] */
+#define MM_EPILOGUE_CLAMP 3 /*!< C = min(max(C, a), b) */
+#define MM_EPILOGUE_RELU 4 /*!< C = max(C, 0) */
+#define MM_EPILOGUE_CALLBACK 5 /*!< fn on the tile */
+
+/**
+ * User operation on the rows by cols tile of C at (row, col); C
+ *  points at element (row, col). Called from several pool threads at
+ *  once, on disjoint tiles.
+ **/
+typedef void (*mm_epilogue_fn)(int row, int col, int rows, int cols,
+    double *C, int ldc, void *arg);
+
+typedef struct {
+  int op; /* MM_EPILOGUE_* */
+  double a, b;
+  const double *vector;
+  mm_epilogue_fn fn;
+  void *arg;
+} mm_epilogue_op_t;
+
+typedef struct {
+  int count;
+  mm_epilogue_op_t ops[MM_EPILOGUE_MAX];
+} mm_epilogue_t;
+
+/**
+ * Empties an epilogue
+ **/
+void mm_epilogue_init(mm_epilogue_t *epilogue);
+
+/**
+ * Appends C = scale * C
+ **/
+void mm_epilogue_scale(mm_epilogue_t *epilogue, double scale);
+
+/**
+ * Appends C(i, j) += bias[i]
+ **/
+void mm_epilogue_bias_rows(mm_epilogue_t *epilogue, const double *bias);
+
+/**
+ * Appends C(i, j) += bias[j]
+ **/
+void mm_epilogue_bias_cols(mm_epilogue_t *epilogue, const double *bias);
+
+/**
+ * Appends C = min(max(C, low), high)
+ **/
+void mm_epilogue_clamp(mm_epilogue_t *epilogue, double low, double high);
+
+/**
+ * Appends C = max(C, 0)
+ **/
+void mm_epilogue_relu(mm_epilogue_t *epilogue);
+
+/**
+ * Appends a call of fn(row, col, rows, cols, C, ldc, arg) per tile
+ **/
+void mm_epilogue_callback(mm_epilogue_t *epilogue, mm_epilogue_fn fn,
+    void *arg);
+
+/**
+ * Applies the epilogue to the rows by cols tile of C at (row, col),
+ *  C pointing at that element; a NULL epilogue does nothing
+ **/
+void mm_epilogue_apply(const mm_epilogue_t *epilogue, int row, int col,
+    int rows, int cols, double *C, int ldc);
+
+/**
+ * C = epilogue(alpha * A * B + beta * C), arguments as in local_mm()
+ *
+ *  The epilogue is applied to each tile of C as soon as its last
+ *  update is done.
+ **/
+void local_mm_epilogue(const int m, const int n, const int k,
+    const double alpha, const double *A, const int lda, const double *B,
+    const int ldb, const double beta, double *C, const int ldc,
+    const mm_epilogue_t *epilogue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MM_EPILOGUE_H */
@@ -0,0 +1,474 @@
+/**
+ *  \file mm_jit.c
+ *  \brief Run-time generated kernels for small, repeated local_mm() shapes
+ *
+ *  A kernel, called as f(A, B, C, alphaBeta) under the System V ABI:
+ *
+ *    ymm15 = alpha, ymm14 = beta, r10 = B, r11 = C
+ *    for each block of 4 columns (counter at [rsp - 8], the red zone)
+ *      rcx = A, r9 = r11
+ *      for each block of 8 rows (counter esi), then 4 rows if m % 8
+ *        ymm0-7 = 0
+ *        rax = rcx, r8 = r10; k times (counter edx):
+ *          ymm8-9 = rax[0..7], ymm10 = r8[c * ldb] for each c,
+ *          ymm(2 * c + h) += ymm(8 + h) * ymm10
+ *          rax += lda, r8 += 1
+ *        r9[c * ldc + 4 * h] = alpha * ymm(2 * c + h) + beta * r9[...]
+ *        rcx += 8, r9 += 8
+ *      r10 += 4 * ldb, r11 += 4 * ldc
+ *    then the last n % 4 columns the same way
+ *
+ *  The function only uses caller-saved registers, so it needs no
+ *  prologue. Code is written to a buffer, then copied to its own
+ *  pages, which are made executable and no longer writable.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "mm_jit.h"
+
+#define ALPHA_ONE 0
+#define ALPHA_ANY 1
+#define BETA_ZERO 0
+#define BETA_ONE 1
+#define BETA_ANY 2
+
+typedef struct {
+  int m, n, k, lda, ldb, ldc, alpha, beta;
+} jit_key_t;
+
+typedef struct {
+  jit_key_t key;
+  mm_jit_kernel_t kernel; /* NULL until the shape is seen again */
+} jit_entry_t;
+
+static jit_entry_t cache[MM_JIT_CACHE];
+static int entries = 0;
+static int kernels = 0;
+static int enabled = -1; /*!< -1 until set or read from MM_JIT */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+#if defined(__x86_64__)
+
+#define RAX 0
+#define RCX 1
+#define RDX 2
+#define RSI 6
+#define RDI 7
+#define R8 8
+#define R9 9
+#define R10 10
+#define R11 11
+
+#define ALPHA 15 /*!< ymm holding alpha */
+#define BETA 14 /*!< ymm holding beta */
+#define PANEL_A 8 /*!< ymm8, ymm9: 8 rows of a column of A */
+#define ELEMENT_B 10 /*!< ymm10: one element of B */
+
+typedef struct {
+  unsigned char *code;
+  size_t size, capacity;
+} emitter_t;
+
+static void byte(emitter_t *e, int b) {
+
+  if (e->size == e->capacity) {
+    e->capacity = (e->capacity == 0) ? 4096 : 2 * e->capacity;
+    e->code = (unsigned char *) realloc(e->code, e->capacity);
+    assert(e->code != NULL);
+  }
+  e->code[e->size++] = (unsigned char) b;
+}
+
+static void dword(emitter_t *e, int32_t v) {
+
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    byte(e, (v >> (8 * i)) & 0xFF);
+  }
+}
+
+/**
+ * Three-byte VEX prefix and opcode of a 256-bit, 66-prefixed
+ *  instruction; map 1 is 0F, map 2 is 0F38
+ **/
+static void vex(emitter_t *e, int map, int w, int vvvv, int reg, int rm,
+    int opcode) {
+  byte(e, 0xC4);
+  byte(e, ((~reg >> 3 & 1) << 7) | (1 << 6) | ((~rm >> 3 & 1) << 5) | map);
+  byte(e, (w << 7) | ((~vvvv & 15) << 3) | (1 << 2) | 1);
+  byte(e, opcode);
+}
+
+/** ModRM for two registers */
+static void modrm_reg(emitter_t *e, int reg, int rm) {
+  byte(e, 0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+/** ModRM for [base + disp32]; base is never rsp or r12 */
+static void modrm_mem(emitter_t *e, int reg, int base, int32_t disp) {
+  byte(e, 0x80 | (reg & 7) << 3 | (base & 7));
+  dword(e, disp);
+}
+
+/** vmovupd ymm, [base + disp] */
+static void load(emitter_t *e, int y, int base, int32_t disp) {
+  vex(e, 1, 0, 0, y, base, 0x10);
+  modrm_mem(e, y, base, disp);
+}
+
+/** vmovupd [base + disp], ymm */
+static void store(emitter_t *e, int base, int32_t disp, int y) {
+  vex(e, 1, 0, 0, y, base, 0x11);
+  modrm_mem(e, y, base, disp);
+}
+
+/** vbroadcastsd ymm, [base + disp] */
+static void broadcast(emitter_t *e, int y, int base, int32_t disp) {
+  vex(e, 2, 0, 0, y, base, 0x19);
+  modrm_mem(e, y, base, disp);
+}
+
+/** vfmadd231pd d, s, t: d += s * t */
+static void fma_reg(emitter_t *e, int d, int s, int t) {
+  vex(e, 2, 1, s, d, t, 0xB8);
+  modrm_reg(e, d, t);
+}
+
+/** vfmadd231pd d, s, [base + disp] */
+static void fma_mem(emitter_t *e, int d, int s, int base, int32_t disp) {
+  vex(e, 2, 1, s, d, base, 0xB8);
+  modrm_mem(e, d, base, disp);
+}
+
+/** vxorpd y, y, y */
+static void zero(emitter_t *e, int y) {
+  vex(e, 1, 0, y, y, y, 0x57);
+  modrm_reg(e, y, y);
+}
+
+/** vmulpd d, d, s */
+static void mul(emitter_t *e, int d, int s) {
+  vex(e, 1, 0, d, d, s, 0x59);
+  modrm_reg(e, d, s);
+}
+
+/** vaddpd d, d, [base + disp] */
+static void add_mem(emitter_t *e, int d, int base, int32_t disp) {
+  vex(e, 1, 0, d, d, base, 0x58);
+  modrm_mem(e, d, base, disp);
+}
+
+/** mov dst, src on 64-bit registers */
+static void mov(emitter_t *e, int dst, int src) {
+  byte(e, 0x48 | (src >> 3) << 2 | (dst >> 3));
+  byte(e, 0x89);
+  modrm_reg(e, src, dst);
+}
+
+/** add r, imm32 on a 64-bit register */
+static void add_imm(emitter_t *e, int r, int32_t imm) {
+  byte(e, 0x48 | (r >> 3));
+  byte(e, 0x81);
+  modrm_reg(e, 0, r);
+  dword(e, imm);
+}
+
+/** mov r32, imm32 */
+static void set_counter(emitter_t *e, int r, int32_t imm) {
+  if (r >= 8) {
+    byte(e, 0x41);
+  }
+  byte(e, 0xB8 + (r & 7));
+  dword(e, imm);
+}
+
+/** dec r32 */
+static void decrement(emitter_t *e, int r) {
+  if (r >= 8) {
+    byte(e, 0x41);
+  }
+  byte(e, 0xFF);
+  modrm_reg(e, 1, r);
+}
+
+/** jnz to the offset top */
+static void loop_back(emitter_t *e, size_t top) {
+  byte(e, 0x0F);
+  byte(e, 0x85);
+  dword(e, (int32_t) ((long) top - (long) (e->size + 4)));
+}
+
+/**
+ * One rows by cols tile of C (rows 4 or 8, cols 1 to 4) at r9, from A
+ *  at rcx and B at r10
+ **/
+static void emit_tile(emitter_t *e, const jit_key_t *key, int rows, int cols) {
+
+  int c, h, halves = rows / 4;
+  size_t top;
+
+  for (c = 0; c < cols; c++)
+    for (h = 0; h < halves; h++)
+      zero(e, 2 * c + h);
+
+  mov(e, RAX, RCX);
+  mov(e, R8, R10);
+  set_counter(e, RDX, key->k);
+  top = e->size;
+  for (h = 0; h < halves; h++)
+    load(e, PANEL_A + h, RAX, 32 * h);
+  for (c = 0; c < cols; c++) {
+    broadcast(e, ELEMENT_B, R8, c * key->ldb * 8);
+    for (h = 0; h < halves; h++)
+      fma_reg(e, 2 * c + h, PANEL_A + h, ELEMENT_B);
+  }
+  add_imm(e, RAX, key->lda * 8);
+  add_imm(e, R8, 8);
+  decrement(e, RDX);
+  loop_back(e, top);
+
+  for (c = 0; c < cols; c++) {
+    for (h = 0; h < halves; h++) {
+      int acc = 2 * c + h;
+      int32_t disp = (c * key->ldc + 4 * h) * 8;
+
+      if (key->alpha == ALPHA_ANY)
+        mul(e, acc, ALPHA);
+      if (key->beta == BETA_ONE)
+        add_mem(e, acc, R9, disp);
+      else if (key->beta == BETA_ANY)
+        fma_mem(e, acc, BETA, R9, disp);
+      store(e, R9, disp, acc);
+    }
+  }
+}
+
+/**
+ * All the rows of cols columns of C, starting at r11 and r10
+ **/
+static void emit_columns(emitter_t *e, const jit_key_t *key, int cols) {
+
+  size_t top;
+
+  mov(e, RCX, RDI);
+  mov(e, R9, R11);
+  if (key->m / 8 > 0) {
+    set_counter(e, RSI, key->m / 8);
+    top = e->size;
+    emit_tile(e, key, 8, cols);
+    add_imm(e, RCX, 64);
+    add_imm(e, R9, 64);
+    decrement(e, RSI);
+    loop_back(e, top);
+  }
+  if (key->m % 8 != 0) {
+    emit_tile(e, key, 4, cols);
+  }
+}
+
+static void emit_kernel(emitter_t *e, const jit_key_t *key) {
+
+  size_t top;
+
+  broadcast(e, ALPHA, RCX, 0);
+  broadcast(e, BETA, RCX, 8);
+  mov(e, R10, RSI);
+  mov(e, R11, RDX);
+
+  if (key->n / 4 > 0) {
+    /* mov qword [rsp - 8], n / 4 */
+    byte(e, 0x48); byte(e, 0xC7); byte(e, 0x44); byte(e, 0x24); byte(e, 0xF8);
+    dword(e, key->n / 4);
+    top = e->size;
+    emit_columns(e, key, 4);
+    add_imm(e, R10, 4 * key->ldb * 8);
+    add_imm(e, R11, 4 * key->ldc * 8);
+    /* dec qword [rsp - 8] */
+    byte(e, 0x48); byte(e, 0xFF); byte(e, 0x4C); byte(e, 0x24); byte(e, 0xF8);
+    loop_back(e, top);
+  }
+  if (key->n % 4 != 0) {
+    emit_columns(e, key, key->n % 4);
+  }
+
+  /* vzeroupper; ret */
+  byte(e, 0xC5); byte(e, 0xF8); byte(e, 0x77);
+  byte(e, 0xC3);
+}
+
+/**
+ * Generates the kernel into new executable pages
+ **/
+static mm_jit_kernel_t generate(const jit_key_t *key) {
+
+  emitter_t e = { NULL, 0, 0 };
+  size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  size_t bytes;
+  void *code;
+
+  emit_kernel(&e, key);
+  bytes = (e.size + page - 1) / page * page;
+  code = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+      -1, 0);
+  if (code == MAP_FAILED) {
+    free(e.code);
+    return NULL;
+  }
+  memcpy(code, e.code, e.size);
+  free(e.code);
+  if (mprotect(code, bytes, PROT_READ | PROT_EXEC) != 0) {
+    munmap(code, bytes);
+    return NULL;
+  }
+
+  kernels++;
+  return (mm_jit_kernel_t) code;
+}
+
+static int supported(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#else
+
+static mm_jit_kernel_t generate(const jit_key_t *key) {
+  (void) key;
+  return NULL;
+}
+
+static int supported(void) {
+  return 0;
+}
+
+#endif /* __x86_64__ */
+
+int mm_jit_enabled(void) {
+
+  if (enabled < 0) {
+    const char *env = getenv("MM_JIT");
+
+    enabled = supported() && !(env != NULL && atoi(env) == 0);
+  }
+  return enabled;
+}
+
+void mm_jit_set_enabled(int on) {
+  enabled = on && supported();
+}
+
+int mm_jit_kernels(void) {
+  return kernels;
+}
+
+/**
+ * Fills key; returns 0 if the shape cannot be generated at all
+ **/
+static int make_key(int m, int n, int k, int lda, int ldb, int ldc,
+    double alpha, double beta, jit_key_t *key) {
+
+  /* Strides become 32-bit immediates; k = 0 has no product to
+   * generate and is left to mm::gemm(), which only scales C */
+  if (m <= 0 || n <= 0 || k <= 0 || m % 4 != 0
+      || lda > (1 << 24) || ldb > (1 << 24) || ldc > (1 << 24)) {
+    return 0;
+  }
+
+  memset(key, 0, sizeof(*key));
+  key->m = m;
+  key->n = n;
+  key->k = k;
+  key->lda = lda;
+  key->ldb = ldb;
+  key->ldc = ldc;
+  key->alpha = (alpha == 1.0) ? ALPHA_ONE : ALPHA_ANY;
+  key->beta = (beta == 0.0) ? BETA_ZERO : ((beta == 1.0) ? BETA_ONE : BETA_ANY);
+  return 1;
+}
+
+/**
+ * Finds the entry for key, adding it if there is room; NULL otherwise
+ **/
+static jit_entry_t *find(const jit_key_t *key, int *added) {
+
+  int i;
+
+  *added = 0;
+  for (i = 0; i < entries; i++) {
+    if (memcmp(&cache[i].key, key, sizeof(*key)) == 0) {
+      return &cache[i];
+    }
+  }
+  if (entries == MM_JIT_CACHE) {
+    return NULL;
+  }
+  cache[entries].key = *key;
+  cache[entries].kernel = NULL;
+  *added = 1;
+  return &cache[entries++];
+}
+
+mm_jit_kernel_t mm_jit_lookup(int m, int n, int k, int lda, int ldb, int ldc,
+    double alpha, double beta) {
+
+  jit_key_t key;
+  jit_entry_t *entry;
+  mm_jit_kernel_t kernel = NULL;
+  int added;
+  int small = (m <= MM_JIT_SMALL && n <= MM_JIT_SMALL && k <= MM_JIT_SMALL);
+  int panel = (k <= MM_JIT_MAX_K && (long) m * n <= MM_JIT_MAX_MN);
+
+  if (!(small || panel) || !mm_jit_enabled()
+      || !make_key(m, n, k, lda, ldb, ldc, alpha, beta, &key)) {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&lock);
+  entry = find(&key, &added);
+  if (entry != NULL && !added) {
+    if (entry->kernel == NULL) {
+      entry->kernel = generate(&key);
+    }
+    kernel = entry->kernel;
+  }
+  pthread_mutex_unlock(&lock);
+  return kernel;
+}
+
+mm_jit_kernel_t mm_jit_compile(int m, int n, int k, int lda, int ldb,
+    int ldc, double alpha, double beta) {
+
+  jit_key_t key;
+  jit_entry_t *entry;
+  mm_jit_kernel_t kernel;
+  int added;
+
+  if (!mm_jit_enabled()
+      || !make_key(m, n, k, lda, ldb, ldc, alpha, beta, &key)) {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&lock);
+  entry = find(&key, &added);
+  if (entry != NULL && entry->kernel != NULL) {
+    kernel = entry->kernel;
+  } else {
+    kernel = generate(&key);
+    if (entry != NULL) {
+      entry->kernel = kernel;
+    }
+  }
+  pthread_mutex_unlock(&lock);
+  return kernel;
+}
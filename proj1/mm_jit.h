@@ -0,0 +1,77 @@
+/**
+ *  \file mm_jit.h
+ *  \brief Run-time generated kernels for small, repeated local_mm() shapes
+ *
+ *  SUMMA calls local_mm() with the same m, n, k and leading dimensions
+ *  on every panel, and those shapes are small. For such a shape the
+ *  JIT writes x86-64 AVX2/FMA machine code with every size, stride and
+ *  trip count built in as an immediate: 8 by 4 register tiles of C
+ *  (4 by 4 for the last rows when m is 4 more than a multiple of 8),
+ *  each accumulated over all of k in registers and written once, with
+ *  alpha and beta applied as the shape's class requires (alpha 1 or
+ *  not; beta 0, 1 or neither). A and B are read in place, unpacked.
+ *
+ *  Kernels are kept in a small cache keyed on the shape and class.
+ *  local_mm() asks mm_jit_lookup() first; a shape is compiled the
+ *  second time it is seen, so shapes that never repeat cost only the
+ *  lookup. A shape is eligible when m is a multiple of 4, k is not 0,
+ *  and either m, n and k are at most MM_JIT_SMALL or k is at most
+ *  MM_JIT_MAX_K and m * n at most MM_JIT_MAX_MN; past that, the packed
+ *  and threaded mm::gemm() is as fast or faster. MM_JIT=0 turns the
+ *  JIT off, as does a CPU without AVX2 and FMA or a build for another
+ *  architecture.
+ */
+
+#ifndef MM_JIT_H
+#define MM_JIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MM_JIT_SMALL 64 /*!< Any shape with m, n and k up to this */
+#define MM_JIT_MAX_K 32 /*!< A panel update with k up to this ... */
+#define MM_JIT_MAX_MN (128 * 128) /*!< ... and m * n up to this */
+#define MM_JIT_CACHE 64 /*!< Shapes remembered */
+
+/**
+ * A generated C = alpha * A * B + beta * C; alphaBeta holds alpha, beta
+ **/
+typedef void (*mm_jit_kernel_t)(const double *A, const double *B, double *C,
+    const double *alphaBeta);
+
+/**
+ * The kernel for this shape, or NULL if the shape is not eligible, the
+ *  JIT is off, or this is the first time the shape is seen
+ **/
+mm_jit_kernel_t mm_jit_lookup(int m, int n, int k, int lda, int ldb, int ldc,
+    double alpha, double beta);
+
+/**
+ * Generates (or finds) the kernel for this shape at once, whatever the
+ *  size; NULL if the JIT is off, m is not a multiple of 4 or k is 0
+ **/
+mm_jit_kernel_t mm_jit_compile(int m, int n, int k, int lda, int ldb,
+    int ldc, double alpha, double beta);
+
+/**
+ * Nonzero when kernels can be generated and are used, read from MM_JIT
+ *  on first use
+ **/
+int mm_jit_enabled(void);
+
+/**
+ * Turns the JIT on or off; on has no effect where it cannot run
+ **/
+void mm_jit_set_enabled(int enabled);
+
+/**
+ * Number of kernels generated so far
+ **/
+int mm_jit_kernels(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MM_JIT_H */
@@ -0,0 +1,369 @@
+/**
+ *  \file mm_numa.c
+ *  \brief NUMA-aware allocation and thread placement for Proj1
+ *
+ *  Talks to the kernel directly (mbind, madvise, sched_setaffinity)
+ *  and reads the topology from /sys, so it needs no libnuma.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <omp.h>
+
+#include "mm_numa.h"
+
+#define HUGE_PAGE_SIZE (2UL << 20) /*!< x86-64 transparent huge page */
+#define MAX_NODES 64 /*!< Nodes beyond this are ignored */
+
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+
+static int alloc_policy = -1; /*!< -1 until read from MM_ALLOC */
+static int affinity = -1; /*!< -1 until read from MM_AFFINITY */
+static int affinity_chosen = 0; /*!< Set by MM_AFFINITY or mm_set_affinity() */
+static int pinned_threads = 0; /*!< Team size of the last mm_affinity_apply() */
+
+static int num_cpus = 0; /*!< CPUs the process was allowed to run on at startup */
+static int cpu_order[CPU_SETSIZE]; /*!< The order in which threads take them */
+
+/**
+ * Parses a /sys cpu or node list ("0-3,8") into a set of ids,
+ *  returns the number of ids
+ **/
+static int read_list(const char *path, int *ids, int max) {
+
+  FILE *fp = fopen(path, "r");
+  int count = 0;
+  int first, last;
+
+  if (fp == NULL) {
+    return 0;
+  }
+
+  while (fscanf(fp, "%d", &first) == 1) {
+    last = first;
+    if (fscanf(fp, "-%d", &last) != 1) {
+      last = first;
+    }
+    for (; first <= last && count < max; first++) {
+      ids[count++] = first;
+    }
+    if (fgetc(fp) != ',') {
+      break;
+    }
+  }
+
+  fclose(fp);
+  return count;
+}
+
+/**
+ * Number of NUMA nodes with memory
+ **/
+int mm_numa_nodes(void) {
+
+  int ids[MAX_NODES];
+  int count = read_list("/sys/devices/system/node/has_memory", ids, MAX_NODES);
+
+  return (count > 0) ? count : 1;
+}
+
+/**
+ * NUMA node of a CPU, 0 when the topology is not exposed
+ **/
+static int cpu_node(int cpu) {
+
+  char path[128];
+  int node;
+
+  for (node = 0; node < MAX_NODES; node++) {
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu,
+        node);
+    if (access(path, F_OK) == 0) {
+      return node;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Selects the allocation policy of mm_alloc()
+ **/
+void mm_set_alloc_policy(int policy) {
+  alloc_policy = policy;
+}
+
+/**
+ * Returns the allocation policy, read from MM_ALLOC on first use
+ **/
+int mm_get_alloc_policy(void) {
+
+  if (alloc_policy < 0) {
+    const char *env = getenv("MM_ALLOC");
+
+    alloc_policy = MM_ALLOC_FIRST_TOUCH;
+    if (env != NULL && strstr(env, "interleave") != NULL) {
+      alloc_policy |= MM_ALLOC_INTERLEAVE;
+    }
+    if (env != NULL && strstr(env, "hugepage") != NULL) {
+      alloc_policy |= MM_ALLOC_HUGEPAGE;
+    }
+  }
+  return alloc_policy;
+}
+
+/**
+ * Spreads the pages of [addr, addr + length) over every node
+ **/
+static void interleave(void *addr, size_t length) {
+
+  int ids[MAX_NODES];
+  int count = read_list("/sys/devices/system/node/has_memory", ids, MAX_NODES);
+  unsigned long nodemask = 0;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    nodemask |= 1UL << ids[i];
+  }
+
+  /* A failed mbind leaves the pages to first touch */
+  if (count > 1) {
+    syscall(SYS_mbind, addr, length, MPOL_INTERLEAVE, &nodemask,
+        (unsigned long) MAX_NODES + 1, 0);
+  }
+}
+
+/**
+ * Allocates a rows by cols matrix of elemSize-byte elements under the
+ *  current policy
+ **/
+void *mm_alloc(int rows, int cols, size_t elemSize) {
+
+  int c;
+  int policy = mm_get_alloc_policy();
+  size_t colBytes = elemSize * rows;
+  size_t bytes = colBytes * cols;
+  size_t align = (size_t) sysconf(_SC_PAGESIZE);
+  size_t length;
+  char *mat = NULL;
+
+  if ((policy & MM_ALLOC_HUGEPAGE) && bytes >= HUGE_PAGE_SIZE) {
+    align = HUGE_PAGE_SIZE;
+  }
+  length = (bytes + align - 1) / align * align;
+  if (length == 0) {
+    length = align;
+  }
+
+  if (posix_memalign((void **) &mat, align, length) != 0) {
+    mat = NULL;
+  }
+  assert(mat != NULL);
+
+  /* Policies must be in place before the first touch */
+  if (align == HUGE_PAGE_SIZE) {
+    madvise(mat, length, MADV_HUGEPAGE);
+  }
+  if (policy & MM_ALLOC_INTERLEAVE) {
+    interleave(mat, length);
+  }
+
+  /* Touch each column from the thread that computes on it */
+  mm_affinity_apply();
+
+  #pragma omp parallel for schedule(static)
+  for (c = 0; c < cols; c++) {
+    memset(mat + c * colBytes, 0, colBytes);
+  } /* c */
+
+  return mat;
+}
+
+/**
+ * Selects how mm_affinity_apply() pins threads
+ **/
+void mm_set_affinity(int value) {
+  affinity = value;
+  affinity_chosen = 1;
+  pinned_threads = 0;
+}
+
+/**
+ * Orders the CPUs the process may run on for compact or scatter
+ *  placement; processes that share the CPUs get disjoint slices
+ *
+ *  Slices are cut only when every process may run on every CPU of the
+ *  node, since the local rank then says which slice is whose. A
+ *  launcher that binds ranks to a socket or NUMA node gives several
+ *  of them the same narrower mask, and which of them share it is not
+ *  known here: unless pinning was asked for, threads are then left to
+ *  the scheduler rather than stacked on the first CPUs of the mask.
+ **/
+static void init_cpu_order(void) {
+
+  cpu_set_t allowed;
+  int cpus[CPU_SETSIZE];
+  int nodes[CPU_SETSIZE];
+  int count = 0;
+  int cpu, i, node, local_rank = 0, local_size = 1;
+  const char *env;
+
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+  for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      nodes[count] = cpu_node(cpu);
+      cpus[count++] = cpu;
+    }
+  }
+
+  /* Ranks the launcher did not bind share the node's CPUs */
+  if ((env = getenv("OMPI_COMM_WORLD_LOCAL_SIZE")) != NULL
+      || (env = getenv("MPI_LOCALNRANKS")) != NULL) {
+    local_size = atoi(env);
+  }
+  if ((env = getenv("OMPI_COMM_WORLD_LOCAL_RANK")) != NULL
+      || (env = getenv("MPI_LOCALRANKID")) != NULL) {
+    local_rank = atoi(env);
+  }
+  if (local_size > 1 && count < (int) sysconf(_SC_NPROCESSORS_ONLN)
+      && !affinity_chosen) {
+    affinity = MM_AFFINITY_NONE;
+    return;
+  }
+  if (local_size > 1 && count == (int) sysconf(_SC_NPROCESSORS_ONLN)
+      && count >= local_size) {
+    int slice = count / local_size;
+
+    memmove(cpus, cpus + local_rank * slice, slice * sizeof(int));
+    memmove(nodes, nodes + local_rank * slice, slice * sizeof(int));
+    count = slice;
+  } else if (local_size > 1 && count < local_size) {
+    cpus[0] = cpus[local_rank % count];
+    nodes[0] = nodes[local_rank % count];
+    count = 1;
+  }
+
+  num_cpus = 0;
+  if (affinity == MM_AFFINITY_SCATTER) {
+    /* One CPU from each node in turn */
+    int taken[CPU_SETSIZE];
+
+    memset(taken, 0, sizeof(taken));
+    while (num_cpus < count) {
+      for (node = 0; node < MAX_NODES; node++) {
+        for (i = 0; i < count; i++) {
+          if (!taken[i] && nodes[i] == node) {
+            taken[i] = 1;
+            cpu_order[num_cpus++] = cpus[i];
+            break;
+          }
+        }
+      }
+    }
+  } else {
+    for (i = 0; i < count; i++) {
+      cpu_order[num_cpus++] = cpus[i];
+    }
+  }
+}
+
+/**
+ * Reads MM_AFFINITY on first use
+ **/
+static void read_affinity(void) {
+
+  if (affinity < 0) {
+    const char *env = getenv("MM_AFFINITY");
+
+    affinity = MM_AFFINITY_COMPACT;
+    affinity_chosen = (env != NULL);
+    if (env != NULL && strcmp(env, "none") == 0) {
+      affinity = MM_AFFINITY_NONE;
+    } else if (env != NULL && strcmp(env, "scatter") == 0) {
+      affinity = MM_AFFINITY_SCATTER;
+    }
+  }
+}
+
+/**
+ * CPU of thread number thread, -1 when threads are not pinned
+ **/
+int mm_affinity_cpu(int thread) {
+
+  read_affinity();
+
+  /* The mask is read once: pinning narrows it */
+  if (affinity != MM_AFFINITY_NONE && num_cpus == 0) {
+    init_cpu_order();
+  }
+  if (affinity == MM_AFFINITY_NONE) {
+    return -1;
+  }
+  return cpu_order[thread % num_cpus];
+}
+
+/**
+ * Pins the OpenMP threads of the calling process
+ **/
+void mm_affinity_apply(void) {
+
+  int threads = omp_get_max_threads();
+
+  if (mm_affinity_cpu(0) < 0 || threads == pinned_threads
+      || omp_in_parallel()) {
+    return;
+  }
+
+  #pragma omp parallel
+  {
+    cpu_set_t mask;
+
+    CPU_ZERO(&mask);
+    CPU_SET(mm_affinity_cpu(omp_get_thread_num()), &mask);
+    sched_setaffinity(0, sizeof(mask), &mask);
+  }
+
+  pinned_threads = threads;
+}
+
+/**
+ * Prints where the threads of this process run and how its matrices
+ *  are placed
+ **/
+void mm_placement_report(FILE *out, int rank) {
+
+  int policy = mm_get_alloc_policy();
+  int threads = omp_get_max_threads();
+  int *cpus = (int *) malloc(threads * sizeof(int));
+  int t;
+  const char *names[] = { "none", "compact", "scatter" };
+
+  assert(cpus != NULL);
+
+  #pragma omp parallel
+  {
+    cpus[omp_get_thread_num()] = sched_getcpu();
+  }
+
+  fprintf(out, "Placement: rank %d, nodes=%d, alloc=%s%s, affinity=%s, "
+      "threads=%d, cpu(node)=", rank, mm_numa_nodes(),
+      (policy & MM_ALLOC_INTERLEAVE) ? "interleave" : "first-touch",
+      (policy & MM_ALLOC_HUGEPAGE) ? "+hugepage" : "",
+      (affinity < 0) ? "unset" : names[affinity], threads);
+  for (t = 0; t < threads; t++) {
+    fprintf(out, "%s%d(%d)", (t == 0) ? "" : " ", cpus[t], cpu_node(cpus[t]));
+  }
+  fprintf(out, "\n");
+
+  free(cpus);
+}
@@ -0,0 +1,103 @@
+/**
+ *  \file mm_numa.h
+ *  \brief NUMA-aware allocation and thread placement for Proj1
+ *
+ *  allocate_matrix() and the single-precision variant place their
+ *  pages through mm_alloc(). By default pages are first touched by
+ *  the OpenMP threads that later compute on them: columns are split
+ *  with schedule(static), the same split local_mm() uses for the
+ *  column tiles of C and B. MM_ALLOC_INTERLEAVE spreads pages round
+ *  robin over the NUMA nodes instead, MM_ALLOC_HUGEPAGE asks for
+ *  transparent huge pages.
+ *
+ *  mm_affinity_apply() pins the OpenMP threads to the CPUs the process
+ *  may run on, and the local_mm() workers (mm_pool.h) take the same
+ *  CPUs, so computation stays on the cores, and the nodes, where the
+ *  pages were touched. Ranks on one node that may all run anywhere
+ *  split its CPUs by local rank. When several ranks run on a node and
+ *  the launcher narrowed their masks, as socket or NUMA binding does,
+ *  ranks sharing a mask cannot tell which slice is theirs, so threads
+ *  are pinned only if MM_AFFINITY or mm_set_affinity() asks for it.
+ *
+ *  Both are set from the environment the first time they are used:
+ *
+ *    MM_ALLOC=first-touch|interleave|hugepage|interleave,hugepage
+ *    MM_AFFINITY=compact|scatter|none
+ */
+
+#ifndef MM_NUMA_H
+#define MM_NUMA_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MM_ALLOC_FIRST_TOUCH 0 /*!< Pages land on the node of the first thread to touch them */
+#define MM_ALLOC_INTERLEAVE 1  /*!< Pages are spread round robin over the nodes */
+#define MM_ALLOC_HUGEPAGE 2    /*!< Transparent huge pages, combines with the others */
+
+#define MM_AFFINITY_NONE 0    /*!< Threads are left to the scheduler */
+#define MM_AFFINITY_COMPACT 1 /*!< Thread t on the t-th allowed CPU */
+#define MM_AFFINITY_SCATTER 2 /*!< Threads round robin over the nodes */
+
+/**
+ * Selects the allocation policy of mm_alloc(), a combination of
+ *  the MM_ALLOC_* flags
+ **/
+void mm_set_alloc_policy(int policy);
+
+/**
+ * Returns the allocation policy, read from MM_ALLOC on first use
+ **/
+int mm_get_alloc_policy(void);
+
+/**
+ * Allocates a rows by cols column-major matrix of elemSize-byte
+ *  elements under the current policy
+ *
+ *  Every page is touched, zero-filled, before the call returns. The
+ *  result is released with free().
+ **/
+void *mm_alloc(int rows, int cols, size_t elemSize);
+
+/**
+ * Selects how mm_affinity_apply() pins threads, one of MM_AFFINITY_*
+ **/
+void mm_set_affinity(int affinity);
+
+/**
+ * Pins the OpenMP threads of the calling process
+ *
+ *  Returns at once after the first call, unless the number of
+ *  threads has changed since.
+ **/
+void mm_affinity_apply(void);
+
+/**
+ * CPU that thread number thread (0 is the caller) is pinned to under
+ *  the current selection, -1 when threads are not pinned
+ *
+ *  The mm_pool.h workers use it, so they land on the same CPUs as the
+ *  OpenMP threads that first touched the matrices.
+ **/
+int mm_affinity_cpu(int thread);
+
+/**
+ * Number of NUMA nodes with memory
+ **/
+int mm_numa_nodes(void);
+
+/**
+ * Prints where the threads of this process run and how its matrices
+ *  are placed, one line prefixed with rank
+ **/
+void mm_placement_report(FILE *out, int rank);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MM_NUMA_H */
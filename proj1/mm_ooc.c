@@ -0,0 +1,253 @@
+/**
+ *  \file mm_ooc.c
+ *  \brief Out-of-core local multiply on memory-mapped matrices
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "local_mm.h"
+#include "mm_ooc.h"
+
+#define MM_OOC_BUDGET_DEFAULT 256 /*!< Megabytes, without MM_OOC_BUDGET */
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+
+static size_t budget = 0; /*!< 0 until set or read from MM_OOC_BUDGET */
+
+int mm_ooc_map(const char *path, int rows, int cols, int mode,
+    mm_ooc_matrix_t *matrix) {
+
+  int flags = (mode == MM_OOC_READ) ? O_RDONLY : O_RDWR;
+  size_t bytes = (size_t) rows * cols * sizeof(double);
+  struct stat st;
+  void *data;
+
+  if (mode == MM_OOC_CREATE) {
+    flags |= O_CREAT | O_TRUNC;
+  }
+
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->data = NULL;
+  matrix->bytes = bytes;
+  matrix->writable = (mode != MM_OOC_READ);
+  matrix->fd = open(path, flags, 0644);
+  if (matrix->fd < 0) {
+    return -1;
+  }
+
+  if ((mode == MM_OOC_CREATE && ftruncate(matrix->fd, bytes) != 0)
+      || fstat(matrix->fd, &st) != 0) {
+    close(matrix->fd);
+    matrix->fd = -1;
+    return -1;
+  }
+  if ((size_t) st.st_size < bytes) {
+    close(matrix->fd);
+    matrix->fd = -1;
+    errno = EINVAL;
+    return -1;
+  }
+
+  /* mmap() rejects empty mappings; an empty matrix needs no pages */
+  if (bytes == 0) {
+    return 0;
+  }
+
+  data = mmap(NULL, bytes, matrix->writable ? PROT_READ | PROT_WRITE
+      : PROT_READ, MAP_SHARED, matrix->fd, 0);
+  if (data == MAP_FAILED) {
+    close(matrix->fd);
+    matrix->fd = -1;
+    return -1;
+  }
+
+  matrix->data = (double *) data;
+  return 0;
+}
+
+void mm_ooc_wrap(double *data, int rows, int cols, mm_ooc_matrix_t *matrix) {
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->data = data;
+  matrix->bytes = (size_t) rows * cols * sizeof(double);
+  matrix->fd = -1;
+  matrix->writable = 1;
+}
+
+void mm_ooc_unmap(mm_ooc_matrix_t *matrix) {
+
+  if (matrix->fd < 0) {
+    return;
+  }
+  if (matrix->data != NULL) {
+    if (matrix->writable) {
+      msync(matrix->data, matrix->bytes, MS_SYNC);
+    }
+    munmap(matrix->data, matrix->bytes);
+  }
+  close(matrix->fd);
+  matrix->data = NULL;
+  matrix->fd = -1;
+}
+
+void mm_ooc_set_budget(size_t bytes) {
+  budget = bytes;
+}
+
+size_t mm_ooc_get_budget(void) {
+
+  if (budget == 0) {
+    const char *env = getenv("MM_OOC_BUDGET");
+
+    budget = (size_t) MM_OOC_BUDGET_DEFAULT << 20;
+    if (env != NULL && atol(env) > 0) {
+      budget = (size_t) atol(env) << 20;
+    }
+  }
+  return budget;
+}
+
+/**
+ * Square tiles of side s with kt = s / 4 keep s * s + 4 * s * kt = 2 * s * s
+ *  elements mapped: the tile and two chunks each of A and B. A side that
+ *  hits m or n gives the rest of the budget to the other.
+ **/
+void mm_ooc_tiles(int m, int n, int k, size_t bytes, int *mt, int *nt,
+    int *kt) {
+
+  double elements = (double) bytes / sizeof(double);
+  int s = (int) sqrt(elements / 2.0);
+
+  /* Whole cache lines of a column at least, and never nothing */
+  if (s >= 64) {
+    s -= s % 64;
+  }
+  s = MAX(s, 1);
+
+  *kt = MIN(k, MAX(s / 4, 1));
+  *mt = MIN(m, s);
+  *nt = MIN(n, s);
+
+  if (*mt < s && *nt == s) {
+    *nt = (int) MAX(1.0, (elements - 2.0 * *kt * *mt) / (*mt + 2.0 * *kt));
+    *nt = MIN(n, *nt);
+  } else if (*nt < s && *mt == s) {
+    *mt = (int) MAX(1.0, (elements - 2.0 * *kt * *nt) / (*nt + 2.0 * *kt));
+    *mt = MIN(m, *mt);
+  }
+}
+
+/**
+ * Applies madvise() to columns col to col + cols - 1, rows row to
+ *  row + rows - 1, of a mapped matrix, widened to whole pages
+ **/
+static void advise(const mm_ooc_matrix_t *matrix, int row, int col, int rows,
+    int cols, int advice) {
+
+  uintptr_t page = (uintptr_t) sysconf(_SC_PAGESIZE);
+  uintptr_t base = (uintptr_t) matrix->data;
+  uintptr_t end = base + matrix->bytes;
+  uintptr_t first = 0, last = 0;
+  int j;
+
+  if (matrix->fd < 0 || matrix->data == NULL || rows <= 0 || cols <= 0) {
+    return;
+  }
+
+  /* A column of the range that reaches the next one merges with it */
+  for (j = col; j < col + cols; j++) {
+    uintptr_t start = base + ((size_t) j * matrix->rows + row) * sizeof(double);
+    uintptr_t stop = start + (size_t) rows * sizeof(double);
+
+    start -= (start - base) % page;
+    stop = MIN(end, stop + (page - (stop - base) % page) % page);
+    if (j > col && start <= last) {
+      last = stop;
+      continue;
+    }
+    if (j > col) {
+      madvise((void *) first, last - first, advice);
+    }
+    first = start;
+    last = stop;
+  }
+  madvise((void *) first, last - first, advice);
+}
+
+void local_mm_ooc(double alpha, const mm_ooc_matrix_t *A,
+    const mm_ooc_matrix_t *B, double beta, mm_ooc_matrix_t *C) {
+
+  int m = C->rows;
+  int n = C->cols;
+  int k = A->cols;
+  int mt, nt, kt, chunks, tile = 0;
+  int i, j, c;
+
+  assert(A->rows == m && B->rows == k && B->cols == n);
+  assert(C->writable);
+
+  mm_ooc_tiles(m, n, k, mm_ooc_get_budget(), &mt, &nt, &kt);
+  chunks = (k > 0) ? (k + kt - 1) / kt : 1;
+
+  for (j = 0; j < n; j += nt) {
+    int cols = MIN(nt, n - j);
+
+    for (i = 0; i < m; i += mt, tile++) {
+      int rows = MIN(mt, m - i);
+
+      /* Odd tiles run k backward, starting on the chunks just used */
+      for (c = 0; c < chunks; c++) {
+        int chunk = (tile % 2 == 0) ? c : chunks - 1 - c;
+        int p = chunk * kt;
+        int depth = MIN(kt, k - p);
+        int last = (c + 1 == chunks);
+
+        if (!last) {
+          int q = ((tile % 2 == 0) ? chunk + 1 : chunk - 1) * kt;
+
+          advise(A, i, q, rows, MIN(kt, k - q), MADV_WILLNEED);
+          advise(B, q, j, MIN(kt, k - q), cols, MADV_WILLNEED);
+        } else {
+          /* The next tile starts on this chunk again */
+          int ni = (i + mt < m) ? i + mt : 0;
+          int nj = (i + mt < m) ? j : j + nt;
+
+          if (nj < n) {
+            advise(A, ni, p, MIN(mt, m - ni), depth, MADV_WILLNEED);
+            advise(B, p, nj, depth, MIN(nt, n - nj), MADV_WILLNEED);
+            if (beta != 0.0) {
+              advise(C, ni, nj, MIN(mt, m - ni), MIN(nt, n - nj),
+                  MADV_WILLNEED);
+            }
+          }
+        }
+
+        local_mm(rows, cols, depth, alpha, A->data + (size_t) p * m + i, m,
+            B->data + (size_t) j * k + p, k, (c == 0) ? beta : 1.0,
+            C->data + (size_t) j * m + i, m);
+
+        /* Keep the last chunk of A for a next tile on the same rows and
+         * of B for one on the same columns */
+        if (!last || mt < m) {
+          advise(A, i, p, rows, depth, MADV_DONTNEED);
+        }
+        if (!last || i + mt >= m) {
+          advise(B, p, j, depth, cols, MADV_DONTNEED);
+        }
+      }
+
+      advise(C, i, j, rows, cols, MADV_DONTNEED);
+    }
+  }
+}
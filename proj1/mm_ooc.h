@@ -0,0 +1,104 @@
+/**
+ *  \file mm_ooc.h
+ *  \brief Out-of-core local multiply on memory-mapped matrices
+ *
+ *  A block too large for RAM can live in a file: mm_ooc_map() maps it
+ *  column-major, leading dimension rows, and local_mm_ooc() multiplies
+ *  such matrices tile by tile. C is cut into mt by nt tiles, visited
+ *  column of tiles by column of tiles; each tile stays resident while
+ *  the mt by kt chunks of A and kt by nt chunks of B stream past it.
+ *  This reads A and B about n / nt and m / mt times, which for square
+ *  tiles as large as the budget allows is within a small factor of the
+ *  least I/O any order can do, and reads and writes C once. The k loop
+ *  runs forward and backward on alternate tiles, so the chunks at the
+ *  turn are used twice in a row.
+ *
+ *  While one chunk is multiplied the next one is handed to the kernel
+ *  with madvise(MADV_WILLNEED), which starts reading it in the
+ *  background; during the last chunk of a tile, the first chunks of
+ *  the next tile and, unless beta is 0, the next tile of C. Chunks of
+ *  A and B are dropped with MADV_DONTNEED once used, and so is a tile
+ *  of C once finished (its pages stay in the page cache, dirty, until
+ *  the kernel writes them back), which keeps the pages mapped in at
+ *  about the budget: one tile of C and two chunks each of A and B.
+ *  The budget is MM_OOC_BUDGET megabytes, 256 by default, or what
+ *  mm_ooc_set_budget() sets.
+ */
+
+#ifndef MM_OOC_H
+#define MM_OOC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MM_OOC_READ 0 /*!< Map an existing file read-only */
+#define MM_OOC_WRITE 1 /*!< Map an existing file read-write */
+#define MM_OOC_CREATE 2 /*!< Create or truncate the file, read-write */
+
+/**
+ * A rows by cols column-major matrix, mapped from a file or wrapping
+ *  memory (fd -1)
+ **/
+typedef struct {
+  int rows, cols;
+  double *data;
+  size_t bytes; /* length of the mapping */
+  int fd;
+  int writable;
+} mm_ooc_matrix_t;
+
+/**
+ * Maps the rows by cols matrix in path with mode MM_OOC_READ,
+ *  MM_OOC_WRITE or MM_OOC_CREATE
+ *
+ *  A created file reads as zeros. Returns 0, or -1 with errno set if
+ *  the file cannot be opened, sized or mapped, or is too short.
+ **/
+int mm_ooc_map(const char *path, int rows, int cols, int mode,
+    mm_ooc_matrix_t *matrix);
+
+/**
+ * Describes a matrix already in memory, so it can be mixed with mapped
+ *  ones; nothing is dropped from it
+ **/
+void mm_ooc_wrap(double *data, int rows, int cols, mm_ooc_matrix_t *matrix);
+
+/**
+ * Writes back and unmaps a mapped matrix; does nothing to a wrapped one
+ **/
+void mm_ooc_unmap(mm_ooc_matrix_t *matrix);
+
+/**
+ * Sets the bytes local_mm_ooc() may keep mapped in
+ **/
+void mm_ooc_set_budget(size_t bytes);
+
+/**
+ * Returns the budget in bytes, read from MM_OOC_BUDGET on first use
+ **/
+size_t mm_ooc_get_budget(void);
+
+/**
+ * Tile of C (mt by nt) and chunk depth kt local_mm_ooc() uses for an
+ *  m by n by k product under budget bytes
+ **/
+void mm_ooc_tiles(int m, int n, int k, size_t budget, int *mt, int *nt,
+    int *kt);
+
+/**
+ * C = alpha * A * B + beta * C, A m by k, B k by n and C m by n, any of
+ *  them mapped or wrapped
+ *
+ *  Each tile of C is read only if beta is not 0. C must be writable.
+ **/
+void local_mm_ooc(double alpha, const mm_ooc_matrix_t *A,
+    const mm_ooc_matrix_t *B, double beta, mm_ooc_matrix_t *C);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MM_OOC_H */
@@ -0,0 +1,383 @@
+/**
+ *  \file mm_pool.c
+ *  \brief Persistent work-stealing thread pool for local_mm()
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <omp.h>
+
+#include "mm_pool.h"
+#include "mm_numa.h"
+
+#define SPIN_ITERATIONS 20000 /*!< Polls for new work before a worker sleeps */
+
+/**
+ * Tasks [lo, hi) not yet taken from one thread's share of a job
+ **/
+typedef struct {
+  pthread_mutex_t lock;
+  int lo;
+  int hi;
+} range_t;
+
+struct mm_job {
+  mm_task_fn fn;
+  void *arg;
+  int tasks;
+  int finished; /* tasks completed, updated atomically */
+  int active; /* threads inside the job, under pool_lock */
+  int listed; /* still on the job list, under pool_lock */
+  int slots; /* number of ranges */
+  range_t *ranges; /* one per thread */
+  struct mm_job *next;
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cv = PTHREAD_COND_INITIALIZER; /*!< A job was queued */
+static pthread_cond_t done_cv = PTHREAD_COND_INITIALIZER; /*!< A job may be done */
+
+static int num_threads = 0; /*!< 0 until the pool starts */
+static int stopping = 0;
+static pthread_t *workers = NULL;
+static mm_job_t *head = NULL; /*!< Jobs with tasks left to take, oldest first */
+static mm_job_t *tail = NULL;
+static unsigned long generation = 0; /*!< Bumped by every submit */
+
+/**
+ * Takes the next task of range slot
+ **/
+static int take(mm_job_t *job, int slot, int *task) {
+
+  range_t *range = &job->ranges[slot];
+  int found = 0;
+
+  pthread_mutex_lock(&range->lock);
+  if (range->lo < range->hi) {
+    *task = range->lo++;
+    found = 1;
+  }
+  pthread_mutex_unlock(&range->lock);
+
+  return found;
+}
+
+/**
+ * Moves the back half of another thread's range to range slot and
+ *  takes its first task
+ **/
+static int steal(mm_job_t *job, int slot, int *task) {
+
+  int v;
+
+  for (v = 1; v < job->slots; v++) {
+    range_t *victim = &job->ranges[(slot + v) % job->slots];
+    int lo = 0, hi = 0;
+
+    pthread_mutex_lock(&victim->lock);
+    if (victim->lo < victim->hi) {
+      lo = victim->lo + (victim->hi - victim->lo) / 2;
+      hi = victim->hi;
+      victim->hi = lo;
+    }
+    pthread_mutex_unlock(&victim->lock);
+
+    if (lo < hi) {
+      range_t *own = &job->ranges[slot];
+
+      *task = lo;
+      pthread_mutex_lock(&own->lock);
+      own->lo = lo + 1;
+      own->hi = hi;
+      pthread_mutex_unlock(&own->lock);
+      return 1;
+    }
+  } /* v */
+
+  return 0;
+}
+
+/**
+ * Runs tasks of job until none is left to take; the caller has
+ *  entered the job (active) under pool_lock
+ **/
+static void work_on(mm_job_t *job, int slot) {
+
+  int task;
+
+  while (take(job, slot, &task) || steal(job, slot, &task)) {
+    job->fn(job->arg, task);
+
+    if (__atomic_add_fetch(&job->finished, 1, __ATOMIC_ACQ_REL) == job->tasks) {
+      pthread_mutex_lock(&pool_lock);
+      pthread_cond_broadcast(&done_cv);
+      pthread_mutex_unlock(&pool_lock);
+    }
+  }
+}
+
+/**
+ * Leaves job, taking it off the list; called with pool_lock held
+ **/
+static void leave(mm_job_t *job) {
+
+  job->active--;
+
+  if (job->listed) {
+    mm_job_t **link = &head;
+    mm_job_t *prev = NULL;
+
+    while (*link != job) {
+      prev = *link;
+      link = &prev->next;
+    }
+    *link = job->next;
+    if (tail == job) {
+      tail = prev;
+    }
+    job->listed = 0;
+  }
+
+  pthread_cond_broadcast(&done_cv);
+}
+
+static void *worker_main(void *arg) {
+
+  int slot = (int) (long) arg;
+  int cpu = mm_affinity_cpu(slot);
+  unsigned long seen = 0;
+
+  if (cpu >= 0) {
+    cpu_set_t mask;
+
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+  }
+
+  pthread_mutex_lock(&pool_lock);
+  while (!stopping) {
+    mm_job_t *job = head;
+
+    if (job == NULL) {
+      int spin;
+
+      /* Poll briefly, a summa() panel loop submits back-to-back */
+      pthread_mutex_unlock(&pool_lock);
+      for (spin = 0; spin < SPIN_ITERATIONS; spin++) {
+        if (__atomic_load_n(&generation, __ATOMIC_ACQUIRE) != seen) {
+          break;
+        }
+      }
+      pthread_mutex_lock(&pool_lock);
+
+      seen = generation;
+      if (head == NULL && !stopping) {
+        pthread_cond_wait(&work_cv, &pool_lock);
+      }
+      continue;
+    }
+
+    job->active++;
+    pthread_mutex_unlock(&pool_lock);
+
+    work_on(job, slot);
+
+    pthread_mutex_lock(&pool_lock);
+    leave(job);
+  }
+  pthread_mutex_unlock(&pool_lock);
+
+  return NULL;
+}
+
+/**
+ * Starts the workers; called with pool_lock held
+ **/
+static void start(int threads) {
+
+  long w;
+
+  num_threads = threads;
+  stopping = 0;
+
+  /* Reads the CPU mask before any worker narrows it */
+  mm_affinity_cpu(0);
+
+  workers = (pthread_t *) malloc(num_threads * sizeof(pthread_t));
+  assert(workers != NULL);
+
+  for (w = 1; w < num_threads; w++) {
+    if (pthread_create(&workers[w], NULL, worker_main, (void *) w) != 0) {
+      fprintf(stderr, "mm_pool: cannot start worker %ld\n", w);
+      num_threads = (int) w;
+      break;
+    }
+  } /* w */
+}
+
+/**
+ * Default size: MM_POOL_THREADS, else the OpenMP thread count
+ **/
+static int default_threads(void) {
+
+  const char *env = getenv("MM_POOL_THREADS");
+  int threads = (env != NULL) ? atoi(env) : omp_get_max_threads();
+
+  return (threads > 0) ? threads : 1;
+}
+
+/**
+ * Starts the pool on first use; called with pool_lock held
+ **/
+static void ensure_started(void) {
+
+  static int registered = 0;
+
+  if (num_threads == 0) {
+    start(default_threads());
+    if (!registered) {
+      atexit(mm_pool_shutdown);
+      registered = 1;
+    }
+  }
+}
+
+/**
+ * Number of threads that run jobs, the waiting caller included
+ **/
+int mm_pool_threads(void) {
+
+  int threads;
+
+  pthread_mutex_lock(&pool_lock);
+  ensure_started();
+  threads = num_threads;
+  pthread_mutex_unlock(&pool_lock);
+
+  return threads;
+}
+
+/**
+ * Stops and joins the workers
+ **/
+void mm_pool_shutdown(void) {
+
+  int w, threads;
+
+  pthread_mutex_lock(&pool_lock);
+  assert(head == NULL);
+  stopping = 1;
+  threads = num_threads;
+  pthread_cond_broadcast(&work_cv);
+  pthread_mutex_unlock(&pool_lock);
+
+  for (w = 1; w < threads; w++) {
+    pthread_join(workers[w], NULL);
+  }
+
+  pthread_mutex_lock(&pool_lock);
+  free(workers);
+  workers = NULL;
+  num_threads = 0;
+  pthread_mutex_unlock(&pool_lock);
+}
+
+/**
+ * Restarts the pool with threads threads
+ **/
+void mm_pool_set_threads(int threads) {
+
+  assert(threads > 0);
+
+  mm_pool_shutdown();
+
+  pthread_mutex_lock(&pool_lock);
+  start(threads);
+  pthread_mutex_unlock(&pool_lock);
+}
+
+/**
+ * Queues fn(arg, 0) ... fn(arg, tasks - 1)
+ **/
+mm_job_t *mm_pool_submit(mm_task_fn fn, void *arg, int tasks) {
+
+  int s;
+  mm_job_t *job = (mm_job_t *) malloc(sizeof(mm_job_t));
+
+  assert(job != NULL);
+
+  pthread_mutex_lock(&pool_lock);
+  ensure_started();
+
+  job->fn = fn;
+  job->arg = arg;
+  job->tasks = tasks;
+  job->finished = 0;
+  job->active = 0;
+  job->listed = 1;
+  job->next = NULL;
+  job->slots = num_threads;
+  job->ranges = (range_t *) malloc(num_threads * sizeof(range_t));
+  assert(job->ranges != NULL);
+
+  /* Contiguous shares, in the order mm_alloc() touched the pages */
+  for (s = 0; s < num_threads; s++) {
+    pthread_mutex_init(&job->ranges[s].lock, NULL);
+    job->ranges[s].lo = (int) ((long) tasks * s / num_threads);
+    job->ranges[s].hi = (int) ((long) tasks * (s + 1) / num_threads);
+  }
+
+  if (tail == NULL) {
+    head = job;
+  } else {
+    tail->next = job;
+  }
+  tail = job;
+
+  __atomic_add_fetch(&generation, 1, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&work_cv);
+  pthread_mutex_unlock(&pool_lock);
+
+  return job;
+}
+
+/**
+ * Helps with job until all its tasks have finished, then frees it
+ **/
+void mm_pool_wait(mm_job_t *job) {
+
+  int s;
+
+  pthread_mutex_lock(&pool_lock);
+  job->active++;
+  pthread_mutex_unlock(&pool_lock);
+
+  work_on(job, 0);
+
+  pthread_mutex_lock(&pool_lock);
+  leave(job);
+  while (__atomic_load_n(&job->finished, __ATOMIC_ACQUIRE) < job->tasks
+      || job->active > 0) {
+    pthread_cond_wait(&done_cv, &pool_lock);
+  }
+  pthread_mutex_unlock(&pool_lock);
+
+  for (s = 0; s < job->slots; s++) {
+    pthread_mutex_destroy(&job->ranges[s].lock);
+  }
+  free(job->ranges);
+  free(job);
+}
+
+/**
+ * mm_pool_submit() followed by mm_pool_wait()
+ **/
+void mm_pool_run(mm_task_fn fn, void *arg, int tasks) {
+  mm_pool_wait(mm_pool_submit(fn, arg, tasks));
+}
@@ -0,0 +1,70 @@
+/**
+ *  \file mm_pool.h
+ *  \brief Persistent work-stealing thread pool for local_mm()
+ *
+ *  The pool starts on first use and keeps its workers, pinned as in
+ *  mm_numa.h, until the program exits, so a local_mm() call costs a
+ *  wake-up instead of an OpenMP team fork/join.
+ *
+ *  A job is a function applied to the task indices [0, tasks). The
+ *  indices are split into one contiguous range per thread; a thread
+ *  takes tasks from the front of its own range and, once it is
+ *  empty, steals the back half of another thread's range. The thread
+ *  that waits for a job works on it too, on range 0.
+ *
+ *  The number of threads, caller included, is MM_POOL_THREADS or
+ *  else omp_get_max_threads().
+ */
+
+#ifndef MM_POOL_H
+#define MM_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * One task: arg is shared by the job, task is the index
+ **/
+typedef void (*mm_task_fn)(void *arg, int task);
+
+typedef struct mm_job mm_job_t;
+
+/**
+ * Number of threads that run jobs, the waiting caller included
+ **/
+int mm_pool_threads(void);
+
+/**
+ * Restarts the pool with threads threads (the caller is one of them)
+ **/
+void mm_pool_set_threads(int threads);
+
+/**
+ * Queues fn(arg, 0) ... fn(arg, tasks - 1) and returns at once
+ *
+ *  Jobs run in submission order; workers move on to the next job
+ *  once every task of the current one has been taken.
+ **/
+mm_job_t *mm_pool_submit(mm_task_fn fn, void *arg, int tasks);
+
+/**
+ * Helps with job until all its tasks have finished, then frees it
+ **/
+void mm_pool_wait(mm_job_t *job);
+
+/**
+ * mm_pool_submit() followed by mm_pool_wait()
+ **/
+void mm_pool_run(mm_task_fn fn, void *arg, int tasks);
+
+/**
+ * Stops and joins the workers; the next job starts them again
+ **/
+void mm_pool_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MM_POOL_H */
@@ -0,0 +1,390 @@
+/**
+ *  \file mm_q8.c
+ *  \brief Quantized int8 matrix multiply with int32 accumulation
+ *
+ *  Both SIMD kernels multiply an unsigned byte by a signed byte, so
+ *  the signs are moved first:
+ *
+ *    VNNI  A + 128 is stored unsigned and 128 * (column sum of B) is
+ *          taken off afterwards; vpdpbusd adds its four products into
+ *          the int32 lane without any 16-bit intermediate.
+ *    AVX2  |A| times B with the sign of A, vpmaddubsw; its pairs of
+ *          products fit in 16 bits (2 * 127 * 127 < 32767) because
+ *          the elements stay within [-127, 127], then vpmaddwd by 1
+ *          widens them into int32 lanes.
+ *
+ *  A is packed once per block of rows, four consecutive k of each row
+ *  side by side so one load holds a whole row block; B is copied to
+ *  columns padded to a multiple of 4, whose 4-byte groups are
+ *  broadcast. Blocks of rows and columns of C are tasks of the
+ *  local_mm() thread pool.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <immintrin.h>
+
+#include "mm_q8.h"
+#include "mm_pool.h"
+
+#define Q8_NR 4 /*!< Columns of C per pass over the packed A block */
+#define Q8_TASKS_PER_THREAD 4
+
+static int current_isa = -1; /*!< -1 until the first call picks one */
+
+typedef struct {
+  int m, n, k, k4; /* k4: k rounded up to a multiple of 4 */
+  const int8_t *A;
+  int lda;
+  const int8_t *B;
+  int ldb;
+  const int8_t *Bp; /* k4 by n, padded with zeros */
+  const int32_t *colsum; /* of B, for the VNNI offset */
+  int beta;
+  int32_t *C;
+  int ldc;
+  int isa;
+  int mr; /* rows per block: 16 (VNNI), 8 (AVX2, scalar) */
+  int rowBlocks, colChunk, colChunks;
+} q8_job_t;
+
+/**
+ * Best kernel the CPU supports
+ **/
+static int detect_isa(void) {
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+      && __builtin_cpu_supports("avx512vnni"))
+    return MM_Q8_VNNI;
+  if (__builtin_cpu_supports("avx2"))
+    return MM_Q8_AVX2;
+  return MM_Q8_SCALAR;
+}
+
+int mm_q8_isa(void) {
+
+  if (current_isa < 0)
+    current_isa = detect_isa();
+  return current_isa;
+}
+
+int mm_q8_set_isa(int isa) {
+
+  int best = detect_isa();
+
+  current_isa = (isa < best) ? isa : best;
+  return current_isa;
+}
+
+const char *mm_q8_isa_name(int isa) {
+
+  switch (isa) {
+    case MM_Q8_VNNI: return "vnni";
+    case MM_Q8_AVX2: return "avx2";
+    default: return "scalar";
+  }
+}
+
+/**
+ * Packs rows [r0, r0 + mr) of A into job->mr-row groups of 4 k,
+ *  adding offset to every byte; missing rows and k are zero
+ **/
+static void pack_A(const q8_job_t *job, int r0, int mr, int offset,
+    int8_t *Ap) {
+
+  int i, p;
+
+  memset(Ap, 0, (size_t) job->k4 * job->mr);
+  for (p = 0; p < job->k; p++) {
+    const int8_t *a = job->A + (size_t) p * job->lda + r0;
+    int8_t *dest = Ap + (size_t) (p / 4) * 4 * job->mr + p % 4;
+
+    for (i = 0; i < mr; i++)
+      dest[4 * i] = (int8_t) (a[i] + offset);
+  }
+}
+
+/**
+ * Writes one column of a block of C
+ **/
+static inline void store_column(const q8_job_t *job, int r0, int mr, int j,
+    const int32_t *acc, int32_t correction) {
+
+  int i;
+  int32_t *c = job->C + (size_t) j * job->ldc + r0;
+
+  for (i = 0; i < mr; i++)
+    c[i] = acc[i] - correction + (job->beta ? c[i] : 0);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+static void kernel_vnni(const q8_job_t *job, const int8_t *Ap, int r0, int mr,
+    int c0, int c1) {
+
+  int g, j, jj;
+  int groups = job->k4 / 4;
+
+  for (j = c0; j < c1; j += Q8_NR) {
+    int nr = (c1 - j < Q8_NR) ? c1 - j : Q8_NR;
+    const int8_t *b = job->Bp + (size_t) j * job->k4;
+    __m512i acc[Q8_NR];
+    int32_t out[16];
+
+    for (jj = 0; jj < Q8_NR; jj++)
+      acc[jj] = _mm512_setzero_si512();
+
+    for (g = 0; g < groups; g++) {
+      __m512i a = _mm512_loadu_si512((const void *) (Ap + (size_t) g * 64));
+
+      for (jj = 0; jj < nr; jj++) {
+        int32_t word;
+
+        memcpy(&word, b + (size_t) jj * job->k4 + 4 * g, 4);
+        acc[jj] = _mm512_dpbusd_epi32(acc[jj], a, _mm512_set1_epi32(word));
+      }
+    }
+
+    for (jj = 0; jj < nr; jj++) {
+      _mm512_storeu_si512((void *) out, acc[jj]);
+      store_column(job, r0, mr, j + jj, out, 128 * job->colsum[j + jj]);
+    }
+  }
+}
+
+__attribute__((target("avx2")))
+static void kernel_avx2(const q8_job_t *job, const int8_t *Ap, int r0, int mr,
+    int c0, int c1) {
+
+  int g, j, jj;
+  int groups = job->k4 / 4;
+  const __m256i ones = _mm256_set1_epi16(1);
+
+  for (j = c0; j < c1; j += Q8_NR) {
+    int nr = (c1 - j < Q8_NR) ? c1 - j : Q8_NR;
+    const int8_t *b = job->Bp + (size_t) j * job->k4;
+    __m256i acc[Q8_NR];
+    int32_t out[8];
+
+    for (jj = 0; jj < Q8_NR; jj++)
+      acc[jj] = _mm256_setzero_si256();
+
+    for (g = 0; g < groups; g++) {
+      __m256i a = _mm256_loadu_si256((const __m256i *) (Ap + (size_t) g * 32));
+      __m256i absA = _mm256_abs_epi8(a);
+
+      for (jj = 0; jj < nr; jj++) {
+        int32_t word;
+        __m256i signedB;
+
+        memcpy(&word, b + (size_t) jj * job->k4 + 4 * g, 4);
+        signedB = _mm256_sign_epi8(_mm256_set1_epi32(word), a);
+        acc[jj] = _mm256_add_epi32(acc[jj],
+            _mm256_madd_epi16(_mm256_maddubs_epi16(absA, signedB), ones));
+      }
+    }
+
+    for (jj = 0; jj < nr; jj++) {
+      _mm256_storeu_si256((__m256i *) out, acc[jj]);
+      store_column(job, r0, mr, j + jj, out, 0);
+    }
+  }
+}
+
+static void kernel_scalar(const q8_job_t *job, int r0, int mr, int c0,
+    int c1) {
+
+  int i, j, p;
+  int32_t acc[8];
+
+  for (j = c0; j < c1; j++) {
+    const int8_t *b = job->B + (size_t) j * job->ldb;
+
+    for (i = 0; i < mr; i++)
+      acc[i] = 0;
+    for (p = 0; p < job->k; p++) {
+      const int8_t *a = job->A + (size_t) p * job->lda + r0;
+
+      for (i = 0; i < mr; i++)
+        acc[i] += (int32_t) a[i] * b[p];
+    }
+    store_column(job, r0, mr, j, acc, 0);
+  }
+}
+
+/**
+ * Pool task: one block of rows times one chunk of columns
+ **/
+static void q8_task(void *arg, int task) {
+
+  const q8_job_t *job = (const q8_job_t *) arg;
+  int r0 = (task % job->rowBlocks) * job->mr;
+  int mr = (job->m - r0 < job->mr) ? job->m - r0 : job->mr;
+  int c0 = (task / job->rowBlocks) * job->colChunk;
+  int c1 = (job->n - c0 < job->colChunk) ? job->n : c0 + job->colChunk;
+  int8_t *Ap;
+
+  if (job->isa == MM_Q8_SCALAR) {
+    kernel_scalar(job, r0, mr, c0, c1);
+    return;
+  }
+
+  Ap = (int8_t *) malloc((size_t) job->k4 * job->mr);
+  assert(Ap != NULL);
+
+  if (job->isa == MM_Q8_VNNI) {
+    pack_A(job, r0, mr, 128, Ap);
+    kernel_vnni(job, Ap, r0, mr, c0, c1);
+  } else {
+    pack_A(job, r0, mr, 0, Ap);
+    kernel_avx2(job, Ap, r0, mr, c0, c1);
+  }
+
+  free(Ap);
+}
+
+/**
+ * C = A * B + beta * C on int8 A and B, int32 C
+ **/
+void local_mm_q8(int m, int n, int k, const int8_t *A, int lda,
+    const int8_t *B, int ldb, int beta, int32_t *C, int ldc) {
+
+  q8_job_t job;
+  int8_t *Bp = NULL;
+  int32_t *colsum = NULL;
+  int i, j, p, target, blocks;
+
+  assert(lda >= m);
+  assert(ldb >= k);
+  assert(ldc >= m);
+
+  if (m == 0 || n == 0)
+    return;
+
+  job.m = m;
+  job.n = n;
+  job.k = k;
+  job.k4 = (k + 3) / 4 * 4;
+  job.A = A;
+  job.lda = lda;
+  job.B = B;
+  job.ldb = ldb;
+  job.beta = beta;
+  job.C = C;
+  job.ldc = ldc;
+  job.isa = mm_q8_isa();
+  job.mr = (job.isa == MM_Q8_VNNI) ? 16 : 8;
+
+  if (job.isa != MM_Q8_SCALAR) {
+    Bp = (int8_t *) calloc((size_t) job.k4 * n, 1);
+    colsum = (int32_t *) calloc(n, sizeof(int32_t));
+    assert(Bp != NULL && colsum != NULL);
+
+    for (j = 0; j < n; j++) {
+      for (p = 0; p < k; p++) {
+        Bp[(size_t) j * job.k4 + p] = B[(size_t) j * ldb + p];
+        colsum[j] += B[(size_t) j * ldb + p];
+      }
+    }
+  }
+  job.Bp = Bp;
+  job.colsum = colsum;
+
+  /* Row blocks first, then columns until every thread has work */
+  target = Q8_TASKS_PER_THREAD * mm_pool_threads();
+  job.rowBlocks = (m + job.mr - 1) / job.mr;
+  blocks = (n + Q8_NR - 1) / Q8_NR;
+  i = (target + job.rowBlocks - 1) / job.rowBlocks;
+  if (i > blocks)
+    i = blocks;
+  job.colChunk = Q8_NR * ((blocks + i - 1) / i);
+  job.colChunks = (n + job.colChunk - 1) / job.colChunk;
+
+  mm_pool_run(q8_task, &job, job.rowBlocks * job.colChunks);
+
+  free(Bp);
+  free(colsum);
+}
+
+void mm_q8_row_scales(int m, int k, const double *A, int lda, double *scale) {
+
+  int i, p;
+
+  for (i = 0; i < m; i++)
+    scale[i] = 0.0;
+  for (p = 0; p < k; p++)
+    for (i = 0; i < m; i++)
+      if (fabs(A[(size_t) p * lda + i]) > scale[i])
+        scale[i] = fabs(A[(size_t) p * lda + i]);
+  for (i = 0; i < m; i++)
+    scale[i] /= 127.0;
+}
+
+void mm_q8_col_scales(int k, int n, const double *B, int ldb, double *scale) {
+
+  int j, p;
+
+  for (j = 0; j < n; j++) {
+    scale[j] = 0.0;
+    for (p = 0; p < k; p++)
+      if (fabs(B[(size_t) j * ldb + p]) > scale[j])
+        scale[j] = fabs(B[(size_t) j * ldb + p]);
+    scale[j] /= 127.0;
+  }
+}
+
+/**
+ * round(x / scale) within [-127, 127]
+ **/
+static inline int8_t quantize(double x, double scale) {
+
+  double q;
+
+  if (scale == 0.0)
+    return 0;
+  q = round(x / scale);
+  if (q > 127.0)
+    q = 127.0;
+  if (q < -127.0)
+    q = -127.0;
+  return (int8_t) q;
+}
+
+void mm_q8_quantize_rows(int m, int k, const double *A, int lda,
+    const double *scale, int8_t *Aq, int ldq) {
+
+  int i, p;
+
+  for (p = 0; p < k; p++)
+    for (i = 0; i < m; i++)
+      Aq[(size_t) p * ldq + i] = quantize(A[(size_t) p * lda + i], scale[i]);
+}
+
+void mm_q8_quantize_cols(int k, int n, const double *B, int ldb,
+    const double *scale, int8_t *Bq, int ldq) {
+
+  int j, p;
+
+  for (j = 0; j < n; j++)
+    for (p = 0; p < k; p++)
+      Bq[(size_t) j * ldq + p] = quantize(B[(size_t) j * ldb + p], scale[j]);
+}
+
+void mm_q8_dequantize(int m, int n, const int32_t *C, int ldc,
+    const double *rowScale, const double *colScale, double alpha, double beta,
+    double *D, int ldd) {
+
+  int i, j;
+
+  for (j = 0; j < n; j++) {
+    double s = alpha * colScale[j];
+
+    for (i = 0; i < m; i++) {
+      double d = s * rowScale[i] * C[(size_t) j * ldc + i];
+
+      D[(size_t) j * ldd + i] = (beta == 0.0) ? d : d + beta * D[(size_t) j * ldd + i];
+    }
+  }
+}
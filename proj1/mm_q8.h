@@ -0,0 +1,94 @@
+/**
+ *  \file mm_q8.h
+ *  \brief Quantized int8 matrix multiply with int32 accumulation
+ *
+ *  local_mm_q8() multiplies column-major int8 matrices into an int32
+ *  C. The kernel is picked at run time from what the CPU supports:
+ *  AVX-512 VNNI (vpdpbusd, four products per int32 lane and
+ *  instruction), AVX2 (vpmaddubsw then vpmaddwd) or portable C. All
+ *  three give the same, exact result as long as the elements of A and
+ *  B lie in [-127, 127], which is what mm_q8_quantize_rows() and
+ *  mm_q8_quantize_cols() produce.
+ *
+ *  A double-precision product is approximated by quantizing A with
+ *  one scale per row and B with one scale per column, so that
+ *  A(i, p) ~ rowScale[i] * Aq(i, p) and B(p, j) ~ Bq(p, j) * colScale[j];
+ *  then A*B(i, j) ~ rowScale[i] * colScale[j] * (Aq*Bq)(i, j), which
+ *  mm_q8_dequantize() applies.
+ */
+
+#ifndef MM_Q8_H
+#define MM_Q8_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MM_Q8_SCALAR 0 /*!< Portable C */
+#define MM_Q8_AVX2 1 /*!< vpmaddubsw / vpmaddwd */
+#define MM_Q8_VNNI 2 /*!< AVX-512 vpdpbusd */
+
+/**
+ * C = A * B + beta * C on int8 A (m by k) and B (k by n), int32 C
+ *
+ *  beta is 0 or 1; C is not read when it is 0.
+ **/
+void local_mm_q8(int m, int n, int k, const int8_t *A, int lda,
+    const int8_t *B, int ldb, int beta, int32_t *C, int ldc);
+
+/**
+ * The kernel local_mm_q8() runs, MM_Q8_SCALAR to MM_Q8_VNNI
+ **/
+int mm_q8_isa(void);
+
+/**
+ * Caps the kernel at isa, for testing and comparing them; isa above
+ *  what the CPU supports selects the best it supports. Returns the
+ *  kernel now in use.
+ **/
+int mm_q8_set_isa(int isa);
+
+/**
+ * Name of a kernel, "scalar", "avx2" or "vnni"
+ **/
+const char *mm_q8_isa_name(int isa);
+
+/**
+ * Scales of the m by k A, one per row: scale[i] = max_p |A(i, p)| / 127
+ *
+ *  A row of zeros gets scale 0. The scale of a row split over several
+ *  processes is the largest of their scales.
+ **/
+void mm_q8_row_scales(int m, int k, const double *A, int lda, double *scale);
+
+/**
+ * Scales of the k by n B, one per column
+ **/
+void mm_q8_col_scales(int k, int n, const double *B, int ldb, double *scale);
+
+/**
+ * Aq(i, p) = round(A(i, p) / scale[i]), 0 where scale[i] is 0
+ **/
+void mm_q8_quantize_rows(int m, int k, const double *A, int lda,
+    const double *scale, int8_t *Aq, int ldq);
+
+/**
+ * Bq(p, j) = round(B(p, j) / scale[j]), 0 where scale[j] is 0
+ **/
+void mm_q8_quantize_cols(int k, int n, const double *B, int ldb,
+    const double *scale, int8_t *Bq, int ldq);
+
+/**
+ * D = alpha * diag(rowScale) * C * diag(colScale) + beta * D
+ **/
+void mm_q8_dequantize(int m, int n, const int32_t *C, int ldc,
+    const double *rowScale, const double *colScale, double alpha, double beta,
+    double *D, int ldd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MM_Q8_H */
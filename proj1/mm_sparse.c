@@ -0,0 +1,151 @@
+/**
+ *  \file mm_sparse.c
+ *  \brief Compressed sparse rows and sparse times dense multiply
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "mm_sparse.h"
+#include "mm_pool.h"
+
+#define SPMM_COLS 8 /*!< Columns of C accumulated together per stored row */
+#define SPMM_TILE 64 /*!< Columns of C per task */
+
+/**
+ * Compresses a column-major matrix; every row is stored
+ **/
+void mm_csr_from_dense(int rows, int cols, const double *A, int lda,
+    mm_csr_t *csr) {
+
+  int r, c, nnz = 0;
+
+  for (c = 0; c < cols; c++)
+    for (r = 0; r < rows; r++)
+      if (A[(size_t) c * lda + r] != 0.0)
+        nnz++;
+
+  csr->rows = rows;
+  csr->cols = cols;
+  csr->nnz = nnz;
+  csr->nrows = rows;
+  csr->rowIds = NULL;
+  csr->rowPtr = (int *) malloc((rows + 1) * sizeof(int));
+  csr->colIdx = (int *) malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+  csr->val = (double *) malloc((nnz > 0 ? nnz : 1) * sizeof(double));
+  assert(csr->rowPtr != NULL && csr->colIdx != NULL && csr->val != NULL);
+
+  /* Row by row, so columns come out in order within each row */
+  nnz = 0;
+  for (r = 0; r < rows; r++) {
+    csr->rowPtr[r] = nnz;
+    for (c = 0; c < cols; c++) {
+      double a = A[(size_t) c * lda + r];
+      if (a != 0.0) {
+        csr->colIdx[nnz] = c;
+        csr->val[nnz] = a;
+        nnz++;
+      }
+    }
+  }
+  csr->rowPtr[rows] = nnz;
+}
+
+/**
+ * Releases the arrays of mm_csr_from_dense()
+ **/
+void mm_csr_free(mm_csr_t *csr) {
+
+  free(csr->rowIds);
+  free(csr->rowPtr);
+  free(csr->colIdx);
+  free(csr->val);
+  csr->rowIds = NULL;
+  csr->rowPtr = NULL;
+  csr->colIdx = NULL;
+  csr->val = NULL;
+}
+
+typedef struct {
+  const mm_csr_t *A;
+  const double *B;
+  double *C;
+  int n, ldb, ldc;
+  double alpha;
+  int rowChunk; /* stored rows per task */
+  int rowTasks; /* tasks along the stored rows */
+} spmm_job_t;
+
+/**
+ * Stored rows of one chunk times the columns of one tile
+ **/
+static void spmm_task(void *arg, int task) {
+
+  const spmm_job_t *job = (const spmm_job_t *) arg;
+  const mm_csr_t *A = job->A;
+  int r0 = (task % job->rowTasks) * job->rowChunk;
+  int r1 = r0 + job->rowChunk < A->nrows ? r0 + job->rowChunk : A->nrows;
+  int c0 = (task / job->rowTasks) * SPMM_TILE;
+  int c1 = c0 + SPMM_TILE < job->n ? c0 + SPMM_TILE : job->n;
+  int r, c, j, p;
+
+  for (r = r0; r < r1; r++) {
+    int row = (A->rowIds != NULL) ? A->rowIds[r] : r;
+    double *Crow = job->C + row;
+
+    for (c = c0; c < c1; c += SPMM_COLS) {
+      int width = c1 - c < SPMM_COLS ? c1 - c : SPMM_COLS;
+      const double *Bc = job->B + (size_t) c * job->ldb;
+      double acc[SPMM_COLS] = { 0.0 };
+
+      for (p = A->rowPtr[r]; p < A->rowPtr[r + 1]; p++) {
+        double a = A->val[p];
+        const double *b = Bc + A->colIdx[p];
+        for (j = 0; j < width; j++)
+          acc[j] += a * b[(size_t) j * job->ldb];
+      }
+
+      for (j = 0; j < width; j++)
+        Crow[(size_t) (c + j) * job->ldc] += job->alpha * acc[j];
+    }
+  }
+}
+
+/**
+ * Sparse times dense multiply, C = alpha * A * B + beta * C
+ **/
+void local_spmm(int n, double alpha, const mm_csr_t *A, const double *B,
+    int ldb, double beta, double *C, int ldc) {
+
+  spmm_job_t job;
+  int r, c, colTasks, threads;
+
+  if (beta != 1.0) {
+    for (c = 0; c < n; c++)
+      for (r = 0; r < A->rows; r++)
+        C[(size_t) c * ldc + r] = (beta == 0.0) ? 0.0 : beta * C[(size_t) c * ldc + r];
+  }
+
+  if (A->nnz == 0 || n == 0 || alpha == 0.0)
+    return;
+
+  threads = mm_pool_threads();
+  colTasks = (n + SPMM_TILE - 1) / SPMM_TILE;
+
+  job.A = A;
+  job.B = B;
+  job.C = C;
+  job.n = n;
+  job.ldb = ldb;
+  job.ldc = ldc;
+  job.alpha = alpha;
+
+  /* Enough row chunks that every thread has about two tasks */
+  job.rowTasks = (2 * threads + colTasks - 1) / colTasks;
+  if (job.rowTasks > A->nrows)
+    job.rowTasks = A->nrows;
+  job.rowChunk = (A->nrows + job.rowTasks - 1) / job.rowTasks;
+  job.rowTasks = (A->nrows + job.rowChunk - 1) / job.rowChunk;
+
+  mm_pool_run(spmm_task, &job, job.rowTasks * colTasks);
+}
@@ -0,0 +1,55 @@
+/**
+ *  \file mm_sparse.h
+ *  \brief Compressed sparse rows and sparse times dense multiply
+ *
+ *  An mm_csr_t stores the nonzeros of a rows by cols matrix row by
+ *  row. Rows without nonzeros may be left out: with rowIds set, the
+ *  nrows stored rows are rowIds[0], rowIds[1], ... (increasing), so a
+ *  sparse panel costs memory and bandwidth in proportion to its
+ *  nonzeros rather than to its height.
+ */
+
+#ifndef MM_SPARSE_H
+#define MM_SPARSE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  int rows, cols, nnz;
+  int nrows; /* stored rows */
+  int *rowIds; /* row of each stored row; NULL when nrows == rows */
+  int *rowPtr; /* nrows + 1 offsets into colIdx and val */
+  int *colIdx; /* increasing within a row */
+  double *val;
+} mm_csr_t;
+
+/**
+ * Compresses a column-major rows by cols matrix with leading
+ *  dimension lda; every row is stored
+ **/
+void mm_csr_from_dense(int rows, int cols, const double *A, int lda,
+    mm_csr_t *csr);
+
+/**
+ * Releases the arrays of mm_csr_from_dense()
+ **/
+void mm_csr_free(mm_csr_t *csr);
+
+/**
+ * Sparse times dense multiply, C = alpha * A * B + beta * C
+ *
+ *  A is A->rows by A->cols in CSR, B is A->cols by n and C is A->rows
+ *  by n, both column-major. Rows of A that are not stored only scale
+ *  C by beta. Runs on the local_mm() thread pool, split by stored rows
+ *  and by columns of C.
+ **/
+void local_spmm(int n, double alpha, const mm_csr_t *A, const double *B,
+    int ldb, double beta, double *C, int ldc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MM_SPARSE_H */
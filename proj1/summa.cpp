@@ -0,0 +1,262 @@
+/**
+ *  \file summa.cpp
+ *  \brief Implementation of Scalable Universal
+ *    Matrix Multiplication Algorithm for Proj1
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+#include <string.h>
+
+#include "local_mm.h"
+#include "summa.h"
+#include "mm_core.hpp"
+
+/**
+ * Distributed Matrix Multiply using the SUMMA algorithm
+ *  Computes C = A*B + C
+ *
+ *  This function uses procGridX times procGridY processes
+ *   to compute the product
+ *
+ *  A is a m by k matrix, each process starts
+ *	with a block of A (aBlock)
+ *
+ *  B is a k by n matrix, each process starts
+ *	with a block of B (bBlock)
+ *
+ *  C is a n by m matrix, each process starts
+ *	with a block of C (cBlock)
+ *
+ *  The resulting matrix is stored in C.
+ *  A and B should not be modified during computation.
+ *
+ *  Ablock, Bblock, and CBlock are stored in
+ *   column-major format
+ *
+ *  pb is the Panel Block Size
+ *
+ *  summa() and its single-precision and complex siblings are
+ *   instantiations of mm::summa() in mm_core.hpp.
+ **/
+#ifndef EXTERNAL_SUMMA
+void summa(int m, int n, int k, double *Ablock, double *Bblock, double *Cblock,
+        int procGridX, int procGridY, int pb) {
+
+    mm::summa<double>(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY, pb);
+}
+#endif /* EXTERNAL_SUMMA */
+
+/**
+ * SUMMA with a fused epilogue, computes C = epilogue(A*B + C)
+ **/
+void summa_epilogue(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY, int pb,
+        const mm_epilogue_t *epilogue) {
+
+    mm::summa<double>(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY,
+            pb, epilogue);
+}
+
+/**
+ * Single-precision SUMMA, computes C = A*B + C
+ *
+ *  Same distribution and arguments as summa(), with float blocks.
+ *  Panels travel as MPI_FLOAT, so every broadcast moves half the
+ *  bytes of summa().
+ **/
+void summa_f(int m, int n, int k, float *Ablock, float *Bblock, float *Cblock,
+        int procGridX, int procGridY, int pb) {
+
+    mm::summa<float>(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY, pb);
+}
+
+/**
+ * Single-precision complex SUMMA, computes C = A*B + C
+ **/
+void summa_c(int m, int n, int k, mm_complex_float *Ablock,
+        mm_complex_float *Bblock, mm_complex_float *Cblock,
+        int procGridX, int procGridY, int pb) {
+
+    mm::summa<mm_complex_float>(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY, pb);
+}
+
+/**
+ * Double-precision complex SUMMA, computes C = A*B + C
+ **/
+void summa_z(int m, int n, int k, mm_complex_double *Ablock,
+        mm_complex_double *Bblock, mm_complex_double *Cblock,
+        int procGridX, int procGridY, int pb) {
+
+    mm::summa<mm_complex_double>(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY, pb);
+}
+
+/**
+ * Planar double-precision complex SUMMA, computes C = A*B + C
+ *
+ *  The real and imaginary planes are stacked as in summa_mixed(), A
+ *  rows over rows and B columns after columns, so one broadcast per
+ *  panel carries both.
+ **/
+void summa_zp(int m, int n, int k, double *Ar, double *Ai, double *Br,
+        double *Bi, double *Cr, double *Ci, int procGridX, int procGridY,
+        int pb) {
+
+    int i, c;
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    int widthB = k / procGridX;
+
+    double *stackA; /* 2*rows by widthA: Ar rows on top of Ai rows */
+    double *stackB; /* widthB by 2*cols: Br columns, then Bi columns */
+    double *bufferA;
+    double *bufferB;
+
+    summa_grid_t grid;
+
+    assert(k % pb == 0);
+
+    if(summa_trace_enabled)
+        summa_trace_call(m, n, k, procGridX, procGridY, pb);
+
+    summa_grid_create(procGridX, procGridY, &grid);
+
+    stackA = (double *) malloc((size_t) 2 * rows * widthA * sizeof(double));
+    stackB = (double *) malloc((size_t) widthB * 2 * cols * sizeof(double));
+    bufferA = (double *) malloc((size_t) 2 * rows * pb * sizeof(double));
+    bufferB = (double *) malloc((size_t) pb * 2 * cols * sizeof(double));
+    assert(stackA != NULL && stackB != NULL && bufferA != NULL && bufferB != NULL);
+
+    for(c = 0; c < widthA; ++c)
+    {
+        memcpy(stackA + (size_t) c * 2 * rows, Ar + (size_t) c * rows, rows * sizeof(double));
+        memcpy(stackA + (size_t) c * 2 * rows + rows, Ai + (size_t) c * rows, rows * sizeof(double));
+    }
+    memcpy(stackB, Br, (size_t) widthB * cols * sizeof(double));
+    memcpy(stackB + (size_t) widthB * cols, Bi, (size_t) widthB * cols * sizeof(double));
+
+    for(i = 0; i < k/pb; ++i)
+    {
+        double t_start = 0.0;
+
+        summa_bcast_panel_A(&grid, 2 * rows, widthA, i * pb, pb, stackA, 2 * rows,
+                bufferA, 2 * rows, MPI_DOUBLE, i);
+        summa_bcast_panel_B(&grid, 2 * cols, widthB, i * pb, pb, stackB, widthB,
+                bufferB, pb, MPI_DOUBLE, i);
+
+        if(summa_trace_enabled) t_start = MPI_Wtime();
+
+        local_mm_zp(rows, cols, pb, 1.0, bufferA, bufferA + rows, 2 * rows,
+                bufferB, bufferB + (size_t) pb * cols, pb, 1.0, Cr, Ci, rows);
+
+        if(summa_trace_enabled)
+            summa_trace_compute(i, t_start, MPI_Wtime(), 8.0 * rows * (double) cols * pb);
+    }
+
+    /* Completes the sends still reading from the buffers */
+    summa_grid_free(&grid);
+
+    free(stackA);
+    free(stackB);
+    free(bufferA);
+    free(bufferB);
+}
+
+/**
+ * Splits each element of a double matrix into a float hi part and a
+ *  float lo part, with src = hi + lo to about 48 bits
+ **/
+static void split_matrix(int rows, int cols, const double *src, int lds,
+        float *hi, float *lo, int ld) {
+
+    int r, c;
+
+    for(c = 0; c < cols; ++c)
+    {
+        for(r = 0; r < rows; ++r)
+        {
+            double value = src[c * lds + r];
+            float high = (float) value;
+
+            hi[c * ld + r] = high;
+            lo[c * ld + r] = (float) (value - (double) high);
+        }
+    }
+}
+
+/**
+ * Mixed-precision SUMMA, computes C = A*B + C in double precision
+ *
+ *  Same distribution and arguments as summa(). A and B are split into
+ *  float hi and lo parts, A = Ahi + Alo and B = Bhi + Blo to about 48
+ *  bits, which are broadcast together as MPI_FLOAT, so a panel moves
+ *  as many bytes as in summa(). Every panel is applied as Ahi*Bhi
+ *  plus the corrections Ahi*Blo and Alo*Bhi, all with float operands
+ *  and double accumulation. Only Alo*Blo, about 2^-48 relative to the
+ *  product, is dropped, so Cblock matches summa() to double-precision
+ *  rounding.
+ **/
+void summa_mixed(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY, int pb) {
+
+    int i;
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    int widthB = k / procGridX;
+
+    float *splitA; /* 2*rows by widthA: hi rows on top of lo rows */
+    float *splitB; /* widthB by 2*cols: hi columns, then lo columns */
+    float *bufferA;
+    float *bufferB;
+
+    summa_grid_t grid;
+
+    assert(k % pb == 0);
+
+    if(summa_trace_enabled)
+        summa_trace_call(m, n, k, procGridX, procGridY, pb);
+
+    summa_grid_create(procGridX, procGridY, &grid);
+
+    splitA = (float *) malloc((size_t) 2 * rows * widthA * sizeof(float));
+    splitB = (float *) malloc((size_t) widthB * 2 * cols * sizeof(float));
+    bufferA = (float *) malloc((size_t) 2 * rows * pb * sizeof(float));
+    bufferB = (float *) malloc((size_t) pb * 2 * cols * sizeof(float));
+    assert(splitA != NULL && splitB != NULL && bufferA != NULL && bufferB != NULL);
+
+    split_matrix(rows, widthA, Ablock, rows, splitA, splitA + rows, 2 * rows);
+    split_matrix(widthB, cols, Bblock, widthB, splitB, splitB + (size_t) widthB * cols, widthB);
+
+    for(i = 0; i < k/pb; ++i)
+    {
+        double t_start = 0.0;
+
+        summa_bcast_panel_A(&grid, 2 * rows, widthA, i * pb, pb, splitA, 2 * rows,
+                bufferA, 2 * rows, MPI_FLOAT, i);
+        summa_bcast_panel_B(&grid, 2 * cols, widthB, i * pb, pb, splitB, widthB,
+                bufferB, pb, MPI_FLOAT, i);
+
+        if(summa_trace_enabled) t_start = MPI_Wtime();
+
+        /* Ahi*Bhi, then the Ahi*Blo and Alo*Bhi corrections */
+        local_mm_mixed(rows, cols, pb, 1.0, bufferA, 2 * rows, bufferB, pb, 1.0, Cblock, rows);
+        local_mm_mixed(rows, cols, pb, 1.0, bufferA, 2 * rows,
+                bufferB + (size_t) pb * cols, pb, 1.0, Cblock, rows);
+        local_mm_mixed(rows, cols, pb, 1.0, bufferA + rows, 2 * rows, bufferB, pb, 1.0, Cblock, rows);
+
+        if(summa_trace_enabled)
+            summa_trace_compute(i, t_start, MPI_Wtime(), 6.0 * rows * (double) cols * pb);
+    }
+
+    /* Completes the sends still reading from the buffers */
+    summa_grid_free(&grid);
+
+    free(splitA);
+    free(splitB);
+    free(bufferA);
+    free(bufferB);
+}
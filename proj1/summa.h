@@ -4,6 +4,31 @@
  *    Matrix Multiplication Algorithm for Proj1
  */
 
+#ifndef SUMMA_H
+#define SUMMA_H
+
+#include <stdio.h>
+
+#include "local_mm.h"
+#include "mm_sparse.h"
+#include "mm_q8.h"
+#include "mm_epilogue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SUMMA_BCAST_MPI 0  /*!< Panels are broadcast with MPI_Bcast */
+#define SUMMA_BCAST_RING 1 /*!< Panels flow through a pipelined, segmented ring */
+#define SUMMA_BCAST_SEGMENT_DEFAULT 65536 /*!< Ring segment size, in bytes */
+
+#define SUMMA_STATIONARY_C 0 /*!< A and B panels move, C accumulates in place */
+#define SUMMA_STATIONARY_A 1 /*!< B and partial C move, A stays */
+#define SUMMA_STATIONARY_B 2 /*!< A and partial C move, B stays */
+#define SUMMA_1D_ROW 3 /*!< summa_1d_row(), procGridY == 1 */
+#define SUMMA_1D_COL 4 /*!< summa_1d_col(), procGridX == 1 */
+#define SUMMA_INNER 5 /*!< summa_inner(), k split over the grid */
+
 /**
  * Distributed Matrix Multiply using the SUMMA algorithm
  *  Computes C = A*B + C
@@ -30,3 +55,361 @@
  **/
 void summa(int m, int n, int k, double *Ablock, double *Bblock, double *Cblock,
     int procGridX, int procGridY, int blockSize);
+
+/**
+ * Single-precision SUMMA, computes C = A*B + C
+ *
+ *  Same distribution and arguments as summa(), with float blocks.
+ *  Broadcasts move half the bytes of summa().
+ **/
+void summa_f(int m, int n, int k, float *Ablock, float *Bblock, float *Cblock,
+    int procGridX, int procGridY, int blockSize);
+
+/**
+ * Mixed-precision SUMMA, computes C = A*B + C
+ *
+ *  Same arguments as summa(). A and B are split into float hi and lo
+ *  parts, broadcast together; each panel is applied as hi*hi plus the
+ *  hi*lo and lo*hi corrections, float operands accumulated in double,
+ *  so Cblock is accurate to double precision.
+ **/
+void summa_mixed(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY, int blockSize);
+
+/**
+ * Complex SUMMA, computes C = A*B + C
+ *
+ *  Same distribution and arguments as summa(), with single-precision
+ *  (summa_c) or double-precision (summa_z) complex blocks.
+ **/
+void summa_c(int m, int n, int k, mm_complex_float *Ablock,
+    mm_complex_float *Bblock, mm_complex_float *Cblock, int procGridX,
+    int procGridY, int blockSize);
+
+void summa_z(int m, int n, int k, mm_complex_double *Ablock,
+    mm_complex_double *Bblock, mm_complex_double *Cblock, int procGridX,
+    int procGridY, int blockSize);
+
+/**
+ * SUMMA with a fused epilogue, computes C = epilogue(A*B + C)
+ *
+ *  Same distribution and arguments as summa(). The epilogue (see
+ *  mm_epilogue.h) is applied inside the multiply of the last panel,
+ *  tile by tile, with row and column indices local to Cblock.
+ **/
+void summa_epilogue(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY, int blockSize,
+    const mm_epilogue_t *epilogue);
+
+/**
+ * Sum-of-products SUMMA, computes C = A1*B1 + A2*B2 + ... + C
+ *
+ *  Term t multiplies the m by k[t] matrix whose block is Ablocks[t] by
+ *  the k[t] by n matrix whose block is Bblocks[t], distributed as in
+ *  summa(). All terms share one panel loop: each round broadcasts the
+ *  next blockSize-wide panel of every term and applies them with one
+ *  local_mm() call, so Cblock is updated once per round.
+ **/
+void summa_multi(int terms, int m, int n, const int *k,
+    double *const *Ablocks, double *const *Bblocks, double *Cblock,
+    int procGridX, int procGridY, int blockSize);
+
+/**
+ * Planar complex SUMMA, computes C = A*B + C
+ *
+ *  Same distribution and arguments as summa_z(), with every complex
+ *  block held as a real and an imaginary double block. The two planes
+ *  of a panel travel in one message and are multiplied with
+ *  local_mm_zp(), so local_mm_set_complex() chooses between four and
+ *  three real products per panel.
+ **/
+void summa_zp(int m, int n, int k, double *Ar, double *Ai, double *Br,
+    double *Bi, double *Cr, double *Ci, int procGridX, int procGridY,
+    int blockSize);
+
+/**
+ * Task-graph SUMMA, computes C = A*B + C
+ *
+ *  Same distribution and arguments as summa(). Panels are broadcast
+ *  with MPI_Ibcast up to lookahead panels ahead of the oldest panel
+ *  still being applied, and the threads of local_mm() update tiles
+ *  of Cblock as soon as the panel they need has arrived, so a late
+ *  rank or broadcast stalls only the updates that depend on it.
+ *  summa_set_bcast() does not apply. lookahead must be at least 1.
+ **/
+void summa_dag(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY, int blockSize,
+    int lookahead);
+
+/**
+ * Handle of a multiply started by summa_begin()
+ **/
+typedef struct summa_request *summa_request_t;
+
+/**
+ * Starts a nonblocking SUMMA, C = A*B + C
+ *
+ *  Same distribution and arguments as summa(). Collective over the
+ *  procGridX * procGridY processes, which must start their multiplies
+ *  in the same order. Each request gets its own communicators, so
+ *  several can be in flight on the same grid and overlap each other's
+ *  communication.
+ *
+ *  Ablock, Bblock and Cblock belong to the multiply until it has
+ *  completed.
+ **/
+summa_request_t summa_begin(int m, int n, int k, double *Ablock,
+    double *Bblock, double *Cblock, int procGridX, int procGridY,
+    int blockSize);
+
+/**
+ * Moves a multiply forward without blocking
+ *
+ *  Applies at most one panel whose broadcasts have completed and
+ *  starts the next. Returns 1 and sets *request to NULL once the
+ *  multiply is complete, 0 otherwise. Progress is only made inside
+ *  summa_test() and summa_wait().
+ **/
+int summa_test(summa_request_t *request);
+
+/**
+ * Completes a multiply and sets *request to NULL
+ **/
+void summa_wait(summa_request_t *request);
+
+/**
+ * One-sided SUMMA, computes C = A*B + C, blocks as in summa()
+ *
+ *  Each process exposes Ablock and Bblock through MPI windows and
+ *  pulls the panels it needs with MPI_Rget under passive-target
+ *  synchronization, a few panels ahead of the one it multiplies.
+ *  Collective over the grid: the windows are created and freed on
+ *  every call.
+ **/
+void summa_rma(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY, int blockSize);
+
+/**
+ * SUMMA with a choice of stationary operand, computes C = A*B + C
+ *
+ *  Same distribution and arguments as summa(). SUMMA_STATIONARY_C is
+ *  summa() itself. With SUMMA_STATIONARY_A every process multiplies
+ *  its Ablock by the rows of B it matches, read one-sidedly, for
+ *  blockSize columns of each Cblock at a time, and the partial C
+ *  panels are summed with MPI_Reduce_scatter_block along rowComm.
+ *  SUMMA_STATIONARY_B does the same with the roles of A and B
+ *  exchanged, blockSize rows of each Cblock at a time along colComm.
+ **/
+void summa_stationary(int variant, int m, int n, int k, double *Ablock,
+    double *Bblock, double *Cblock, int procGridX, int procGridY,
+    int blockSize);
+
+/**
+ * Row-distributed multiply, C = A*B + C, on a procGridX by 1 grid
+ *
+ *  Same distribution as summa(); every process gathers all of B with
+ *  one MPI_Allgather and multiplies its rows of A by it. For tall,
+ *  skinny A.
+ **/
+void summa_1d_row(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY);
+
+/**
+ * Column-distributed multiply, C = A*B + C, on a 1 by procGridY grid
+ *
+ *  The transpose of summa_1d_row(): gathers all of A.
+ **/
+void summa_1d_col(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY);
+
+/**
+ * Inner-product multiply, C = A*B + C, for k much larger than m and n
+ *
+ *  Same distribution as summa(). Every process reads about
+ *  k / (procGridX * procGridY) whole columns of A and rows of B
+ *  one-sidedly, forms the m by n product of that slice, and the
+ *  partial products are summed onto the Cblocks with
+ *  MPI_Reduce_scatter_block.
+ **/
+void summa_inner(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY);
+
+/**
+ * SUMMA with a sparse A, C = A*B + C
+ *
+ *  Same distribution as summa(), with this process's block of A,
+ *  m / procGridX by k / procGridY, in compressed sparse rows. A panels
+ *  are broadcast compressed, holding only their nonzero rows; panels
+ *  of A without nonzeros are skipped, and so are the B panels they
+ *  would have met, so the words sent and the flops follow the
+ *  nonzeros of A rather than m * k.
+ **/
+void summa_sparse(int m, int n, int k, const mm_csr_t *Ablock,
+    double *Bblock, double *Cblock, int procGridX, int procGridY,
+    int blockSize);
+
+/**
+ * Triangular SUMMA, C = L*B + C, L the lower triangle of the m by m A
+ *
+ *  Same distribution as summa() with k = m; the strictly upper
+ *  triangle of A is not referenced. Process rows above a panel's
+ *  diagonal block skip it, and only the rows from the diagonal down
+ *  are broadcast and multiplied, so about half the words and flops of
+ *  summa() are spent.
+ **/
+void summa_trmm(int m, int n, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY, int blockSize);
+
+/**
+ * Symmetric SUMMA, C = A*A^T + C on the lower triangle of the n by n C
+ *
+ *  A is n by k and C n by n, both in the distribution of summa() on a
+ *  square grid, procGridX == procGridY. Only the blocks of C on or
+ *  below the diagonal of the grid are formed, and of the diagonal
+ *  blocks only their lower triangle; the rest of C is not touched.
+ *  B = A^T is not stored: its panels are the A panels, forwarded down
+ *  each column by the diagonal process.
+ **/
+void summa_syrk(int n, int k, double *Ablock, double *Cblock, int procGridX,
+    int procGridY, int blockSize);
+
+/**
+ * Int8 SUMMA, C = A*B + C, exact in int32
+ *
+ *  Same distribution as summa(); panels travel as MPI_INT8_T and are
+ *  multiplied with local_mm_q8(). Elements must lie in [-127, 127].
+ **/
+void summa_q8_int(int m, int n, int k, const int8_t *Ablock,
+    const int8_t *Bblock, int32_t *Cblock, int procGridX, int procGridY,
+    int blockSize);
+
+/**
+ * SUMMA through int8, C = A*B + C approximately
+ *
+ *  Same arguments as summa(). A is quantized with one scale per row
+ *  and B with one per column, agreed over the processes that share
+ *  the row or column, multiplied with summa_q8_int() and scaled back
+ *  into C. The error of an element of C is about k * |A| * |B| / 127
+ *  at worst, so this is for data that tolerates 8-bit precision.
+ **/
+void summa_q8(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY, int blockSize);
+
+/**
+ * The algorithm (SUMMA_STATIONARY_C, ..., SUMMA_INNER) that moves the
+ *  fewest words per process for this shape and grid, see
+ *  summa_model_volume()
+ *
+ *  Where that is summa() on a one-dimensional grid, the matching
+ *  summa_1d_row() or summa_1d_col() is returned instead.
+ **/
+int summa_select(int m, int n, int k, int procGridX, int procGridY);
+
+/**
+ * Computes C = A*B + C with one of the algorithms of summa_select()
+ *
+ *  blockSize is passed on to summa() and summa_stationary(); the
+ *  one-dimensional and inner-product algorithms have no panels.
+ **/
+void summa_run(int algorithm, int m, int n, int k, double *Ablock,
+    double *Bblock, double *Cblock, int procGridX, int procGridY,
+    int blockSize);
+
+/**
+ * summa_run() with the algorithm of summa_select(); returns it
+ **/
+int summa_auto(int m, int n, int k, double *Ablock, double *Bblock,
+    double *Cblock, int procGridX, int procGridY, int blockSize);
+
+/**
+ * Lays the process grid out for the locality of the processes
+ *
+ *  Finds the node, socket and core of every process and renumbers
+ *  the grid so that the communicator carrying the larger panels for
+ *  this shape, rowComm for A or colComm for B, spans as few nodes as
+ *  possible. Every summa variant then takes its block coordinates from
+ *  summa_grid_rank() instead of the MPI_COMM_WORLD rank, so the blocks
+ *  must be distributed by grid rank. Collective over MPI_COMM_WORLD,
+ *  whose size must be procGridX * procGridY.
+ **/
+void summa_set_topology(int m, int n, int k, int procGridX, int procGridY);
+
+/**
+ * Goes back to grid rank = MPI_COMM_WORLD rank
+ **/
+void summa_clear_topology(void);
+
+/**
+ * This process's rank in the grid, indexX = rank % procGridX
+ **/
+int summa_grid_rank(void);
+
+/**
+ * distribute_matrix() by grid rank: the n by m matrix mat, read on
+ *  MPI_COMM_WORLD rank 0, is scattered over summa_comm() so that grid
+ *  rank r receives block r. Collective over MPI_COMM_WORLD.
+ **/
+void summa_distribute_matrix(int procGridX, int procGridY, int n, int m,
+    double *mat, double *block);
+
+/**
+ * Bytes summa() sends between nodes in one multiply with the current
+ *  grid, counting each band once per process of another node that
+ *  receives it; printed to out unless out is NULL. Collective.
+ **/
+double summa_topology_report(FILE *out, int m, int n, int k, int procGridX,
+    int procGridY);
+
+/**
+ * Plan for repeated summa() calls with one shape, grid and panel size
+ **/
+typedef struct summa_plan *summa_plan_t;
+
+/**
+ * Sets up repeated multiplies of one shape
+ *
+ *  Builds the communicators, two panel buffers each for A and B and
+ *  one broadcast per band, persistent (MPI_Bcast_init) when the MPI
+ *  library implements MPI-4. Collective over the grid.
+ **/
+summa_plan_t summa_plan_create(int m, int n, int k, int procGridX,
+    int procGridY, int blockSize);
+
+/**
+ * Computes C = A*B + C with a plan, blocks as in summa()
+ *
+ *  Keeps two panels in flight: each is multiplied as soon as it has
+ *  arrived, and its buffers then receive the panel two after it.
+ **/
+void summa_plan_execute(summa_plan_t plan, double *Ablock, double *Bblock,
+    double *Cblock);
+
+/**
+ * Releases a plan and sets *plan to NULL; collective over the grid
+ **/
+void summa_plan_free(summa_plan_t *plan);
+
+/**
+ * Selects how the summa() variants broadcast panels along the row
+ *  and column communicators
+ *
+ *  SUMMA_BCAST_MPI leaves the algorithm to MPI_Bcast (the default).
+ *  SUMMA_BCAST_RING passes every panel from its owner around the
+ *  communicator in segments of about segmentSize bytes, so successive
+ *  panels stream through the ring back-to-back ("long pipe" SUMMA).
+ *
+ *  Applies to calls made after it returns; every process must make
+ *  the same selection.
+ **/
+void summa_set_bcast(int algorithm, int segmentSize);
+
+/**
+ * Returns the selection made by summa_set_bcast()
+ **/
+void summa_get_bcast(int *algorithm, int *segmentSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUMMA_H */
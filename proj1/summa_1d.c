@@ -0,0 +1,155 @@
+/**
+ *  \file summa_1d.c
+ *  \brief One-dimensional and inner-product multiplies for Proj1
+ *
+ *  Shapes far from square waste most of summa()'s panel loop:
+ *
+ *    summa_1d_row    a procGridX by 1 grid owns whole rows of A and C,
+ *                    so one MPI_Allgather of B and one local_mm()
+ *                    replace k / blockSize broadcasts (tall-skinny A,
+ *                    m much larger than n and k)
+ *    summa_1d_col    the transpose on a 1 by procGridY grid, gathering A
+ *    summa_inner     every process takes k / (procGridX * procGridY) of
+ *                    k, reads those columns of A and rows of B whole,
+ *                    and the m by n partial products are summed with
+ *                    MPI_Reduce_scatter_block (k much larger than m, n)
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "local_mm.h"
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+
+/**
+ * Row-distributed multiply on a procGridX by 1 grid, C = A*B + C
+ **/
+void summa_1d_row(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY) {
+
+    int rows = m / procGridX;
+    int widthB = k / procGridX;
+    double *B;
+    MPI_Datatype band, bandResized;
+
+    assert(procGridY == 1);
+
+    /* Process x's rows of B land at row x * widthB of every column */
+    B = allocate_matrix(k, n);
+    MPI_Type_vector(n, widthB, k, MPI_DOUBLE, &band);
+    MPI_Type_create_resized(band, 0, widthB * sizeof(double), &bandResized);
+    MPI_Type_commit(&bandResized);
+
+    MPI_Allgather(Bblock, widthB * n, MPI_DOUBLE, B, 1, bandResized,
+            summa_comm());
+
+    MPI_Type_free(&band);
+    MPI_Type_free(&bandResized);
+
+    local_mm(rows, n, k, 1.0, Ablock, rows, B, k, 1.0, Cblock, rows);
+
+    deallocate_matrix(B);
+}
+
+/**
+ * Column-distributed multiply on a 1 by procGridY grid, C = A*B + C
+ **/
+void summa_1d_col(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY) {
+
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    double *A;
+
+    assert(procGridX == 1);
+
+    /* Whole columns: the blocks of A are already in order */
+    A = allocate_matrix(m, k);
+    MPI_Allgather(Ablock, m * widthA, MPI_DOUBLE, A, m * widthA, MPI_DOUBLE,
+            summa_comm());
+
+    local_mm(m, cols, k, 1.0, A, m, Bblock, k, 1.0, Cblock, m);
+
+    deallocate_matrix(A);
+}
+
+/**
+ * Inner-product multiply, k split over every process, C = A*B + C
+ **/
+void summa_inner(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY) {
+
+    int i, x, y;
+    int rank;
+    int procs = procGridX * procGridY;
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    int widthB = k / procGridX;
+    int k0, depth;
+    double *A, *B, *partial, *sum;
+    MPI_Win winA, winB;
+
+    MPI_Comm_rank(summa_comm(), &rank);
+    k0 = (int) ((long) rank * k / procs);
+    depth = (int) ((long) (rank + 1) * k / procs) - k0;
+
+    MPI_Win_create(Ablock, (MPI_Aint) rows * widthA * sizeof(double),
+            sizeof(double), MPI_INFO_NULL, summa_comm(), &winA);
+    MPI_Win_create(Bblock, (MPI_Aint) widthB * cols * sizeof(double),
+            sizeof(double), MPI_INFO_NULL, summa_comm(), &winB);
+
+    /* Columns k0 to k0 + depth of A and the same rows of B */
+    A = allocate_matrix(m, (depth > 0) ? depth : 1);
+    B = allocate_matrix((depth > 0) ? depth : 1, n);
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, winA);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, winB);
+    if(depth > 0)
+    {
+        summa_get_block(winA, rows, widthA, procGridX, 0, k0, m, depth, A, m);
+        summa_get_block(winB, widthB, cols, procGridX, k0, 0, depth, n, B, depth);
+    }
+    MPI_Win_flush_local_all(winA);
+    MPI_Win_flush_local_all(winB);
+    MPI_Win_unlock_all(winA);
+    MPI_Win_unlock_all(winB);
+
+    /* Partial Cblock of every process, in rank order for the scatter */
+    partial = allocate_matrix(rows * cols, procs);
+    sum = allocate_matrix(rows, cols);
+
+    for(y = 0; y < procGridY; ++y)
+    {
+        for(x = 0; x < procGridX; ++x)
+        {
+            double *P = partial + (size_t) (y * procGridX + x) * rows * cols;
+
+            if(depth > 0)
+                local_mm(rows, cols, depth, 1.0, A + x * rows, m,
+                        B + (size_t) y * cols * depth, depth, 0.0, P, rows);
+            else
+                memset(P, 0, (size_t) rows * cols * sizeof(double));
+        }
+    }
+
+    MPI_Reduce_scatter_block(partial, sum, rows * cols, MPI_DOUBLE, MPI_SUM,
+            summa_comm());
+
+    for(i = 0; i < rows * cols; ++i)
+        Cblock[i] += sum[i];
+
+    /* Collective: no block is released while someone still reads it */
+    MPI_Win_free(&winA);
+    MPI_Win_free(&winB);
+
+    deallocate_matrix(A);
+    deallocate_matrix(B);
+    deallocate_matrix(partial);
+    deallocate_matrix(sum);
+}
@@ -0,0 +1,187 @@
+/**
+ *  \file summa_async.cpp
+ *  \brief Nonblocking split-phase SUMMA for Proj1
+ *
+ *  A summa_request_t carries the state of one multiply: its own row
+ *  and column communicators, two panel buffers and the MPI_Ibcast
+ *  requests that fill them. Panel p + 1 is broadcast while panel p
+ *  waits to be applied, and every summa_test() call moves the multiply
+ *  forward by at most one panel, so the caller decides how much of
+ *  its time goes to the product.
+ *
+ *  There is no progress thread: MPI is initialized without thread
+ *  support in this project, so all progress comes from summa_test()
+ *  and summa_wait().
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "summa.h"
+#include "mm_core.hpp"
+
+#define SUMMA_ASYNC_SLOTS 2 /*!< Panels in flight per request */
+
+struct summa_request {
+  int rows, cols, k, pb, panels;
+  int procGridX, procGridY;
+  double *Ablock, *Bblock, *Cblock;
+  summa_grid_t grid;
+
+  double *A[SUMMA_ASYNC_SLOTS]; /* rows by pb */
+  double *B[SUMMA_ASYNC_SLOTS]; /* pb by cols */
+  MPI_Request *requests[SUMMA_ASYNC_SLOTS]; /* room for 2 * pb bands */
+  int count[SUMMA_ASYNC_SLOTS];
+
+  int posted; /* panels whose broadcasts have started */
+  int applied; /* panels multiplied into Cblock */
+};
+
+/**
+ * Starts the broadcasts of every panel that has a free buffer
+ **/
+static void post_panels(summa_request *req) {
+
+    while(req->posted < req->panels && req->posted < req->applied + SUMMA_ASYNC_SLOTS)
+    {
+        int p = req->posted;
+        int s = p % SUMMA_ASYNC_SLOTS;
+
+        req->count[s] = summa_ibcast_panel_A(&req->grid, req->rows,
+                req->k / req->procGridY, p * req->pb, req->pb, req->Ablock,
+                req->rows, req->A[s], req->rows, MPI_DOUBLE, req->requests[s]);
+        req->count[s] += summa_ibcast_panel_B(&req->grid, req->cols,
+                req->k / req->procGridX, p * req->pb, req->pb, req->Bblock,
+                req->k / req->procGridX, req->B[s], req->pb, MPI_DOUBLE,
+                req->requests[s] + req->count[s]);
+        req->posted++;
+    }
+}
+
+/**
+ * Multiplies the oldest panel; its broadcasts have completed
+ **/
+static void apply_panel(summa_request *req) {
+
+    int s = req->applied % SUMMA_ASYNC_SLOTS;
+
+    local_mm(req->rows, req->cols, req->pb, 1.0, req->A[s], req->rows,
+            req->B[s], req->pb, 1.0, req->Cblock, req->rows);
+    req->applied++;
+
+    post_panels(req);
+}
+
+/**
+ * Releases the communicators and buffers of a finished request
+ **/
+static void release(summa_request *req) {
+
+    int s;
+
+    summa_grid_free(&req->grid);
+
+    for(s = 0; s < SUMMA_ASYNC_SLOTS; ++s)
+    {
+        free(req->A[s]);
+        free(req->B[s]);
+        free(req->requests[s]);
+    }
+    free(req);
+}
+
+/**
+ * Starts a nonblocking SUMMA, C = A*B + C
+ **/
+summa_request_t summa_begin(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY, int pb) {
+
+    int s;
+    summa_request *req = (summa_request *) malloc(sizeof(summa_request));
+
+    assert(req != NULL);
+    assert(k % pb == 0);
+
+    req->rows = m / procGridX;
+    req->cols = n / procGridY;
+    req->k = k;
+    req->pb = pb;
+    req->panels = k / pb;
+    req->procGridX = procGridX;
+    req->procGridY = procGridY;
+    req->Ablock = Ablock;
+    req->Bblock = Bblock;
+    req->Cblock = Cblock;
+    req->posted = 0;
+    req->applied = 0;
+
+    /* New communicators per request keep concurrent multiplies apart */
+    summa_grid_create(procGridX, procGridY, &req->grid);
+
+    for(s = 0; s < SUMMA_ASYNC_SLOTS; ++s)
+    {
+        req->A[s] = (double *) mm_alloc(req->rows, pb, sizeof(double));
+        req->B[s] = (double *) mm_alloc(pb, req->cols, sizeof(double));
+        req->requests[s] = (MPI_Request *) malloc(2 * pb * sizeof(MPI_Request));
+        req->count[s] = 0;
+        assert(req->requests[s] != NULL);
+    }
+
+    post_panels(req);
+
+    return req;
+}
+
+/**
+ * Moves the multiply forward without blocking
+ **/
+int summa_test(summa_request_t *request) {
+
+    summa_request *req = *request;
+    int arrived = 0;
+
+    if(req == NULL)
+        return 1;
+
+    if(req->applied < req->panels)
+    {
+        int s = req->applied % SUMMA_ASYNC_SLOTS;
+
+        MPI_Testall(req->count[s], req->requests[s], &arrived, MPI_STATUSES_IGNORE);
+        if(arrived)
+            apply_panel(req);
+    }
+
+    if(req->applied == req->panels)
+    {
+        release(req);
+        *request = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Completes the multiply
+ **/
+void summa_wait(summa_request_t *request) {
+
+    summa_request *req = *request;
+
+    if(req == NULL)
+        return;
+
+    while(req->applied < req->panels)
+    {
+        int s = req->applied % SUMMA_ASYNC_SLOTS;
+
+        MPI_Waitall(req->count[s], req->requests[s], MPI_STATUSES_IGNORE);
+        apply_panel(req);
+    }
+
+    release(req);
+    *request = NULL;
+}
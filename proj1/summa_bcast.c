@@ -0,0 +1,198 @@
+/**
+ *  \file summa_bcast.c
+ *  \brief Panel broadcast engines for the summa() variants
+ *
+ *  SUMMA_BCAST_MPI hands each band to MPI_Bcast. SUMMA_BCAST_RING
+ *  sends it around the communicator, starting at the root, in
+ *  segments: every process forwards a segment to its successor as soon
+ *  as it has received it, so the segments of one band, and the bands
+ *  of successive panels, follow each other through the ring without a
+ *  collective synchronization in between.
+ *
+ *  Sends of the ring are not waited for when the broadcast returns.
+ *  They stay pending in the engine until the panel buffer they read
+ *  from is about to be overwritten (summa_bcast_release()).
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "summa.h"
+#include "summa_internal.h"
+
+#define SUMMA_BCAST_TAG 4242 /*!< Tag of the ring's point-to-point messages */
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+static int bcastAlgorithm = SUMMA_BCAST_MPI;
+static int bcastSegment = SUMMA_BCAST_SEGMENT_DEFAULT;
+
+/**
+ * Selects the broadcast used by summa() calls made from now on
+ **/
+void summa_set_bcast(int algorithm, int segmentSize) {
+
+    assert(algorithm == SUMMA_BCAST_MPI || algorithm == SUMMA_BCAST_RING);
+    assert(segmentSize > 0);
+
+    bcastAlgorithm = algorithm;
+    bcastSegment = segmentSize;
+}
+
+/**
+ * Returns the algorithm and segment size selected by summa_set_bcast()
+ **/
+void summa_get_bcast(int *algorithm, int *segmentSize) {
+
+    *algorithm = bcastAlgorithm;
+    *segmentSize = bcastSegment;
+}
+
+/**
+ * Sets up an engine on comm with the current selection
+ **/
+void summa_bcast_init(summa_bcast_t *bcast, MPI_Comm comm) {
+
+    bcast->comm = comm;
+    bcast->algorithm = bcastAlgorithm;
+    bcast->segmentSize = bcastSegment;
+    bcast->pending = 0;
+    bcast->capacity = 0;
+    bcast->requests = NULL;
+    bcast->keys = NULL;
+
+    MPI_Comm_rank(comm, &bcast->rank);
+    MPI_Comm_size(comm, &bcast->size);
+}
+
+/**
+ * Adds a pending send that reads from the buffer identified by key
+ **/
+static void push_request(summa_bcast_t *bcast, MPI_Request request,
+    const void *key) {
+
+    if(bcast->pending == bcast->capacity)
+    {
+        bcast->capacity = (bcast->capacity == 0) ? 16 : 2 * bcast->capacity;
+        bcast->requests = (MPI_Request *) realloc(bcast->requests,
+                bcast->capacity * sizeof(MPI_Request));
+        bcast->keys = (const void **) realloc(bcast->keys,
+                bcast->capacity * sizeof(const void *));
+        assert(bcast->requests != NULL && bcast->keys != NULL);
+    }
+
+    bcast->requests[bcast->pending] = request;
+    bcast->keys[bcast->pending] = key;
+    bcast->pending++;
+}
+
+/**
+ * Waits for the pending sends that read from the buffer key
+ **/
+void summa_bcast_release(summa_bcast_t *bcast, const void *key) {
+
+    int r;
+    int kept = 0;
+
+    for(r = 0; r < bcast->pending; ++r)
+    {
+        if(bcast->keys[r] == key)
+        {
+            MPI_Wait(&bcast->requests[r], MPI_STATUS_IGNORE);
+        }
+        else
+        {
+            bcast->requests[kept] = bcast->requests[r];
+            bcast->keys[kept] = bcast->keys[r];
+            kept++;
+        }
+    }
+
+    bcast->pending = kept;
+}
+
+/**
+ * Broadcasts count blocks of blocklen elements, stride elements apart,
+ *  starting at buffer
+ **/
+void summa_bcast(summa_bcast_t *bcast, const void *key, void *buffer,
+    int count, int blocklen, int stride, MPI_Datatype type, int root) {
+
+    int elemSize;
+    int perSegment;
+    int first;
+    int position;
+    int prev, next;
+    MPI_Datatype segmentType;
+
+    if(bcast->algorithm == SUMMA_BCAST_MPI || bcast->size == 1)
+    {
+        MPI_Type_vector(count, blocklen, stride, type, &segmentType);
+        MPI_Type_commit(&segmentType);
+
+        if(MPI_Bcast(buffer, 1, segmentType, root, bcast->comm))
+        {
+            fprintf(stderr, "[Rank %d] Error in MPI_Bcast\n", bcast->rank);
+            MPI_Finalize();
+        }
+
+        MPI_Type_free(&segmentType);
+        return;
+    }
+
+    /* Whole blocks per segment, at least one */
+    MPI_Type_size(type, &elemSize);
+    perSegment = bcast->segmentSize / (blocklen * elemSize);
+    if(perSegment < 1) perSegment = 1;
+
+    /* Position in the ring, counted from the root */
+    position = (bcast->rank - root + bcast->size) % bcast->size;
+    prev = (bcast->rank - 1 + bcast->size) % bcast->size;
+    next = (bcast->rank + 1) % bcast->size;
+
+    for(first = 0; first < count; first += perSegment)
+    {
+        int blocks = MIN(perSegment, count - first);
+        char *segment = (char *) buffer + (size_t) first * stride * elemSize;
+
+        MPI_Type_vector(blocks, blocklen, stride, type, &segmentType);
+        MPI_Type_commit(&segmentType);
+
+        if(position != 0)
+        {
+            MPI_Recv(segment, 1, segmentType, prev, SUMMA_BCAST_TAG,
+                    bcast->comm, MPI_STATUS_IGNORE);
+        }
+
+        if(position != bcast->size - 1)
+        {
+            MPI_Request request;
+
+            MPI_Isend(segment, 1, segmentType, next, SUMMA_BCAST_TAG,
+                    bcast->comm, &request);
+            push_request(bcast, request, key);
+        }
+
+        /* Pending sends keep their own reference to the type */
+        MPI_Type_free(&segmentType);
+    }
+}
+
+/**
+ * Completes every pending send and releases the engine
+ **/
+void summa_bcast_free(summa_bcast_t *bcast) {
+
+    if(bcast->pending > 0)
+        MPI_Waitall(bcast->pending, bcast->requests, MPI_STATUSES_IGNORE);
+
+    free(bcast->requests);
+    free(bcast->keys);
+
+    bcast->pending = 0;
+    bcast->capacity = 0;
+    bcast->requests = NULL;
+    bcast->keys = NULL;
+}
@@ -0,0 +1,343 @@
+/**
+ *  \file summa_chain.c
+ *  \brief Distributed matrix-chain multiply for Proj1
+ *
+ *  The split tree of summa_chain_order() is flattened into a list of
+ *  products in post order; product s reads two operands, inputs or the
+ *  results of earlier products, and writes a zeroed intermediate (C
+ *  for the last). The panels of all products are numbered as one
+ *  sequence and run through SUMMA_CHAIN_SLOTS panel buffers, as in
+ *  summa_async.cpp, except that the A and B halves of a panel are
+ *  started separately: a half is started as soon as it has a free
+ *  slot and its operand is complete. While the last panels of one
+ *  product are multiplied the next product's panels of any operand
+ *  that is already complete are in flight, and both halves of every
+ *  panel of a product that does not read the current one.
+ *
+ *  Every process starts the A halves, on rowComm, and the B halves, on
+ *  colComm, in panel order, so the broadcasts match whatever the
+ *  timing.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <mpi.h>
+
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+#include "summa_chain.h"
+
+#define SUMMA_CHAIN_SLOTS 2 /*!< Panels in flight */
+
+typedef struct {
+    int left, right; /* operands: < count an input, count + s product s */
+    int m, n, k, pb;
+    int firstPanel, panels;
+} chain_step_t;
+
+/**
+ * Panel width of a product with inner dimension k: the largest
+ *  divisor of k not above blockSize
+ **/
+static int panel_width(int k, int blockSize) {
+
+    int pb = (blockSize < k) ? blockSize : k;
+
+    while(k % pb != 0)
+        pb--;
+    return pb;
+}
+
+/**
+ * Predicted time of one product
+ **/
+static double step_cost(int m, int n, int k, int procGridX, int procGridY,
+        int blockSize, const summa_model_params_t *params) {
+
+    summa_model_params_t flops = { 0.0, 0.0, 1.0 };
+    summa_model_prediction_t prediction;
+
+    summa_model_predict(m, n, k, procGridX, procGridY,
+            panel_width(k, blockSize), (params != NULL) ? params : &flops,
+            &prediction);
+    return prediction.total;
+}
+
+/**
+ * Cheapest parenthesization of the chain
+ **/
+double summa_chain_order(int count, const int *dims, int procGridX,
+        int procGridY, int blockSize, const summa_model_params_t *params,
+        int *split) {
+
+    int i, j, s, length;
+    double total;
+    double *cost = (double *) calloc((size_t) count * count, sizeof(double));
+
+    assert(cost != NULL);
+
+    for(length = 2; length <= count; ++length)
+    {
+        for(i = 0; i + length <= count; ++i)
+        {
+            j = i + length - 1;
+            cost[i * count + j] = DBL_MAX;
+
+            for(s = i; s < j; ++s)
+            {
+                double c = cost[i * count + s] + cost[(s + 1) * count + j]
+                    + step_cost(dims[i], dims[j + 1], dims[s + 1], procGridX,
+                            procGridY, blockSize, params);
+
+                if(c < cost[i * count + j])
+                {
+                    cost[i * count + j] = c;
+                    split[i * count + j] = s;
+                }
+            }
+        }
+    }
+
+    total = cost[count - 1];
+    free(cost);
+    return total;
+}
+
+/**
+ * Appends text at *length, as far as size allows
+ **/
+static void append(char *buffer, int size, int *length, const char *text) {
+
+    int at = (*length < size) ? *length : size;
+
+    *length += snprintf(buffer + at, size - at, "%s", text);
+}
+
+/**
+ * Appends the parenthesization of M(i) to M(j) at *length
+ **/
+static void format_range(int count, const int *split, int i, int j,
+        char *buffer, int size, int *length) {
+
+    char name[16];
+
+    if(i == j)
+    {
+        snprintf(name, sizeof(name), "M%d", i);
+        append(buffer, size, length, name);
+        return;
+    }
+
+    append(buffer, size, length, "(");
+    format_range(count, split, i, split[i * count + j], buffer, size, length);
+    append(buffer, size, length, " ");
+    format_range(count, split, split[i * count + j] + 1, j, buffer, size, length);
+    append(buffer, size, length, ")");
+}
+
+/**
+ * Writes the parenthesization as text
+ **/
+int summa_chain_format(int count, const int *split, char *buffer, int size) {
+
+    int length = 0;
+
+    if(size > 0)
+        buffer[0] = '\0';
+    format_range(count, split, 0, count - 1, buffer, size, &length);
+    return length;
+}
+
+/**
+ * Appends the products of M(i) to M(j) in post order; returns the
+ *  operand holding the result
+ **/
+static int flatten(int count, const int *split, const int *dims, int i, int j,
+        chain_step_t *steps, int *nsteps) {
+
+    int left, right;
+    chain_step_t *step;
+
+    if(i == j)
+        return i;
+
+    left = flatten(count, split, dims, i, split[i * count + j], steps, nsteps);
+    right = flatten(count, split, dims, split[i * count + j] + 1, j, steps, nsteps);
+
+    step = &steps[*nsteps];
+    step->left = left;
+    step->right = right;
+    step->m = dims[i];
+    step->n = dims[j + 1];
+    step->k = dims[split[i * count + j] + 1];
+    return count + (*nsteps)++;
+}
+
+/**
+ * Matrix-chain SUMMA, C = M0 * M1 * ... * M(count-1) + C
+ **/
+void summa_chain(int count, const dist_matrix_t *const *mats,
+        dist_matrix_t *C, int blockSize, const summa_model_params_t *params) {
+
+    int i, s, nsteps = 0, total = 0;
+    int postedA = 0, postedB = 0, applied = 0, done = 0;
+    int px = C->procGridX;
+    int py = C->procGridY;
+    int maxRows = 0, maxCols = 0, maxPb = 0;
+    int *dims, *split, *panelStep;
+    double **data; /* local block of every operand */
+    double *bufferA[SUMMA_CHAIN_SLOTS], *bufferB[SUMMA_CHAIN_SLOTS];
+    MPI_Request *requestsA[SUMMA_CHAIN_SLOTS], *requestsB[SUMMA_CHAIN_SLOTS];
+    int countA[SUMMA_CHAIN_SLOTS], countB[SUMMA_CHAIN_SLOTS];
+    chain_step_t *steps;
+    summa_grid_t grid;
+
+    assert(count >= 1);
+    assert(mats[0]->m == C->m && mats[count - 1]->n == C->n);
+
+    dims = (int *) malloc((count + 1) * sizeof(int));
+    split = (int *) malloc((size_t) count * count * sizeof(int));
+    steps = (chain_step_t *) malloc(count * sizeof(chain_step_t));
+    data = (double **) calloc(2 * count, sizeof(double *));
+    assert(dims != NULL && split != NULL && steps != NULL && data != NULL);
+
+    for(i = 0; i < count; ++i)
+    {
+        const dist_matrix_t *M = mats[i];
+
+        assert(M->procGridX == px && M->procGridY == py);
+        assert(M->rowBlock * px == M->m && M->colBlock * py == M->n);
+        assert(i == 0 || mats[i - 1]->n == M->m);
+        dims[i] = M->m;
+        data[i] = M->data;
+    }
+    dims[count] = C->n;
+    assert(C->rowBlock * px == C->m && C->colBlock * py == C->n);
+
+    if(count == 1)
+    {
+        for(i = 0; i < C->localRows * C->localCols; ++i)
+            C->data[i] += mats[0]->data[i];
+        free(dims);
+        free(split);
+        free(steps);
+        free(data);
+        return;
+    }
+
+    summa_chain_order(count, dims, px, py, blockSize, params, split);
+    flatten(count, split, dims, 0, count - 1, steps, &nsteps);
+
+    for(s = 0; s < nsteps; ++s)
+    {
+        chain_step_t *step = &steps[s];
+
+        step->pb = panel_width(step->k, blockSize);
+        step->firstPanel = total;
+        step->panels = step->k / step->pb;
+        total += step->panels;
+
+        if(step->m / px > maxRows) maxRows = step->m / px;
+        if(step->n / py > maxCols) maxCols = step->n / py;
+        if(step->pb > maxPb) maxPb = step->pb;
+    }
+
+    panelStep = (int *) malloc(total * sizeof(int));
+    assert(panelStep != NULL);
+    for(s = 0; s < nsteps; ++s)
+        for(i = 0; i < steps[s].panels; ++i)
+            panelStep[steps[s].firstPanel + i] = s;
+
+    /* One grid and one set of panel buffers for every product */
+    summa_grid_create(px, py, &grid);
+    for(i = 0; i < SUMMA_CHAIN_SLOTS; ++i)
+    {
+        bufferA[i] = allocate_matrix(maxRows, maxPb);
+        bufferB[i] = allocate_matrix(maxPb, maxCols);
+        requestsA[i] = (MPI_Request *) malloc(maxPb * sizeof(MPI_Request));
+        requestsB[i] = (MPI_Request *) malloc(maxPb * sizeof(MPI_Request));
+        assert(requestsA[i] != NULL && requestsB[i] != NULL);
+    }
+
+    /* Intermediates start at zero; the last product accumulates into C */
+    for(s = 0; s < nsteps - 1; ++s)
+        data[count + s] = zeros_matrix(steps[s].m / px, steps[s].n / py);
+    data[count + nsteps - 1] = C->data;
+
+    while(applied < total)
+    {
+        chain_step_t *step;
+        int slot = applied % SUMMA_CHAIN_SLOTS;
+
+        /* Start every half with a free slot whose operand is complete;
+         * products complete in order, so product s is done when done > s */
+        while(postedA < total && postedA < applied + SUMMA_CHAIN_SLOTS)
+        {
+            step = &steps[panelStep[postedA]];
+            if(step->left >= count && step->left - count >= done)
+                break;
+
+            countA[postedA % SUMMA_CHAIN_SLOTS] = summa_ibcast_panel_A(&grid,
+                    step->m / px, step->k / py,
+                    (postedA - step->firstPanel) * step->pb, step->pb,
+                    data[step->left], step->m / px,
+                    bufferA[postedA % SUMMA_CHAIN_SLOTS], step->m / px,
+                    MPI_DOUBLE, requestsA[postedA % SUMMA_CHAIN_SLOTS]);
+            postedA++;
+        }
+        while(postedB < total && postedB < applied + SUMMA_CHAIN_SLOTS)
+        {
+            step = &steps[panelStep[postedB]];
+            if(step->right >= count && step->right - count >= done)
+                break;
+
+            countB[postedB % SUMMA_CHAIN_SLOTS] = summa_ibcast_panel_B(&grid,
+                    step->n / py, step->k / px,
+                    (postedB - step->firstPanel) * step->pb, step->pb,
+                    data[step->right], step->k / px,
+                    bufferB[postedB % SUMMA_CHAIN_SLOTS], step->pb,
+                    MPI_DOUBLE, requestsB[postedB % SUMMA_CHAIN_SLOTS]);
+            postedB++;
+        }
+
+        /* The operands of the oldest panel are complete, so it has started */
+        assert(postedA > applied && postedB > applied);
+        MPI_Waitall(countA[slot], requestsA[slot], MPI_STATUSES_IGNORE);
+        MPI_Waitall(countB[slot], requestsB[slot], MPI_STATUSES_IGNORE);
+
+        step = &steps[panelStep[applied]];
+        local_mm(step->m / px, step->n / py, step->pb, 1.0, bufferA[slot],
+                step->m / px, bufferB[slot], step->pb, 1.0,
+                data[count + panelStep[applied]], step->m / px);
+        applied++;
+
+        if(applied == step->firstPanel + step->panels)
+        {
+            /* Each intermediate is read by exactly one product */
+            if(step->left >= count)
+                deallocate_matrix(data[step->left]);
+            if(step->right >= count)
+                deallocate_matrix(data[step->right]);
+            done++;
+        }
+    }
+
+    summa_grid_free(&grid);
+
+    for(i = 0; i < SUMMA_CHAIN_SLOTS; ++i)
+    {
+        deallocate_matrix(bufferA[i]);
+        deallocate_matrix(bufferB[i]);
+        free(requestsA[i]);
+        free(requestsB[i]);
+    }
+    free(dims);
+    free(split);
+    free(steps);
+    free(data);
+    free(panelStep);
+}
@@ -0,0 +1,63 @@
+/**
+ *  \file summa_chain.h
+ *  \brief Distributed matrix-chain multiply for Proj1
+ *
+ *  summa_chain() multiplies M0 * M1 * ... * M(count-1), every factor
+ *  in the block layout of one grid, in the order summa_chain_order()
+ *  finds cheapest under the model of summa_model_predict().
+ *  Intermediate products stay distributed on the grid, in the same
+ *  layout, and all the products share one set of communicators and
+ *  panel buffers. The panels of all products form one stream, so the
+ *  broadcasts of the next product start while the last panels of the
+ *  current one are multiplied, for every operand that does not wait
+ *  on the current product.
+ */
+
+#ifndef SUMMA_CHAIN_H
+#define SUMMA_CHAIN_H
+
+#include "dist_matrix.h"
+#include "summa_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Cheapest parenthesization of a chain of count matrices, M(i) being
+ *  dims[i] by dims[i + 1]
+ *
+ *  A dynamic program over every split, each product costed by
+ *  summa_model_predict() on the procGridX by procGridY grid. params
+ *  NULL counts flops only, which gives the classic matrix-chain order.
+ *  split[i * count + j] is set to the s at which the product of M(i)
+ *  to M(j) is split, (M(i) ... M(s)) (M(s + 1) ... M(j)), for i < j;
+ *  split has count * count entries. Returns the predicted total.
+ **/
+double summa_chain_order(int count, const int *dims, int procGridX,
+    int procGridY, int blockSize, const summa_model_params_t *params,
+    int *split);
+
+/**
+ * Writes the parenthesization in split as "((M0 M1) M2)" into buffer,
+ *  as snprintf does, and returns the length of the full string
+ **/
+int summa_chain_format(int count, const int *split, char *buffer, int size);
+
+/**
+ * C = M0 * M1 * ... * M(count-1) + C
+ *
+ *  The factors and C must be in the block layout of one grid, as for
+ *  summa_dist(). Products are formed in the order summa_chain_order()
+ *  picks with params; a product whose inner dimension blockSize does
+ *  not divide uses the largest panel width below blockSize that does.
+ *  Collective over the grid.
+ **/
+void summa_chain(int count, const dist_matrix_t *const *mats,
+    dist_matrix_t *C, int blockSize, const summa_model_params_t *params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUMMA_CHAIN_H */
@@ -0,0 +1,313 @@
+/**
+ *  \file summa_dag.cpp
+ *  \brief Task-graph SUMMA with lookahead for Proj1
+ *
+ *  summa_dag() runs the panel loop of summa() as a graph of tasks:
+ *
+ *    post(p)       pack the local bands of panel p and start their
+ *                  MPI_Ibcast along the row and column communicators
+ *    arrive(p)     all broadcasts of panel p have completed
+ *    update(t, p)  C tile t += A panel p * B panel p
+ *
+ *  update(t, p) depends on arrive(p) and on update(t, p - 1), since both
+ *  write tile t. post(p) depends on every update(t, p - lookahead - 1),
+ *  whose panel buffer it reuses, so up to lookahead panels are in
+ *  flight while the current one is applied.
+ *
+ *  The calling thread is the only one that calls MPI: between updates
+ *  it posts panels and tests the outstanding broadcasts. The threads
+ *  of the local_mm() pool (mm_pool.h) take tiles from a ready queue;
+ *  a tile applies every panel that has arrived and is parked when it
+ *  catches up with the network, until arrive() requeues it. A rank
+ *  that falls behind, or a late broadcast, delays only the updates
+ *  that need it.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <mpi.h>
+
+#include "summa.h"
+#include "mm_core.hpp"
+
+namespace {
+
+/**
+ * Buffers of one panel in flight
+ **/
+struct dag_slot {
+  double *A; /* rows by pb */
+  double *B; /* pb by cols */
+  MPI_Request *requests; /* room for 2 * pb bands */
+  int count;
+  int applied; /* tiles that have applied the panel, atomic */
+};
+
+struct dag_state {
+  int rows, cols, k, pb, panels;
+  int procGridX, procGridY;
+  double *Ablock, *Bblock, *Cblock;
+  summa_grid_t grid;
+
+  int slots; /* lookahead + 1 */
+  dag_slot *slot;
+  int posted; /* panels posted, main thread only */
+  int arrived; /* panels arrived, in order; written under lock */
+
+  int rowTile, colTile, rowTiles, tiles;
+  int *next; /* next panel of each tile, owned by the thread running it */
+
+  pthread_mutex_t lock;
+  int *ready; /* FIFO of tiles that can run, tiles entries */
+  int readyHead, readyCount;
+  int *parked; /* tiles waiting for panel arrived */
+  int parkedCount;
+  int remaining; /* tiles with panels left */
+};
+
+/**
+ * Appends tile to the ready queue; called with lock held
+ **/
+void push_ready(dag_state *dag, int tile) {
+  dag->ready[(dag->readyHead + dag->readyCount) % dag->tiles] = tile;
+  dag->readyCount++;
+}
+
+/**
+ * post(p) for every panel whose slot is free, arrive(p) for every
+ *  panel whose broadcasts have completed; main thread only
+ **/
+void progress(dag_state *dag) {
+
+  /* Post: the slot's previous panel must be applied everywhere */
+  while (dag->posted < dag->panels) {
+    int p = dag->posted;
+    dag_slot *s = &dag->slot[p % dag->slots];
+
+    if (p >= dag->slots
+        && __atomic_load_n(&s->applied, __ATOMIC_ACQUIRE) < dag->tiles) {
+      break;
+    }
+
+    s->applied = 0;
+    s->count = summa_ibcast_panel_A(&dag->grid, dag->rows,
+        dag->k / dag->procGridY, p * dag->pb, dag->pb, dag->Ablock, dag->rows,
+        s->A, dag->rows, MPI_DOUBLE, s->requests);
+    s->count += summa_ibcast_panel_B(&dag->grid, dag->cols,
+        dag->k / dag->procGridX, p * dag->pb, dag->pb, dag->Bblock,
+        dag->k / dag->procGridX, s->B, dag->pb, MPI_DOUBLE,
+        s->requests + s->count);
+    dag->posted++;
+  }
+
+  /* Arrive, in panel order */
+  while (dag->arrived < dag->posted) {
+    dag_slot *s = &dag->slot[dag->arrived % dag->slots];
+    int done = 0;
+    int i;
+
+    MPI_Testall(s->count, s->requests, &done, MPI_STATUSES_IGNORE);
+    if (!done) {
+      break;
+    }
+
+    pthread_mutex_lock(&dag->lock);
+    __atomic_store_n(&dag->arrived, dag->arrived + 1, __ATOMIC_RELEASE);
+    for (i = 0; i < dag->parkedCount; i++) {
+      push_ready(dag, dag->parked[i]);
+    }
+    dag->parkedCount = 0;
+    pthread_mutex_unlock(&dag->lock);
+  }
+}
+
+/**
+ * update(t, p) for p = next[t], ... while the panels have arrived
+ **/
+void run_tile(dag_state *dag, int tile, int isMain) {
+
+  int row0 = (tile % dag->rowTiles) * dag->rowTile;
+  int col0 = (tile / dag->rowTiles) * dag->colTile;
+  int rows = (dag->rows - row0 < dag->rowTile) ? dag->rows - row0 : dag->rowTile;
+  int col1 = (dag->cols - col0 < dag->colTile) ? dag->cols : col0 + dag->colTile;
+  int p = dag->next[tile];
+
+  while (p < dag->panels && p < __atomic_load_n(&dag->arrived, __ATOMIC_ACQUIRE)) {
+    dag_slot *s = &dag->slot[p % dag->slots];
+
+    mm::gemm_columns<double, double, mm::traits<double>::MR,
+        mm::traits<double>::NR>(rows, col0, col1, dag->pb, 1.0, s->A + row0,
+        dag->rows, s->B, dag->pb, 1.0, dag->Cblock + row0, dag->rows);
+
+    __atomic_add_fetch(&s->applied, 1, __ATOMIC_RELEASE);
+    p++;
+
+    if (isMain) {
+      progress(dag);
+    }
+  }
+  dag->next[tile] = p;
+
+  pthread_mutex_lock(&dag->lock);
+  if (p == dag->panels) {
+    dag->remaining--;
+  } else if (p < dag->arrived) {
+    push_ready(dag, tile);
+  } else {
+    dag->parked[dag->parkedCount++] = tile;
+  }
+  pthread_mutex_unlock(&dag->lock);
+}
+
+/**
+ * Scheduler loop: runs ready tiles until every tile is done; the main
+ *  thread also drives the communication
+ **/
+void schedule(dag_state *dag, int isMain) {
+
+  for (;;) {
+    int tile = -1;
+    int remaining;
+
+    if (isMain) {
+      progress(dag);
+    }
+
+    pthread_mutex_lock(&dag->lock);
+    remaining = dag->remaining;
+    if (dag->readyCount > 0) {
+      tile = dag->ready[dag->readyHead];
+      dag->readyHead = (dag->readyHead + 1) % dag->tiles;
+      dag->readyCount--;
+    }
+    pthread_mutex_unlock(&dag->lock);
+
+    if (remaining == 0) {
+      break;
+    }
+
+    if (tile >= 0) {
+      run_tile(dag, tile, isMain);
+    } else {
+      sched_yield();
+    }
+  }
+}
+
+/**
+ * Pool task: a worker's scheduler loop
+ **/
+void worker_task(void *arg, int task) {
+  (void) task;
+  schedule((dag_state *) arg, 0);
+}
+
+} /* namespace */
+
+/**
+ * Task-graph SUMMA, computes C = A*B + C
+ *
+ *  Same distribution and arguments as summa(), plus the lookahead
+ *  depth: the number of panels broadcast ahead of the oldest panel
+ *  that is still being applied.
+ **/
+void summa_dag(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY, int pb, int lookahead) {
+
+    int i;
+    int threads;
+    int target;
+    int colTiles;
+    dag_state dag;
+    mm_job_t *job = NULL;
+
+    assert(k % pb == 0);
+    assert(lookahead >= 1);
+
+    dag.rows = m / procGridX;
+    dag.cols = n / procGridY;
+    dag.k = k;
+    dag.pb = pb;
+    dag.panels = k / pb;
+    dag.procGridX = procGridX;
+    dag.procGridY = procGridY;
+    dag.Ablock = Ablock;
+    dag.Bblock = Bblock;
+    dag.Cblock = Cblock;
+    dag.posted = 0;
+    dag.arrived = 0;
+
+    summa_grid_create(procGridX, procGridY, &dag.grid);
+
+    /* Panel buffers: the current panel plus lookahead in flight */
+    dag.slots = (lookahead + 1 < dag.panels) ? lookahead + 1 : dag.panels;
+    dag.slot = (dag_slot *) malloc(dag.slots * sizeof(dag_slot));
+    assert(dag.slot != NULL);
+    for(i = 0; i < dag.slots; ++i)
+    {
+        dag.slot[i].A = (double *) mm_alloc(dag.rows, pb, sizeof(double));
+        dag.slot[i].B = (double *) mm_alloc(pb, dag.cols, sizeof(double));
+        dag.slot[i].requests = (MPI_Request *) malloc(2 * pb * sizeof(MPI_Request));
+        dag.slot[i].count = 0;
+        dag.slot[i].applied = 0;
+        assert(dag.slot[i].requests != NULL);
+    }
+
+    /* C tiles, as for local_mm(): about four per thread */
+    threads = mm_pool_threads();
+    target = MM_TASKS_PER_THREAD * threads;
+    dag.colTile = mm::traits<double>::NR
+        * ((dag.cols / mm::traits<double>::NR + target) / target);
+    colTiles = (dag.cols + dag.colTile - 1) / dag.colTile;
+    dag.rowTiles = (target + colTiles - 1) / colTiles;
+    dag.rowTile = mm::traits<double>::MR
+        * ((dag.rows / mm::traits<double>::MR + dag.rowTiles) / dag.rowTiles);
+    if(dag.rowTile < 4 * mm::traits<double>::MR)
+        dag.rowTile = 4 * mm::traits<double>::MR;
+    dag.rowTiles = (dag.rows + dag.rowTile - 1) / dag.rowTile;
+    dag.tiles = dag.rowTiles * colTiles;
+    if(dag.rows == 0 || dag.cols == 0)
+        dag.tiles = 0;
+
+    pthread_mutex_init(&dag.lock, NULL);
+    dag.next = (int *) calloc(dag.tiles + 1, sizeof(int));
+    dag.ready = (int *) malloc((dag.tiles + 1) * sizeof(int));
+    dag.parked = (int *) malloc((dag.tiles + 1) * sizeof(int));
+    assert(dag.next != NULL && dag.ready != NULL && dag.parked != NULL);
+    dag.readyHead = 0;
+    dag.readyCount = 0;
+    dag.parkedCount = 0;
+    dag.remaining = dag.tiles;
+    for(i = 0; i < dag.tiles; ++i)
+        dag.parked[dag.parkedCount++] = i;
+
+    /* The other pool threads join in; this thread also drives MPI */
+    if(threads > 1 && dag.tiles > 1)
+        job = mm_pool_submit(worker_task, &dag, threads - 1);
+
+    schedule(&dag, 1);
+
+    /* Broadcasts to ranks with no C tiles still need to complete */
+    while(dag.arrived < dag.panels)
+        progress(&dag);
+
+    if(job != NULL)
+        mm_pool_wait(job);
+
+    summa_grid_free(&dag.grid);
+
+    for(i = 0; i < dag.slots; ++i)
+    {
+        free(dag.slot[i].A);
+        free(dag.slot[i].B);
+        free(dag.slot[i].requests);
+    }
+    free(dag.slot);
+    free(dag.next);
+    free(dag.ready);
+    free(dag.parked);
+    pthread_mutex_destroy(&dag.lock);
+}
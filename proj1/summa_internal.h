@@ -0,0 +1,181 @@
+/**
+ *  \file summa_internal.h
+ *  \brief Process grid and panel broadcasts shared by the summa() variants
+ *
+ *  Not part of the public interface; include summa.h instead.
+ */
+
+#ifndef SUMMA_INTERNAL_H
+#define SUMMA_INTERNAL_H
+
+#include <mpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Panel broadcast engine on one communicator (summa_bcast.c)
+ *
+ *  algorithm and segmentSize are copied from summa_set_bcast() when
+ *  the engine is created. requests holds the ring's pending sends,
+ *  keys the panel buffer each of them reads from.
+ **/
+typedef struct {
+  MPI_Comm comm;
+  int rank;
+  int size;
+  int algorithm;
+  int segmentSize;
+  int pending;
+  int capacity;
+  MPI_Request *requests;
+  const void **keys;
+} summa_bcast_t;
+
+/**
+ * Sets up an engine on comm with the current selection
+ **/
+void summa_bcast_init(summa_bcast_t *bcast, MPI_Comm comm);
+
+/**
+ * Broadcasts count blocks of blocklen elements of type, stride
+ *  elements apart, from root to every process of the engine's
+ *  communicator
+ *
+ *  key identifies the panel buffer that holds the data. With the ring
+ *  engine the call may return while sends from that buffer are still
+ *  in flight; it must not be written before summa_bcast_release(key).
+ **/
+void summa_bcast(summa_bcast_t *bcast, const void *key, void *buffer,
+    int count, int blocklen, int stride, MPI_Datatype type, int root);
+
+/**
+ * Waits for the pending sends that read from the panel buffer key
+ **/
+void summa_bcast_release(summa_bcast_t *bcast, const void *key);
+
+/**
+ * Completes every pending send and releases the engine
+ **/
+void summa_bcast_free(summa_bcast_t *bcast);
+
+/**
+ * A procGridX by procGridY process grid
+ *
+ *  Processes are numbered in column-major order, so rank
+ *   = indexY * procGridX + indexX.
+ *
+ *  rowComm holds the procGridY processes that share indexX, ordered
+ *   by indexY; colComm holds the procGridX processes that share
+ *   indexY, ordered by indexX.
+ **/
+typedef struct {
+  int rank;
+  int procGridX;
+  int procGridY;
+  int indexX;
+  int indexY;
+  MPI_Comm rowComm;
+  MPI_Comm colComm;
+  summa_bcast_t rowBcast;
+  summa_bcast_t colBcast;
+} summa_grid_t;
+
+/**
+ * Communicator the grid is laid out on, grid rank = rank in it
+ *  (summa_topo.c): MPI_COMM_WORLD unless summa_set_topology() reordered it
+ **/
+MPI_Comm summa_comm(void);
+
+/**
+ * Builds the row and column communicators of the grid
+ **/
+void summa_grid_create(int procGridX, int procGridY, summa_grid_t *grid);
+
+/**
+ * Completes the pending broadcasts and releases the communicators
+ *  of the grid
+ **/
+void summa_grid_free(summa_grid_t *grid);
+
+/**
+ * Width of the panel at kStart: at most pb and k - kStart, within one
+ *  band of widthA and one of widthB, so each half of the panel has a
+ *  single owner
+ **/
+int summa_panel_width(int k, int kStart, int widthA, int widthB, int pb);
+
+/**
+ * Broadcasts columns [kStart, kStart + width) of A along rowComm
+ *
+ *  Each process owns ownerWidth consecutive columns of A in Ablock
+ *   (rows by ownerWidth, leading dimension lda). A panel that
+ *   straddles two owners is sent as one broadcast per owner.
+ *
+ *  On return every process in the row holds the rows by width panel
+ *   in panel, with leading dimension ldp.
+ *
+ *  type is the MPI datatype of one element; panelIndex is only used
+ *   to label trace records.
+ *
+ *  panel may still be read by pending sends when the call returns
+ *   (see summa_bcast()); the next broadcast into the same panel
+ *   waits for them first.
+ **/
+void summa_bcast_panel_A(summa_grid_t *grid, int rows, int ownerWidth,
+    int kStart, int width, const void *Ablock, int lda, void *panel, int ldp,
+    MPI_Datatype type, int panelIndex);
+
+/**
+ * Broadcasts rows [kStart, kStart + width) of B along colComm
+ *
+ *  Each process owns ownerWidth consecutive rows of B in Bblock
+ *   (ownerWidth by cols, leading dimension ldb).
+ *
+ *  On return every process in the column holds the width by cols
+ *   panel in panel, with leading dimension ldp.
+ **/
+void summa_bcast_panel_B(summa_grid_t *grid, int cols, int ownerWidth,
+    int kStart, int width, const void *Bblock, int ldb, void *panel, int ldp,
+    MPI_Datatype type, int panelIndex);
+
+/**
+ * Starts the broadcasts of summa_bcast_panel_A() with MPI_Ibcast
+ *
+ *  Stores one request per band in requests, which needs room for
+ *   width requests, and returns their number. The root copies its
+ *   bands into panel before the call returns; panel is complete once
+ *   every request has completed.
+ **/
+int summa_ibcast_panel_A(const summa_grid_t *grid, int rows, int ownerWidth,
+    int kStart, int width, const void *Ablock, int lda, void *panel, int ldp,
+    MPI_Datatype type, MPI_Request *requests);
+
+/**
+ * Starts the broadcasts of summa_bcast_panel_B() with MPI_Ibcast
+ **/
+int summa_ibcast_panel_B(const summa_grid_t *grid, int cols, int ownerWidth,
+    int kStart, int width, const void *Bblock, int ldb, void *panel, int ldp,
+    MPI_Datatype type, MPI_Request *requests);
+
+/**
+ * Starts reading rows [row0, row0 + height) and columns
+ *  [col0, col0 + width) of a distributed matrix (summa_rma.c)
+ *
+ *  The matrix is split into blockRows by blockCols blocks, block
+ *   (x, y) on rank y * procGridX + x, as A, B and C are, and win
+ *   exposes every block on summa_comm() with a displacement unit of
+ *   one double. The piece is written to dest (leading dimension ldd)
+ *   with one MPI_Get per block it touches, and must be waited for with
+ *   MPI_Win_flush_local_all() inside a passive-target epoch.
+ **/
+void summa_get_block(MPI_Win win, int blockRows, int blockCols,
+    int procGridX, int row0, int col0, int height, int width, double *dest,
+    int ldd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUMMA_INTERNAL_H */
@@ -0,0 +1,188 @@
+/**
+ *  \file summa_model.c
+ *  \brief Analytic performance model of summa() for Proj1
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "matrix_utils.h"
+#include "local_mm.h"
+#include "summa.h"
+#include "summa_model.h"
+
+#define CALIBRATE_TRIALS 20 /*!< Number of timing trials per measurement */
+#define CALIBRATE_WORDS (1 << 16) /*!< Long message length, in words */
+#define CALIBRATE_N 128 /*!< Matrix dimension used to measure gamma */
+
+/**
+ * Number of rounds of a binomial-tree broadcast among p processes
+ **/
+static int ceil_log2(int p) {
+  int rounds = 0;
+
+  while ((1 << rounds) < p) {
+    rounds++;
+  }
+  return rounds;
+}
+
+static int gcd(int a, int b) {
+  while (b != 0) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/**
+ * Number of broadcasts summa() issues to move k columns in panels
+ *  of pb when each owner holds a contiguous band of ownerWidth
+ *
+ *  Every panel boundary and every owner boundary starts a new band,
+ *  boundaries shared by both are counted once.
+ **/
+static int count_bands(int k, int pb, int ownerWidth) {
+  int lcm = pb / gcd(pb, ownerWidth) * ownerWidth;
+
+  return k / pb + k / ownerWidth - k / lcm;
+}
+
+/**
+ * Predicts the time of summa(m, n, k, ..., px, py, pb)
+ **/
+void summa_model_predict(int m, int n, int k, int px, int py, int pb,
+    const summa_model_params_t *params, summa_model_prediction_t *prediction) {
+
+  double wordsA = (double) (m / px) * k; /* A words received per process */
+  double wordsB = (double) (n / py) * k; /* B words received per process */
+  double flops = 2.0 * (m / px) * (double) (n / py) * k;
+
+  assert(k % pb == 0);
+  assert(k % px == 0);
+  assert(k % py == 0);
+
+  prediction->bcastA = ceil_log2(py) * (count_bands(k, pb, k / py)
+      * params->alpha + wordsA * params->beta);
+  prediction->bcastB = ceil_log2(px) * (count_bands(k, pb, k / px)
+      * params->alpha + wordsB * params->beta);
+  prediction->compute = flops * params->gamma;
+
+  prediction->total = prediction->bcastA + prediction->bcastB
+      + prediction->compute;
+}
+
+/**
+ * Words each process receives in one multiply with one algorithm
+ **/
+double summa_model_volume(int m, int n, int k, int px, int py, int variant) {
+
+  double p = (double) px * py;
+  double rows = (double) (m / px);
+  double cols = (double) (n / py);
+
+  switch (variant) {
+  case SUMMA_STATIONARY_A:
+    return (double) (k / py) * n * (p - 1) / p + rows * n * (py - 1) / py;
+  case SUMMA_STATIONARY_B:
+    return (double) m * (k / px) * (p - 1) / p + m * cols * (px - 1) / px;
+  case SUMMA_INNER:
+    return ((double) m + n) * (k / p) * (p - 1) / p + rows * cols * (p - 1);
+  default:
+    return rows * k * (py - 1) / py + cols * k * (px - 1) / px;
+  }
+}
+
+/**
+ * Average time of one MPI_Bcast of len words on MPI_COMM_WORLD
+ **/
+static double time_bcast(double *buffer, int len) {
+  int trial;
+  double t_start;
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  t_start = MPI_Wtime();
+  for (trial = 0; trial < CALIBRATE_TRIALS; trial++) {
+    MPI_Bcast(buffer, len, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  } /* trial */
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  return (MPI_Wtime() - t_start) / CALIBRATE_TRIALS;
+}
+
+/**
+ * Measures alpha, beta and gamma on the current machine
+ **/
+void summa_model_calibrate(summa_model_params_t *params) {
+
+  int np = 0;
+  int rounds;
+  int trial;
+  double t_short, t_long, t_start;
+  double *A, *B, *C;
+  double *buffer;
+  double measured[3];
+
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+  rounds = ceil_log2(np);
+
+  /* Network: a short and a long broadcast give latency and bandwidth */
+  buffer = allocate_matrix(CALIBRATE_WORDS, 1);
+  time_bcast(buffer, 1); /* warm up */
+  t_short = time_bcast(buffer, 1);
+  t_long = time_bcast(buffer, CALIBRATE_WORDS);
+  deallocate_matrix(buffer);
+
+  if (rounds > 0) {
+    measured[0] = t_short / rounds;
+    measured[1] = (t_long - t_short) / rounds / (CALIBRATE_WORDS - 1);
+    if (measured[1] < 0.0) {
+      measured[1] = 0.0;
+    }
+  } else {
+    measured[0] = 0.0;
+    measured[1] = 0.0;
+  }
+
+  /* Processor: time local_mm() on a matrix that fits in cache */
+  A = random_matrix(CALIBRATE_N, CALIBRATE_N);
+  B = random_matrix(CALIBRATE_N, CALIBRATE_N);
+  C = zeros_matrix(CALIBRATE_N, CALIBRATE_N);
+
+  local_mm(CALIBRATE_N, CALIBRATE_N, CALIBRATE_N, 1.0, A, CALIBRATE_N, B,
+      CALIBRATE_N, 0.0, C, CALIBRATE_N); /* warm up */
+
+  t_start = MPI_Wtime();
+  for (trial = 0; trial < CALIBRATE_TRIALS; trial++) {
+    local_mm(CALIBRATE_N, CALIBRATE_N, CALIBRATE_N, 1.0, A, CALIBRATE_N, B,
+        CALIBRATE_N, 0.0, C, CALIBRATE_N);
+  } /* trial */
+  measured[2] = (MPI_Wtime() - t_start) / CALIBRATE_TRIALS
+      / (2.0 * CALIBRATE_N * CALIBRATE_N * CALIBRATE_N);
+
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+
+  /* Every process uses the parameters measured on rank 0 */
+  MPI_Bcast(measured, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+  params->alpha = measured[0];
+  params->beta = measured[1];
+  params->gamma = measured[2];
+}
+
+/**
+ * Compares a measured time against a prediction
+ **/
+double summa_model_deviation(const summa_model_prediction_t *prediction,
+    double measured) {
+
+  if (prediction->total <= 0.0) {
+    return 0.0;
+  }
+  return (measured - prediction->total) / prediction->total;
+}
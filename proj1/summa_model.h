@@ -0,0 +1,85 @@
+/**
+ *  \file summa_model.h
+ *  \brief Analytic performance model of summa() for Proj1
+ */
+
+#ifndef SUMMA_MODEL_H
+#define SUMMA_MODEL_H
+
+/**
+ * Machine parameters of the alpha-beta-gamma model
+ *
+ *  alpha - latency of one message, in seconds
+ *  beta  - inverse bandwidth, in seconds per double-precision word
+ *  gamma - time per floating-point operation, in seconds
+ **/
+typedef struct {
+  double alpha;
+  double beta;
+  double gamma;
+} summa_model_params_t;
+
+/**
+ * Predicted time of one summa() call, split by phase
+ *
+ *  bcastA  - broadcasting the panels of A along the row communicators
+ *  bcastB  - broadcasting the panels of B along the column communicators
+ *  compute - the local_mm() calls
+ *  total   - sum of the phases (summa() does not overlap them)
+ **/
+typedef struct {
+  double bcastA;
+  double bcastB;
+  double compute;
+  double total;
+} summa_model_prediction_t;
+
+/**
+ * Predicts the time of summa(m, n, k, ..., px, py, pb)
+ *
+ *  The model generalizes the square-grid, square-matrix model to a
+ *  px by py grid and an m by k times k by n product. Broadcasts are
+ *  modeled as binomial trees, so a broadcast of w words among p
+ *  processes costs ceil(log2(p)) * (alpha + beta * w).
+ *
+ *  A panel that straddles two owners is sent as one broadcast per
+ *  owner, which the message count accounts for.
+ **/
+void summa_model_predict(int m, int n, int k, int px, int py, int pb,
+    const summa_model_params_t *params, summa_model_prediction_t *prediction);
+
+/**
+ * Measures alpha, beta and gamma on the current machine
+ *
+ *  alpha and beta come from timing MPI_Bcast on MPI_COMM_WORLD,
+ *  gamma from timing local_mm(). Must be called by every process;
+ *  all processes receive the parameters measured on rank 0.
+ **/
+void summa_model_calibrate(summa_model_params_t *params);
+
+/**
+ * Compares a measured time against a prediction
+ *
+ *  Returns the relative deviation (measured - predicted) / predicted.
+ *  A deviation larger than the caller's tolerance usually points to a
+ *  performance bug rather than to the model.
+ **/
+double summa_model_deviation(const summa_model_prediction_t *prediction,
+    double measured);
+
+/**
+ * Words each process receives in one multiply with one of the
+ *  algorithms of summa_select()
+ *
+ *  A process is taken to own 1/p of what it needs from a group of p
+ *  processes. Stationary-C receives the panels of A along the row
+ *  and of B along the column; stationary-A reads k/py rows of all of
+ *  B from the whole grid and receives its share of the reduce-scatter
+ *  of partial C along the row; stationary-B is the transpose. The
+ *  one-dimensional algorithms move what stationary-C does. The
+ *  inner product reads k/p columns of A and rows of B and receives
+ *  p - 1 partial Cblocks.
+ **/
+double summa_model_volume(int m, int n, int k, int px, int py, int variant);
+
+#endif /* SUMMA_MODEL_H */
@@ -0,0 +1,147 @@
+/**
+ *  \file summa_multi.c
+ *  \brief Sum-of-products SUMMA for Proj1
+ *
+ *  C += A1*B1 + A2*B2 + ... is C += [A1 A2 ...] * [B1; B2; ...], so
+ *  one panel loop serves every term. Round r gathers panel r of each
+ *  term side by side: the A panels next to each other in one rows by
+ *  width buffer and the B panels on top of each other in one width by
+ *  cols buffer, where width is the sum of the terms' panel widths. One
+ *  local_mm() call per round applies all of them, so Cblock is read
+ *  and written once per round rather than once per term and panel.
+ *  The broadcasts of a round, every term's, are started together with
+ *  MPI_Ibcast, the next round's while the current one is multiplied.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "local_mm.h"
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+#include "summa_trace.h"
+
+#define SUMMA_MULTI_SLOTS 2 /*!< Rounds in flight */
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+/**
+ * Width of term t's panel in round r, 0 once the term is done
+ **/
+static int term_width(const int *k, int t, int r, int pb) {
+
+    return (r * pb < k[t]) ? MIN(pb, k[t] - r * pb) : 0;
+}
+
+/**
+ * Starts the broadcasts of round r into A and B; returns their number
+ **/
+static int post_round(summa_grid_t *grid, int terms, int m, int n,
+        const int *k, double *const *Ablocks, double *const *Bblocks, int r,
+        int pb, double *A, double *B, MPI_Request *requests) {
+
+    int t, count = 0, offset = 0, width = 0;
+    int rows = m / grid->procGridX;
+    int cols = n / grid->procGridY;
+
+    for(t = 0; t < terms; ++t)
+        width += term_width(k, t, r, pb);
+
+    for(t = 0; t < terms; ++t)
+    {
+        int w = term_width(k, t, r, pb);
+
+        if(w == 0)
+            continue;
+
+        count += summa_ibcast_panel_A(grid, rows, k[t] / grid->procGridY,
+                r * pb, w, Ablocks[t], rows, A + (size_t) offset * rows, rows,
+                MPI_DOUBLE, requests + count);
+        count += summa_ibcast_panel_B(grid, cols, k[t] / grid->procGridX,
+                r * pb, w, Bblocks[t], k[t] / grid->procGridX, B + offset,
+                width, MPI_DOUBLE, requests + count);
+        offset += w;
+    }
+
+    return count;
+}
+
+/**
+ * Sum-of-products SUMMA, C = A1*B1 + ... + C
+ **/
+void summa_multi(int terms, int m, int n, const int *k,
+        double *const *Ablocks, double *const *Bblocks, double *Cblock,
+        int procGridX, int procGridY, int pb) {
+
+    int r, s, t;
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int rounds = 0, kTotal = 0;
+    double *bufferA[SUMMA_MULTI_SLOTS], *bufferB[SUMMA_MULTI_SLOTS];
+    MPI_Request *requests[SUMMA_MULTI_SLOTS];
+    int count[SUMMA_MULTI_SLOTS];
+    summa_grid_t grid;
+
+    for(t = 0; t < terms; ++t)
+    {
+        assert(k[t] % procGridX == 0 && k[t] % procGridY == 0);
+        if((k[t] + pb - 1) / pb > rounds)
+            rounds = (k[t] + pb - 1) / pb;
+        kTotal += k[t];
+    }
+
+    if(summa_trace_enabled)
+        summa_trace_call(m, n, kTotal, procGridX, procGridY, pb);
+
+    summa_grid_create(procGridX, procGridY, &grid);
+
+    for(s = 0; s < SUMMA_MULTI_SLOTS; ++s)
+    {
+        bufferA[s] = allocate_matrix(rows, terms * pb);
+        bufferB[s] = allocate_matrix(terms * pb, cols);
+        /* A band per owner and side, at most one per column of a panel */
+        requests[s] = (MPI_Request *) malloc(2 * terms * pb * sizeof(MPI_Request));
+        assert(requests[s] != NULL);
+    }
+
+    for(r = 0; r < rounds && r < SUMMA_MULTI_SLOTS; ++r)
+        count[r] = post_round(&grid, terms, m, n, k, Ablocks, Bblocks, r, pb,
+                bufferA[r], bufferB[r], requests[r]);
+
+    for(r = 0; r < rounds; ++r)
+    {
+        int width = 0;
+        double t_start = 0.0;
+
+        s = r % SUMMA_MULTI_SLOTS;
+        for(t = 0; t < terms; ++t)
+            width += term_width(k, t, r, pb);
+
+        MPI_Waitall(count[s], requests[s], MPI_STATUSES_IGNORE);
+
+        if(summa_trace_enabled) t_start = MPI_Wtime();
+
+        local_mm(rows, cols, width, 1.0, bufferA[s], rows, bufferB[s], width,
+                1.0, Cblock, rows);
+
+        if(summa_trace_enabled)
+            summa_trace_compute(r, t_start, MPI_Wtime(), 2.0 * rows * cols * width);
+
+        if(r + SUMMA_MULTI_SLOTS < rounds)
+            count[s] = post_round(&grid, terms, m, n, k, Ablocks, Bblocks,
+                    r + SUMMA_MULTI_SLOTS, pb, bufferA[s], bufferB[s],
+                    requests[s]);
+    }
+
+    summa_grid_free(&grid);
+
+    for(s = 0; s < SUMMA_MULTI_SLOTS; ++s)
+    {
+        deallocate_matrix(bufferA[s]);
+        deallocate_matrix(bufferB[s]);
+        free(requests[s]);
+    }
+}
@@ -0,0 +1,304 @@
+/**
+ *  \file summa_panel.c
+ *  \brief Process grid and panel broadcasts shared by the summa() variants
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "summa_internal.h"
+#include "summa_trace.h"
+
+#define DEBUG_INFO 0
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+/**
+ * Builds the row and column communicators of the grid
+ **/
+void summa_grid_create(int procGridX, int procGridY, summa_grid_t *grid) {
+
+    int p;
+    int rowGroupIndex[procGridY];
+    int colGroupIndex[procGridX];
+
+    MPI_Group originalGroup, rowGroup, colGroup;
+
+    MPI_Comm_rank(summa_comm(), &grid->rank);
+    MPI_Comm_group(summa_comm(), &originalGroup);
+
+    grid->procGridX = procGridX;
+    grid->procGridY = procGridY;
+    grid->indexX = grid->rank % procGridX;
+    grid->indexY = (grid->rank - grid->indexX) / procGridX;
+
+    if(DEBUG_INFO) fprintf(stderr, "[Rank %d] indexX = %d, indexY = %d\n", grid->rank, grid->indexX, grid->indexY);
+
+    for(p = 0; p < procGridY; ++p)
+        rowGroupIndex[p] = p * procGridX + grid->indexX;
+
+    for(p = 0; p < procGridX; ++p)
+        colGroupIndex[p] = grid->indexY * procGridX + p;
+
+    /* Create groups */
+    if(MPI_Group_incl(originalGroup, procGridY, rowGroupIndex, &rowGroup))
+    {
+        fprintf(stderr, "Error creating group\n");
+        MPI_Finalize();
+    }
+    if(MPI_Group_incl(originalGroup, procGridX, colGroupIndex, &colGroup))
+    {
+        fprintf(stderr, "Error creating group\n");
+        MPI_Finalize();
+    }
+
+    /* Create communicators */
+    if(MPI_Comm_create(summa_comm(), rowGroup, &grid->rowComm))
+    {
+        fprintf(stderr, "Error creating group\n");
+        MPI_Finalize();
+    }
+
+    if(MPI_Comm_create(summa_comm(), colGroup, &grid->colComm))
+    {
+        fprintf(stderr, "Error creating group\n");
+        MPI_Finalize();
+    }
+
+    MPI_Group_free(&rowGroup);
+    MPI_Group_free(&colGroup);
+    MPI_Group_free(&originalGroup);
+
+    summa_bcast_init(&grid->rowBcast, grid->rowComm);
+    summa_bcast_init(&grid->colBcast, grid->colComm);
+
+    if(DEBUG_INFO) fprintf(stderr, "[Rank %d] Created communicators...\n", grid->rank);
+}
+
+/**
+ * Completes the pending broadcasts and releases the communicators
+ *  of the grid
+ **/
+void summa_grid_free(summa_grid_t *grid) {
+
+    summa_bcast_free(&grid->rowBcast);
+    summa_bcast_free(&grid->colBcast);
+
+    MPI_Comm_free(&grid->rowComm);
+    MPI_Comm_free(&grid->colComm);
+}
+
+/**
+ * Width of the panel at kStart within one band of each owner width
+ **/
+int summa_panel_width(int k, int kStart, int widthA, int widthB, int pb) {
+
+    int width = MIN(pb, k - kStart);
+
+    width = MIN(width, widthA - kStart % widthA);
+    return MIN(width, widthB - kStart % widthB);
+}
+
+/**
+ * Copies columns [localCnt, localCnt + lengthBand) of A's block to band
+ **/
+static void copy_band_A(char *band, int ldp, const void *Ablock, int lda,
+    int rows, int localCnt, int lengthBand, int elemSize) {
+
+    int c;
+
+    for(c = 0; c < lengthBand; ++c)
+    {
+        memcpy(band + (size_t) c * ldp * elemSize,
+                (const char *) Ablock + (size_t) (localCnt + c) * lda * elemSize,
+                (size_t) rows * elemSize);
+    }
+}
+
+/**
+ * Copies rows [localCnt, localCnt + lengthBand) of B's block to band,
+ *  one column at a time
+ **/
+static void copy_band_B(char *band, int ldp, const void *Bblock, int ldb,
+    int cols, int localCnt, int lengthBand, int elemSize) {
+
+    int c;
+
+    for(c = 0; c < cols; ++c)
+    {
+        memcpy(band + (size_t) c * ldp * elemSize,
+                (const char *) Bblock + ((size_t) c * ldb + localCnt) * elemSize,
+                (size_t) lengthBand * elemSize);
+    }
+}
+
+/**
+ * Broadcasts columns [kStart, kStart + width) of A along rowComm
+ **/
+void summa_bcast_panel_A(summa_grid_t *grid, int rows, int ownerWidth,
+    int kStart, int width, const void *Ablock, int lda, void *panel, int ldp,
+    MPI_Datatype type, int panelIndex) {
+
+    int elemSize;
+    int panelCnt = 0;
+
+    MPI_Type_size(type, &elemSize);
+
+    /* The previous panel broadcast from this buffer must be out */
+    summa_bcast_release(&grid->rowBcast, panel);
+
+    while(width > 0)
+    {
+        int whoseTurn = kStart / ownerWidth;
+        int localCnt = kStart % ownerWidth;
+        int lengthBand = MIN(ownerWidth - localCnt, width);
+        char *band = (char *) panel + (size_t) panelCnt * ldp * elemSize;
+        double t_start = 0.0;
+
+        if(grid->indexY == whoseTurn)
+            copy_band_A(band, ldp, Ablock, lda, rows, localCnt, lengthBand, elemSize);
+
+        if(summa_trace_enabled) t_start = MPI_Wtime();
+
+        summa_bcast(&grid->rowBcast, panel, band, lengthBand, rows, ldp, type, whoseTurn);
+
+        if(summa_trace_enabled)
+            summa_trace_bcast(SUMMA_TRACE_BCAST_A, panelIndex, t_start, MPI_Wtime(),
+                    (long) lengthBand * rows * elemSize, grid->procGridY, whoseTurn);
+
+        kStart += lengthBand;
+        width -= lengthBand;
+        panelCnt += lengthBand;
+    }
+}
+
+/**
+ * Broadcasts rows [kStart, kStart + width) of B along colComm
+ **/
+void summa_bcast_panel_B(summa_grid_t *grid, int cols, int ownerWidth,
+    int kStart, int width, const void *Bblock, int ldb, void *panel, int ldp,
+    MPI_Datatype type, int panelIndex) {
+
+    int elemSize;
+    int panelCnt = 0;
+
+    MPI_Type_size(type, &elemSize);
+
+    summa_bcast_release(&grid->colBcast, panel);
+
+    while(width > 0)
+    {
+        int whoseTurn = kStart / ownerWidth;
+        int localCnt = kStart % ownerWidth;
+        int lengthBand = MIN(ownerWidth - localCnt, width);
+        char *band = (char *) panel + (size_t) panelCnt * elemSize;
+        double t_start = 0.0;
+
+        if(grid->indexX == whoseTurn)
+            copy_band_B(band, ldp, Bblock, ldb, cols, localCnt, lengthBand, elemSize);
+
+        if(summa_trace_enabled) t_start = MPI_Wtime();
+
+        summa_bcast(&grid->colBcast, panel, band, cols, lengthBand, ldp, type, whoseTurn);
+
+        if(summa_trace_enabled)
+            summa_trace_bcast(SUMMA_TRACE_BCAST_B, panelIndex, t_start, MPI_Wtime(),
+                    (long) lengthBand * cols * elemSize, grid->procGridX, whoseTurn);
+
+        kStart += lengthBand;
+        width -= lengthBand;
+        panelCnt += lengthBand;
+    }
+}
+
+/**
+ * Starts the broadcasts of columns [kStart, kStart + width) of A
+ *  along rowComm, returns the number of requests
+ **/
+int summa_ibcast_panel_A(const summa_grid_t *grid, int rows, int ownerWidth,
+    int kStart, int width, const void *Ablock, int lda, void *panel, int ldp,
+    MPI_Datatype type, MPI_Request *requests) {
+
+    int elemSize;
+    int panelCnt = 0;
+    int count = 0;
+
+    MPI_Type_size(type, &elemSize);
+
+    while(width > 0)
+    {
+        int whoseTurn = kStart / ownerWidth;
+        int localCnt = kStart % ownerWidth;
+        int lengthBand = MIN(ownerWidth - localCnt, width);
+        char *band = (char *) panel + (size_t) panelCnt * ldp * elemSize;
+        MPI_Datatype bandType;
+
+        if(grid->indexY == whoseTurn)
+            copy_band_A(band, ldp, Ablock, lda, rows, localCnt, lengthBand, elemSize);
+
+        MPI_Type_vector(lengthBand, rows, ldp, type, &bandType);
+        MPI_Type_commit(&bandType);
+
+        if(MPI_Ibcast(band, 1, bandType, whoseTurn, grid->rowComm, &requests[count++]))
+        {
+            fprintf(stderr, "[Rank %d] Error in MPI_Ibcast\n", grid->rank);
+            MPI_Finalize();
+        }
+
+        /* The pending broadcast keeps its own reference */
+        MPI_Type_free(&bandType);
+
+        kStart += lengthBand;
+        width -= lengthBand;
+        panelCnt += lengthBand;
+    }
+
+    return count;
+}
+
+/**
+ * Starts the broadcasts of rows [kStart, kStart + width) of B
+ *  along colComm, returns the number of requests
+ **/
+int summa_ibcast_panel_B(const summa_grid_t *grid, int cols, int ownerWidth,
+    int kStart, int width, const void *Bblock, int ldb, void *panel, int ldp,
+    MPI_Datatype type, MPI_Request *requests) {
+
+    int elemSize;
+    int panelCnt = 0;
+    int count = 0;
+
+    MPI_Type_size(type, &elemSize);
+
+    while(width > 0)
+    {
+        int whoseTurn = kStart / ownerWidth;
+        int localCnt = kStart % ownerWidth;
+        int lengthBand = MIN(ownerWidth - localCnt, width);
+        char *band = (char *) panel + (size_t) panelCnt * elemSize;
+        MPI_Datatype bandType;
+
+        if(grid->indexX == whoseTurn)
+            copy_band_B(band, ldp, Bblock, ldb, cols, localCnt, lengthBand, elemSize);
+
+        MPI_Type_vector(cols, lengthBand, ldp, type, &bandType);
+        MPI_Type_commit(&bandType);
+
+        if(MPI_Ibcast(band, 1, bandType, whoseTurn, grid->colComm, &requests[count++]))
+        {
+            fprintf(stderr, "[Rank %d] Error in MPI_Ibcast\n", grid->rank);
+            MPI_Finalize();
+        }
+
+        MPI_Type_free(&bandType);
+
+        kStart += lengthBand;
+        width -= lengthBand;
+        panelCnt += lengthBand;
+    }
+
+    return count;
+}
@@ -0,0 +1,276 @@
+/**
+ *  \file summa_plan.c
+ *  \brief Persistent SUMMA plans for repeated multiplies of one shape
+ *
+ *  A plan holds everything summa() would otherwise rebuild on every
+ *  call: the row and column communicators, the list of bands each
+ *  panel is broadcast in, their datatypes, and two slots each for
+ *  A's and B's panels (rows by pb and pb by cols), as a
+ *  summa_request_t has. Panel i goes through slot i % 2, so every
+ *  band broadcast targets a fixed slice of one slot, and the plan
+ *  holds O(rows * pb + pb * cols) of panels whatever k is.
+ *
+ *  With MPI-4 each band is a persistent MPI_Bcast_init request.
+ *  Executing a plan starts the first two panels with MPI_Startall,
+ *  and each later panel once the multiply of the panel two before it
+ *  has freed its slot. Older MPI libraries start the same broadcasts
+ *  with MPI_Ibcast, still without validation, datatype setup or band
+ *  computation per call.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "local_mm.h"
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+#if MPI_VERSION >= 4
+#define SUMMA_PLAN_PERSISTENT 1
+#else
+#define SUMMA_PLAN_PERSISTENT 0
+#endif
+
+/**
+ * One broadcast of a plan
+ **/
+typedef struct {
+    void *buffer;
+    int isA;
+    int localCnt, length; /* columns of Ablock, or rows of Bblock, sent */
+    int count;
+    MPI_Datatype type; /* committed by the plan, or MPI_DOUBLE */
+    int root;
+    MPI_Comm comm;
+} plan_band_t;
+
+struct summa_plan {
+    int rows, cols, k, pb, panels;
+    int widthA, widthB; /* columns of A, rows of B, each process owns */
+    summa_grid_t grid;
+
+    double *slotA[2]; /* rows by pb, panel i of A in slotA[i % 2] */
+    double *slotB[2]; /* pb by cols, panel i of B in slotB[i % 2] */
+
+    int bands;
+    plan_band_t *band;
+    int *firstBand; /* bands of panel p: firstBand[p] to firstBand[p + 1] */
+    MPI_Request *requests;
+};
+
+/**
+ * Appends the bands of columns [kStart, kStart + pb) of A, or rows of
+ *  B, to the plan
+ **/
+static void add_bands(summa_plan_t plan, int isA, int kStart) {
+
+    int width = plan->pb;
+    int ownerWidth = isA ? plan->widthA : plan->widthB;
+    int offset = 0; /* column of the A slot, or row of the B slot */
+    int slot = (kStart / plan->pb) % 2;
+
+    while(width > 0)
+    {
+        int whoseTurn = kStart / ownerWidth;
+        int localCnt = kStart % ownerWidth;
+        int lengthBand = MIN(ownerWidth - localCnt, width);
+        plan_band_t *band = &plan->band[plan->bands++];
+
+        band->root = whoseTurn;
+        band->isA = isA;
+        band->localCnt = localCnt;
+        band->length = lengthBand;
+        if(isA)
+        {
+            /* Whole columns of a slot are contiguous */
+            band->buffer = plan->slotA[slot] + (size_t) offset * plan->rows;
+            band->count = lengthBand * plan->rows;
+            band->type = MPI_DOUBLE;
+            band->comm = plan->grid.rowComm;
+        }
+        else
+        {
+            band->buffer = plan->slotB[slot] + offset;
+            band->count = 1;
+            MPI_Type_vector(plan->cols, lengthBand, plan->pb, MPI_DOUBLE, &band->type);
+            MPI_Type_commit(&band->type);
+            band->comm = plan->grid.colComm;
+        }
+
+        kStart += lengthBand;
+        offset += lengthBand;
+        width -= lengthBand;
+    }
+}
+
+/**
+ * Sets up repeated multiplies of one shape
+ **/
+summa_plan_t summa_plan_create(int m, int n, int k, int procGridX,
+        int procGridY, int pb) {
+
+    int p, s;
+    summa_plan_t plan = (summa_plan_t) malloc(sizeof(struct summa_plan));
+
+    assert(plan != NULL);
+    assert(k % pb == 0);
+
+    plan->rows = m / procGridX;
+    plan->cols = n / procGridY;
+    plan->k = k;
+    plan->pb = pb;
+    plan->panels = k / pb;
+    plan->widthA = k / procGridY;
+    plan->widthB = k / procGridX;
+
+    summa_grid_create(procGridX, procGridY, &plan->grid);
+
+    for(s = 0; s < 2; ++s)
+    {
+        plan->slotA[s] = allocate_matrix(plan->rows, pb);
+        plan->slotB[s] = allocate_matrix(pb, plan->cols);
+    }
+
+    /* A panel is at most pb bands of A plus pb bands of B */
+    plan->bands = 0;
+    plan->band = (plan_band_t *) malloc(2 * k * sizeof(plan_band_t));
+    plan->firstBand = (int *) malloc((plan->panels + 1) * sizeof(int));
+    assert(plan->band != NULL && plan->firstBand != NULL);
+
+    for(p = 0; p < plan->panels; ++p)
+    {
+        plan->firstBand[p] = plan->bands;
+        add_bands(plan, 1, p * pb);
+        add_bands(plan, 0, p * pb);
+    }
+    plan->firstBand[plan->panels] = plan->bands;
+
+    plan->requests = (MPI_Request *) malloc((plan->bands + 1) * sizeof(MPI_Request));
+    assert(plan->requests != NULL);
+
+#if SUMMA_PLAN_PERSISTENT
+    for(p = 0; p < plan->bands; ++p)
+    {
+        plan_band_t *band = &plan->band[p];
+
+        MPI_Bcast_init(band->buffer, band->count, band->type, band->root,
+                band->comm, MPI_INFO_NULL, &plan->requests[p]);
+    }
+#endif
+
+    return plan;
+}
+
+/**
+ * Copies this process's bands of panel p into its slot and starts
+ *  the panel's broadcasts
+ **/
+static void start_panel(summa_plan_t plan, const double *Ablock,
+        const double *Bblock, int p) {
+
+    int b, c;
+    int first = plan->firstBand[p];
+    int last = plan->firstBand[p + 1];
+
+    for(b = first; b < last; ++b)
+    {
+        plan_band_t *band = &plan->band[b];
+        double *buffer = (double *) band->buffer;
+
+        if(band->isA && band->root == plan->grid.indexY)
+        {
+            /* Whole columns of Ablock are contiguous */
+            memcpy(buffer, Ablock + (size_t) band->localCnt * plan->rows,
+                    (size_t) band->length * plan->rows * sizeof(double));
+        }
+        else if(!band->isA && band->root == plan->grid.indexX)
+        {
+            for(c = 0; c < plan->cols; ++c)
+            {
+                memcpy(buffer + (size_t) c * plan->pb,
+                        Bblock + (size_t) c * plan->widthB + band->localCnt,
+                        band->length * sizeof(double));
+            }
+        }
+    }
+
+    /* In panel order, the same on every process */
+#if SUMMA_PLAN_PERSISTENT
+    MPI_Startall(last - first, plan->requests + first);
+#else
+    for(b = first; b < last; ++b)
+    {
+        plan_band_t *band = &plan->band[b];
+
+        MPI_Ibcast(band->buffer, band->count, band->type, band->root,
+                band->comm, &plan->requests[b]);
+    }
+#endif
+}
+
+/**
+ * Computes C = A*B + C with a plan
+ **/
+void summa_plan_execute(summa_plan_t plan, double *Ablock, double *Bblock,
+        double *Cblock) {
+
+    int p;
+
+    /* One panel in flight while the other is multiplied */
+    for(p = 0; p < 2 && p < plan->panels; ++p)
+        start_panel(plan, Ablock, Bblock, p);
+
+    for(p = 0; p < plan->panels; ++p)
+    {
+        int first = plan->firstBand[p];
+
+        MPI_Waitall(plan->firstBand[p + 1] - first, plan->requests + first,
+                MPI_STATUSES_IGNORE);
+
+        local_mm(plan->rows, plan->cols, plan->pb, 1.0,
+                plan->slotA[p % 2], plan->rows, plan->slotB[p % 2], plan->pb,
+                1.0, Cblock, plan->rows);
+
+        /* Slot p % 2 is free again */
+        if(p + 2 < plan->panels)
+            start_panel(plan, Ablock, Bblock, p + 2);
+    }
+}
+
+/**
+ * Releases a plan and sets *plan to NULL
+ **/
+void summa_plan_free(summa_plan_t *plan) {
+
+    int b, s;
+    summa_plan_t p = *plan;
+
+    for(b = 0; b < p->bands; ++b)
+    {
+#if SUMMA_PLAN_PERSISTENT
+        MPI_Request_free(&p->requests[b]);
+#endif
+        if(p->band[b].type != MPI_DOUBLE)
+            MPI_Type_free(&p->band[b].type);
+    }
+
+    summa_grid_free(&p->grid);
+
+    for(s = 0; s < 2; ++s)
+    {
+        deallocate_matrix(p->slotA[s]);
+        deallocate_matrix(p->slotB[s]);
+    }
+    free(p->band);
+    free(p->firstBand);
+    free(p->requests);
+    free(p);
+
+    *plan = NULL;
+}
@@ -0,0 +1,144 @@
+/**
+ *  \file summa_q8.c
+ *  \brief Quantized int8 SUMMA for Proj1
+ *
+ *  The loop of summa() on int8 blocks: panels of A and B are
+ *  broadcast as MPI_INT8_T, an eighth of the bytes of MPI_DOUBLE, and
+ *  multiplied into an int32 Cblock with local_mm_q8(). summa_q8()
+ *  wraps it for double-precision blocks: the scale of a row of A is
+ *  agreed along rowComm, which holds the whole row, and the scale of
+ *  a column of B along colComm, so every process quantizes its block
+ *  with the same scales as the rest of the row or column.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "mm_q8.h"
+#include "summa.h"
+#include "summa_internal.h"
+#include "summa_trace.h"
+
+/**
+ * The panel loop on a grid that is already set up
+ **/
+static void q8_panels(summa_grid_t *grid, int m, int n, int k,
+        const int8_t *Ablock, const int8_t *Bblock, int32_t *Cblock, int pb) {
+
+    int i;
+    int rows = m / grid->procGridX;
+    int cols = n / grid->procGridY;
+    double t_start = 0.0;
+    int8_t *bufferA[2], *bufferB[2];
+
+    for(i = 0; i < 2; ++i)
+    {
+        bufferA[i] = (int8_t *) malloc((size_t) rows * pb);
+        bufferB[i] = (int8_t *) malloc((size_t) pb * cols);
+        assert(bufferA[i] != NULL && bufferB[i] != NULL);
+    }
+
+    for(i = 0; i < k / pb; ++i)
+    {
+        int8_t *panelA = bufferA[i % 2];
+        int8_t *panelB = bufferB[i % 2];
+
+        summa_bcast_panel_A(grid, rows, k / grid->procGridY, i * pb, pb, Ablock,
+                rows, panelA, rows, MPI_INT8_T, i);
+        summa_bcast_panel_B(grid, cols, k / grid->procGridX, i * pb, pb, Bblock,
+                k / grid->procGridX, panelB, pb, MPI_INT8_T, i);
+
+        if(summa_trace_enabled) t_start = MPI_Wtime();
+
+        local_mm_q8(rows, cols, pb, panelA, rows, panelB, pb, 1, Cblock, rows);
+
+        if(summa_trace_enabled)
+            summa_trace_compute(i, t_start, MPI_Wtime(), 2.0 * rows * cols * pb);
+    }
+
+    /* Completes the sends still reading from the buffers */
+    summa_bcast_release(&grid->rowBcast, bufferA[0]);
+    summa_bcast_release(&grid->rowBcast, bufferA[1]);
+    summa_bcast_release(&grid->colBcast, bufferB[0]);
+    summa_bcast_release(&grid->colBcast, bufferB[1]);
+
+    for(i = 0; i < 2; ++i)
+    {
+        free(bufferA[i]);
+        free(bufferB[i]);
+    }
+}
+
+/**
+ * Int8 SUMMA, C = A*B + C exactly in int32
+ **/
+void summa_q8_int(int m, int n, int k, const int8_t *Ablock,
+        const int8_t *Bblock, int32_t *Cblock, int procGridX, int procGridY,
+        int pb) {
+
+    summa_grid_t grid;
+
+    assert(k % pb == 0);
+
+    if(summa_trace_enabled)
+        summa_trace_call(m, n, k, procGridX, procGridY, pb);
+
+    summa_grid_create(procGridX, procGridY, &grid);
+    q8_panels(&grid, m, n, k, Ablock, Bblock, Cblock, pb);
+    summa_grid_free(&grid);
+}
+
+/**
+ * SUMMA through int8, C = A*B + C approximately
+ **/
+void summa_q8(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY, int pb) {
+
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    int widthB = k / procGridX;
+    double *rowScale, *colScale;
+    int8_t *Aq, *Bq;
+    int32_t *Cq;
+    summa_grid_t grid;
+
+    assert(k % pb == 0);
+
+    if(summa_trace_enabled)
+        summa_trace_call(m, n, k, procGridX, procGridY, pb);
+
+    summa_grid_create(procGridX, procGridY, &grid);
+
+    rowScale = (double *) malloc(rows * sizeof(double));
+    colScale = (double *) malloc(cols * sizeof(double));
+    Aq = (int8_t *) malloc((size_t) rows * widthA);
+    Bq = (int8_t *) malloc((size_t) widthB * cols);
+    Cq = (int32_t *) calloc((size_t) rows * cols, sizeof(int32_t));
+    assert(rowScale != NULL && colScale != NULL && Aq != NULL && Bq != NULL
+            && Cq != NULL);
+
+    /* A row of A lies on rowComm, a column of B on colComm */
+    mm_q8_row_scales(rows, widthA, Ablock, rows, rowScale);
+    mm_q8_col_scales(widthB, cols, Bblock, widthB, colScale);
+    MPI_Allreduce(MPI_IN_PLACE, rowScale, rows, MPI_DOUBLE, MPI_MAX, grid.rowComm);
+    MPI_Allreduce(MPI_IN_PLACE, colScale, cols, MPI_DOUBLE, MPI_MAX, grid.colComm);
+
+    mm_q8_quantize_rows(rows, widthA, Ablock, rows, rowScale, Aq, rows);
+    mm_q8_quantize_cols(widthB, cols, Bblock, widthB, colScale, Bq, widthB);
+
+    q8_panels(&grid, m, n, k, Aq, Bq, Cq, pb);
+
+    mm_q8_dequantize(rows, cols, Cq, rows, rowScale, colScale, 1.0, 1.0,
+            Cblock, rows);
+
+    summa_grid_free(&grid);
+
+    free(rowScale);
+    free(colScale);
+    free(Aq);
+    free(Bq);
+    free(Cq);
+}
@@ -0,0 +1,219 @@
+/**
+ *  \file summa_rma.c
+ *  \brief One-sided, pull-based SUMMA for Proj1
+ *
+ *  Every process exposes its Ablock and its Bblock through two windows
+ *  on the grid communicator, summa_comm(). Instead of waiting for the
+ *  owner of a panel to broadcast it, a process reads the bands it
+ *  needs with MPI_Rget inside one passive-target epoch
+ *  (MPI_Win_lock_all), and keeps up to SUMMA_RMA_DEPTH panels in
+ *  flight. Owners take no part in the transfers, so processes in a
+ *  row or column no longer move in lockstep and a fast process runs
+ *  ahead as far as its prefetch depth.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "local_mm.h"
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+
+#define SUMMA_RMA_DEPTH 3 /*!< Panels fetched ahead, the current one included */
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+/**
+ * Starts the reads of columns [kStart, kStart + width) of A into
+ *  panel (rows by width), returns the number of requests
+ *
+ *  Columns of an Ablock are contiguous, so each band is one read.
+ **/
+static int get_panel_A(MPI_Win win, int rows, int ownerWidth, int kStart,
+    int width, double *panel, int firstOwner, int ownerStride,
+    MPI_Request *requests) {
+
+    int count = 0;
+    int panelCnt = 0;
+
+    while(width > 0)
+    {
+        int whoseTurn = kStart / ownerWidth;
+        int localCnt = kStart % ownerWidth;
+        int lengthBand = MIN(ownerWidth - localCnt, width);
+
+        MPI_Rget(panel + (size_t) panelCnt * rows, lengthBand * rows, MPI_DOUBLE,
+                firstOwner + whoseTurn * ownerStride, (MPI_Aint) localCnt * rows, lengthBand * rows, MPI_DOUBLE,
+                win, &requests[count++]);
+
+        kStart += lengthBand;
+        width -= lengthBand;
+        panelCnt += lengthBand;
+    }
+
+    return count;
+}
+
+/**
+ * Starts the reads of rows [kStart, kStart + width) of B into panel
+ *  (width by cols), returns the number of requests
+ **/
+static int get_panel_B(MPI_Win win, int cols, int ownerWidth, int kStart,
+    int width, double *panel, int firstOwner, int ownerStride,
+    MPI_Request *requests) {
+
+    int count = 0;
+    int panelCnt = 0;
+    int ldp = width;
+
+    while(width > 0)
+    {
+        int whoseTurn = kStart / ownerWidth;
+        int localCnt = kStart % ownerWidth;
+        int lengthBand = MIN(ownerWidth - localCnt, width);
+        MPI_Datatype originType, targetType;
+
+        /* The band is strided in the panel and in the owner's Bblock */
+        MPI_Type_vector(cols, lengthBand, ldp, MPI_DOUBLE, &originType);
+        MPI_Type_vector(cols, lengthBand, ownerWidth, MPI_DOUBLE, &targetType);
+        MPI_Type_commit(&originType);
+        MPI_Type_commit(&targetType);
+
+        MPI_Rget(panel + panelCnt, 1, originType,
+                firstOwner + whoseTurn * ownerStride, localCnt, 1,
+                targetType, win, &requests[count++]);
+
+        MPI_Type_free(&originType);
+        MPI_Type_free(&targetType);
+
+        kStart += lengthBand;
+        width -= lengthBand;
+        panelCnt += lengthBand;
+    }
+
+    return count;
+}
+
+/**
+ * Starts reading a piece of a distributed matrix, one MPI_Get per block
+ **/
+void summa_get_block(MPI_Win win, int blockRows, int blockCols,
+    int procGridX, int row0, int col0, int height, int width, double *dest,
+    int ldd) {
+
+    int col, row;
+
+    for(col = col0; col < col0 + width; )
+    {
+        int blockY = col / blockCols;
+        int colEnd = MIN((blockY + 1) * blockCols, col0 + width);
+
+        for(row = row0; row < row0 + height; )
+        {
+            int blockX = row / blockRows;
+            int rowEnd = MIN((blockX + 1) * blockRows, row0 + height);
+            MPI_Datatype originType, targetType;
+
+            MPI_Type_vector(colEnd - col, rowEnd - row, ldd, MPI_DOUBLE, &originType);
+            MPI_Type_vector(colEnd - col, rowEnd - row, blockRows, MPI_DOUBLE, &targetType);
+            MPI_Type_commit(&originType);
+            MPI_Type_commit(&targetType);
+
+            MPI_Get(dest + (size_t) (col - col0) * ldd + (row - row0), 1,
+                    originType, blockY * procGridX + blockX,
+                    (MPI_Aint) (col % blockCols) * blockRows + row % blockRows,
+                    1, targetType, win);
+
+            MPI_Type_free(&originType);
+            MPI_Type_free(&targetType);
+            row = rowEnd;
+        }
+        col = colEnd;
+    }
+}
+
+/**
+ * Pull-based SUMMA, computes C = A*B + C
+ **/
+void summa_rma(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY, int pb) {
+
+    int i, s;
+    int rank, indexX, indexY;
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    int widthB = k / procGridX;
+    int panels = k / pb;
+    int fetched = 0;
+
+    double *bufferA[SUMMA_RMA_DEPTH];
+    double *bufferB[SUMMA_RMA_DEPTH];
+    MPI_Request *requests[SUMMA_RMA_DEPTH];
+    int count[SUMMA_RMA_DEPTH];
+
+    MPI_Win winA, winB;
+
+    assert(k % pb == 0);
+
+    MPI_Comm_rank(summa_comm(), &rank);
+    indexX = rank % procGridX;
+    indexY = rank / procGridX;
+
+    /* Windows span the whole grid, not rowComm and colComm: band owner
+     * whoseTurn of A is rank whoseTurn * procGridX + indexX, of B rank
+     * indexY * procGridX + whoseTurn */
+    MPI_Win_create(Ablock, (MPI_Aint) rows * widthA * sizeof(double),
+            sizeof(double), MPI_INFO_NULL, summa_comm(), &winA);
+    MPI_Win_create(Bblock, (MPI_Aint) widthB * cols * sizeof(double),
+            sizeof(double), MPI_INFO_NULL, summa_comm(), &winB);
+
+    for(s = 0; s < SUMMA_RMA_DEPTH; ++s)
+    {
+        bufferA[s] = allocate_matrix(rows, pb);
+        bufferB[s] = allocate_matrix(pb, cols);
+        requests[s] = (MPI_Request *) malloc(2 * pb * sizeof(MPI_Request));
+        assert(requests[s] != NULL);
+    }
+
+    /* Nobody writes the blocks during the multiply, no locks conflict */
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, winA);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, winB);
+
+    for(i = 0; i < panels; ++i)
+    {
+        /* Keep SUMMA_RMA_DEPTH panels in flight */
+        while(fetched < panels && fetched < i + SUMMA_RMA_DEPTH)
+        {
+            s = fetched % SUMMA_RMA_DEPTH;
+            count[s] = get_panel_A(winA, rows, widthA, fetched * pb, pb,
+                    bufferA[s], indexX, procGridX, requests[s]);
+            count[s] += get_panel_B(winB, cols, widthB, fetched * pb, pb,
+                    bufferB[s], indexY * procGridX, 1, requests[s] + count[s]);
+            fetched++;
+        }
+
+        s = i % SUMMA_RMA_DEPTH;
+        MPI_Waitall(count[s], requests[s], MPI_STATUSES_IGNORE);
+
+        local_mm(rows, cols, pb, 1.0, bufferA[s], rows, bufferB[s], pb,
+                1.0, Cblock, rows);
+    }
+
+    MPI_Win_unlock_all(winA);
+    MPI_Win_unlock_all(winB);
+
+    /* Collective: no block is released while someone still reads it */
+    MPI_Win_free(&winA);
+    MPI_Win_free(&winB);
+
+    for(s = 0; s < SUMMA_RMA_DEPTH; ++s)
+    {
+        deallocate_matrix(bufferA[s]);
+        deallocate_matrix(bufferB[s]);
+        free(requests[s]);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ *  \file summa_select.c
+ *  \brief Choice of multiply algorithm by shape and grid for Proj1
+ *
+ *  summa_select() compares the modeled volume of every algorithm
+ *  (summa_model_volume()) and summa_run() calls the one it names, so
+ *  callers that do not care how the product is formed can use
+ *  summa_auto() for any shape.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "summa.h"
+#include "summa_model.h"
+
+/**
+ * The algorithm that moves the fewest words per process
+ **/
+int summa_select(int m, int n, int k, int procGridX, int procGridY) {
+
+    int algorithm;
+    int best = SUMMA_STATIONARY_C;
+    double volume = summa_model_volume(m, n, k, procGridX, procGridY, best);
+    static const int candidates[] = {SUMMA_STATIONARY_A, SUMMA_STATIONARY_B,
+        SUMMA_INNER};
+
+    /* Ties go to summa() */
+    for(algorithm = 0; algorithm < 3; ++algorithm)
+    {
+        double v = summa_model_volume(m, n, k, procGridX, procGridY,
+                candidates[algorithm]);
+
+        if(v < volume)
+        {
+            volume = v;
+            best = candidates[algorithm];
+        }
+    }
+
+    /* On a one-dimensional grid summa() moves the same words in
+     * k / blockSize broadcasts instead of one gather */
+    if(best == SUMMA_STATIONARY_C && procGridY == 1)
+        best = SUMMA_1D_ROW;
+    else if(best == SUMMA_STATIONARY_C && procGridX == 1)
+        best = SUMMA_1D_COL;
+
+    return best;
+}
+
+/**
+ * Computes C = A*B + C with the given algorithm
+ **/
+void summa_run(int algorithm, int m, int n, int k, double *Ablock,
+        double *Bblock, double *Cblock, int procGridX, int procGridY,
+        int blockSize) {
+
+    switch(algorithm)
+    {
+        case SUMMA_1D_ROW:
+            summa_1d_row(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY);
+            break;
+        case SUMMA_1D_COL:
+            summa_1d_col(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY);
+            break;
+        case SUMMA_INNER:
+            summa_inner(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY);
+            break;
+        default:
+            summa_stationary(algorithm, m, n, k, Ablock, Bblock, Cblock,
+                    procGridX, procGridY, blockSize);
+            break;
+    }
+}
+
+/**
+ * summa_run() with the algorithm of summa_select()
+ **/
+int summa_auto(int m, int n, int k, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY, int blockSize) {
+
+    int algorithm = summa_select(m, n, k, procGridX, procGridY);
+
+    summa_run(algorithm, m, n, k, Ablock, Bblock, Cblock, procGridX,
+            procGridY, blockSize);
+
+    return algorithm;
+}
@@ -0,0 +1,572 @@
+/**
+ *  \file summa_sim.c
+ *  \brief Trace-driven scaling simulator for summa()
+ *
+ *  Reads the per-rank traces written by summa_trace.c from a small
+ *  run, fits a per-rank compute rate and a LogGP network model, then
+ *  replays the broadcast/compute DAG of summa() on a (possibly much
+ *  larger) process grid with a discrete-event simulation.
+ *
+ *  Runs on a single machine and does not need MPI:
+ *
+ *    summa_sim [-m M] [-n N] [-k K] [-x PX] [-y PY] [-b PB]
+ *              [-L lat] [-o ovh] [-g gap] [-G gapPerByte] prefix
+ *
+ *  Dimensions default to the traced run; network parameters default
+ *  to the values fitted from the traced broadcasts.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NAME_LEN 256 /*!< Longest trace file name */
+#define LINE_LEN 256 /*!< Longest trace record */
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+
+/**
+ * LogGP network parameters, in seconds and seconds per byte
+ **/
+typedef struct {
+  double L;
+  double o;
+  double g;
+  double G;
+} loggp_t;
+
+/**
+ * What the traces tell us
+ **/
+typedef struct {
+  int dims[6]; /* m n k px py pb of the first traced call, the only
+                 shape fitted */
+  int ranks;
+  int calls;
+  double wall; /* measured time per call, slowest rank */
+  double *gamma; /* seconds per flop, per traced rank */
+} trace_fit_t;
+
+/**
+ * One operation of a rank's program: a broadcast band or a local_mm()
+ **/
+typedef struct {
+  char kind; /* 'A', 'B' or 'C' */
+  int root; /* index of the root within the communicator */
+  double amount; /* bytes (A, B) or flops (C) */
+} op_t;
+
+/**
+ * A message that reached a rank before the rank asked for it
+ **/
+typedef struct {
+  int op;
+  int src;
+  double arrival;
+  double sent; /* when the sender started the transfer */
+} arrival_t;
+
+/**
+ * Simulation state of one rank
+ **/
+typedef struct {
+  int next; /* next operation to run */
+  double cpu; /* time at which the processor is free */
+  double nic; /* time at which the next send may start */
+  int waiting; /* blocked on a receive for operation `next` */
+  arrival_t *pending;
+  int numPending, maxPending;
+} rank_state_t;
+
+/**
+ * Binding predecessor of (rank, op), used to walk the critical path
+ *
+ *  When isMsg is set the predecessor is (predRank, op) and predTime is
+ *  when that rank started the transfer; otherwise it is (rank, op - 1)
+ *  finishing at predTime.
+ **/
+typedef struct {
+  double predTime;
+  int predRank;
+  char isMsg;
+} node_t;
+
+/**
+ * Min-heap of (time, rank) wake-up events
+ **/
+typedef struct {
+  double *time;
+  int *rank;
+  int size, max;
+} heap_t;
+
+static void heap_push(heap_t *h, double time, int rank) {
+  int i;
+
+  if (h->size == h->max) {
+    h->max = (h->max == 0) ? 1024 : 2 * h->max;
+    h->time = realloc(h->time, sizeof(double) * h->max);
+    h->rank = realloc(h->rank, sizeof(int) * h->max);
+    assert(h->time != NULL && h->rank != NULL);
+  }
+
+  /* Sift up */
+  for (i = h->size++; i > 0 && h->time[(i - 1) / 2] > time; i = (i - 1) / 2) {
+    h->time[i] = h->time[(i - 1) / 2];
+    h->rank[i] = h->rank[(i - 1) / 2];
+  }
+  h->time[i] = time;
+  h->rank[i] = rank;
+}
+
+static int heap_pop(heap_t *h, double *time) {
+  int i = 0;
+  int top = h->rank[0];
+  double lastTime = h->time[--h->size];
+  int lastRank = h->rank[h->size];
+
+  *time = h->time[0];
+
+  /* Sift down */
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= h->size) {
+      break;
+    }
+    if (child + 1 < h->size && h->time[child + 1] < h->time[child]) {
+      child++;
+    }
+    if (h->time[child] >= lastTime) {
+      break;
+    }
+    h->time[i] = h->time[child];
+    h->rank[i] = h->rank[child];
+    i = child;
+  }
+  h->time[i] = lastTime;
+  h->rank[i] = lastRank;
+
+  return top;
+}
+
+static int ceil_log2(int p) {
+  int rounds = 0;
+
+  while ((1 << rounds) < p) {
+    rounds++;
+  }
+  return rounds;
+}
+
+/**
+ * Reads <prefix>.0, <prefix>.1, ... and fits the compute rate of each
+ *  rank and the LogGP parameters of the network
+ *
+ *  Only calls with the shape of the first call of rank 0 are used, so
+ *  the time per call is that of one shape; others are counted and
+ *  skipped.
+ **/
+static void read_traces(const char *prefix, trace_fit_t *fit, loggp_t *net) {
+
+  /* Fastest observed per-hop time for each message size */
+  int numSizes = 0, maxSizes = 64;
+  double *sizes = malloc(sizeof(double) * maxSizes);
+  double *hop = malloc(sizeof(double) * maxSizes);
+  double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+  double a, b;
+  int i, skipped = 0;
+
+  assert(sizes != NULL && hop != NULL);
+  memset(fit, 0, sizeof(trace_fit_t));
+
+  for (;;) {
+    char name[NAME_LEN];
+    char line[LINE_LEN];
+    double computeTime = 0.0, flops = 0.0;
+    double callEnd = 0.0, wall = 0.0;
+    int calls = 0, inShape = 0;
+    FILE *fp;
+
+    snprintf(name, NAME_LEN, "%s.%d", prefix, fit->ranks);
+    fp = fopen(name, "r");
+    if (fp == NULL) {
+      break;
+    }
+
+    while (fgets(line, LINE_LEN, fp) != NULL) {
+      char kind;
+      int panel, commSize, root;
+      double t_start, t_end, amount;
+      int d[6];
+
+      if (sscanf(line, "call %d %d %d %d %d %d", &d[0], &d[1], &d[2], &d[3],
+          &d[4], &d[5]) == 6) {
+        if (fit->ranks == 0 && calls == 0 && skipped == 0) {
+          memcpy(fit->dims, d, sizeof(d));
+        }
+        wall += callEnd;
+        callEnd = 0.0;
+        inShape = (memcmp(fit->dims, d, sizeof(d)) == 0);
+        if (inShape) {
+          calls++;
+        } else {
+          skipped++;
+        }
+      } else if (inShape && sscanf(line, "%c %d %lf %lf %lf %d %d", &kind,
+          &panel, &t_start, &t_end, &amount, &commSize, &root) >= 5) {
+        callEnd = MAX(callEnd, t_end);
+
+        if (kind == 'C') {
+          computeTime += t_end - t_start;
+          flops += amount;
+        } else if (commSize > 1) {
+          /* Keep the fastest per-hop time of each message size */
+          double perHop = (t_end - t_start) / ceil_log2(commSize);
+
+          for (i = 0; i < numSizes && sizes[i] != amount; i++)
+            ;
+          if (i == numSizes) {
+            if (numSizes == maxSizes) {
+              maxSizes *= 2;
+              sizes = realloc(sizes, sizeof(double) * maxSizes);
+              hop = realloc(hop, sizeof(double) * maxSizes);
+              assert(sizes != NULL && hop != NULL);
+            }
+            sizes[numSizes] = amount;
+            hop[numSizes++] = perHop;
+          } else {
+            hop[i] = MIN(hop[i], perHop);
+          }
+        }
+      }
+    }
+    wall += callEnd;
+    fclose(fp);
+
+    if (calls == 0 || flops == 0.0) {
+      fprintf(stderr, "%s: no summa() calls traced\n", name);
+      exit(1);
+    }
+
+    fit->gamma = realloc(fit->gamma, sizeof(double) * (fit->ranks + 1));
+    assert(fit->gamma != NULL);
+    fit->gamma[fit->ranks] = computeTime / flops;
+    fit->calls = calls;
+    fit->wall = MAX(fit->wall, wall / calls);
+    fit->ranks++;
+  }
+
+  if (fit->ranks == 0) {
+    fprintf(stderr, "No traces found at %s.0\n", prefix);
+    exit(1);
+  }
+  if (skipped > 0) {
+    fprintf(stderr, "Skipped %d traced calls of other shapes than "
+        "m=%d n=%d k=%d px=%d py=%d pb=%d\n", skipped, fit->dims[0],
+        fit->dims[1], fit->dims[2], fit->dims[3], fit->dims[4], fit->dims[5]);
+  }
+
+  /* Least-squares fit of perHop = a + b * bytes */
+  for (i = 0; i < numSizes; i++) {
+    sx += sizes[i];
+    sy += hop[i];
+    sxx += sizes[i] * sizes[i];
+    sxy += sizes[i] * hop[i];
+  }
+  if (numSizes >= 2 && numSizes * sxx - sx * sx > 0.0) {
+    b = (numSizes * sxy - sx * sy) / (numSizes * sxx - sx * sx);
+    a = (sy - b * sx) / numSizes;
+  } else if (numSizes == 1) {
+    b = 0.0;
+    a = sy;
+  } else {
+    a = 0.0;
+    b = 0.0;
+  }
+  a = MAX(a, 0.0);
+  b = MAX(b, 0.0);
+
+  /**
+   * A hop costs L + 2o + (s-1)G. Broadcast timings alone cannot tell
+   *  L from o, so split the fixed cost evenly between the wire and the
+   *  two endpoints and assume the gap equals the overhead.
+   **/
+  net->G = b;
+  net->o = (a + b) / 4.0;
+  net->L = (a + b) / 2.0;
+  net->g = net->o;
+
+  free(sizes);
+  free(hop);
+}
+
+/**
+ * Appends the bands that make up panel [start, start + pb) when each
+ *  owner holds ownerWidth consecutive indices, as summa() does
+ **/
+static int add_bands(op_t *ops, int numOps, char kind, int start, int pb,
+    int ownerWidth, double bytesPerIndex) {
+
+  while (pb > 0) {
+    int len = MIN(ownerWidth - start % ownerWidth, pb);
+
+    ops[numOps].kind = kind;
+    ops[numOps].root = start / ownerWidth;
+    ops[numOps].amount = len * bytesPerIndex;
+    numOps++;
+
+    start += len;
+    pb -= len;
+  }
+  return numOps;
+}
+
+/**
+ * Delivers a message for operation op to rank dst
+ **/
+static void deliver(rank_state_t *states, heap_t *events, int dst, int op,
+    int src, double sent, double arrival) {
+
+  rank_state_t *s = &states[dst];
+
+  if (s->numPending == s->maxPending) {
+    s->maxPending = (s->maxPending == 0) ? 4 : 2 * s->maxPending;
+    s->pending = realloc(s->pending, sizeof(arrival_t) * s->maxPending);
+    assert(s->pending != NULL);
+  }
+  s->pending[s->numPending].op = op;
+  s->pending[s->numPending].src = src;
+  s->pending[s->numPending].sent = sent;
+  s->pending[s->numPending].arrival = arrival;
+  s->numPending++;
+
+  if (s->waiting && s->next == op) {
+    s->waiting = 0;
+    heap_push(events, arrival, dst);
+  }
+}
+
+/**
+ * Simulates summa() and walks the critical path
+ **/
+static void simulate(int m, int n, int k, int px, int py, int pb,
+    const trace_fit_t *fit, const loggp_t *net) {
+
+  int P = px * py;
+  int maxOps = 3 * (k / pb) + px + py;
+  int numOps = 0;
+  op_t *ops = malloc(sizeof(op_t) * maxOps);
+  rank_state_t *states = calloc(P, sizeof(rank_state_t));
+  node_t *nodes;
+  heap_t events;
+  double wall = 0.0, t, pathTime[3] = { 0.0, 0.0, 0.0 };
+  int r, i, last = 0, hops = 0;
+
+  assert(ops != NULL && states != NULL);
+  memset(&events, 0, sizeof(heap_t));
+
+  /* Every rank runs the same program of bands and multiplies */
+  for (i = 0; i < k / pb; i++) {
+    numOps = add_bands(ops, numOps, 'A', i * pb, pb, k / py,
+        (double) (m / px) * sizeof(double));
+    numOps = add_bands(ops, numOps, 'B', i * pb, pb, k / px,
+        (double) (n / py) * sizeof(double));
+    ops[numOps].kind = 'C';
+    ops[numOps].root = 0;
+    ops[numOps].amount = 2.0 * (m / px) * (double) (n / py) * pb;
+    numOps++;
+  }
+
+  nodes = malloc(sizeof(node_t) * (size_t) P * numOps);
+  if (nodes == NULL) {
+    fprintf(stderr, "Not enough memory for %d ranks x %d operations\n", P,
+        numOps);
+    exit(1);
+  }
+
+  for (r = 0; r < P; r++) {
+    heap_push(&events, 0.0, r);
+  }
+
+  while (events.size > 0) {
+    r = heap_pop(&events, &t);
+
+    /* Run rank r until it blocks on a receive or finishes */
+    while (states[r].next < numOps) {
+      rank_state_t *s = &states[r];
+      int j = s->next;
+      op_t *op = &ops[j];
+      node_t *node = &nodes[(size_t) r * numOps + j];
+
+      node->predTime = s->cpu;
+      node->predRank = r;
+      node->isMsg = 0;
+
+      if (op->kind == 'C') {
+        s->cpu += op->amount * fit->gamma[r % fit->ranks];
+      } else {
+        /* Binomial tree, as in MPICH: position relative to the root */
+        int x = r % px;
+        int y = r / px;
+        int size = (op->kind == 'A') ? py : px;
+        int me = (op->kind == 'A') ? y : x;
+        int vrank = (me - op->root + size) % size;
+        int mask = 1;
+        double hop = (op->amount - 1.0) * net->G;
+
+        while (mask < size) {
+          if (vrank & mask) {
+            /* Receive from the parent */
+            int p;
+            for (p = 0; p < s->numPending && s->pending[p].op != j; p++)
+              ;
+            if (p == s->numPending) {
+              s->waiting = 1;
+              break;
+            }
+            if (s->pending[p].arrival > s->cpu) {
+              node->predTime = s->pending[p].sent;
+              node->predRank = s->pending[p].src;
+              node->isMsg = 1;
+            }
+            s->cpu = MAX(s->cpu, s->pending[p].arrival) + net->o;
+            s->pending[p] = s->pending[--s->numPending];
+            break;
+          }
+          mask <<= 1;
+        }
+        if (s->waiting) {
+          break;
+        }
+
+        /* Forward to the children, largest subtree first */
+        for (mask >>= 1; mask > 0; mask >>= 1) {
+          if (vrank + mask < size) {
+            int child = (vrank + mask + op->root) % size;
+            int dst = (op->kind == 'A') ? child * px + x : y * px + child;
+            double start = MAX(s->cpu, s->nic);
+
+            s->cpu = start + net->o;
+            s->nic = start + MAX(net->g, hop);
+            deliver(states, &events, dst, j, r, start,
+                start + net->o + hop + net->L);
+          }
+        }
+      }
+      s->next++;
+    }
+
+    if (states[r].next == numOps && states[r].cpu > wall) {
+      wall = states[r].cpu;
+      last = r;
+    }
+  }
+
+  /* Walk the critical path back from the rank that finished last */
+  r = last;
+  i = numOps - 1;
+  t = wall;
+  while (i >= 0) {
+    node_t *node = &nodes[(size_t) r * numOps + i];
+    int phase = (ops[i].kind == 'A') ? 0 : (ops[i].kind == 'B') ? 1 : 2;
+
+    pathTime[phase] += t - node->predTime;
+    t = node->predTime;
+    if (node->isMsg) {
+      r = node->predRank;
+      hops++;
+    } else {
+      i--;
+    }
+  }
+
+  printf("Target: m=%d n=%d k=%d px=%d py=%d pb=%d (%d ranks)\n", m, n, k, px,
+      py, pb, P);
+  printf("Predicted wall time: %lf s\n", wall);
+  printf("Critical path: row broadcasts %lf s, column broadcasts %lf s, "
+      "compute %lf s, %d message hops, ends on rank %d\n", pathTime[0],
+      pathTime[1], pathTime[2], hops, last);
+
+  for (r = 0; r < P; r++) {
+    free(states[r].pending);
+  }
+  free(states);
+  free(nodes);
+  free(ops);
+  free(events.time);
+  free(events.rank);
+}
+
+/** Program start */
+int main(int argc, char *argv[]) {
+  trace_fit_t fit;
+  loggp_t net, override = { -1.0, -1.0, -1.0, -1.0 };
+  int dims[6] = { 0, 0, 0, 0, 0, 0 };
+  double gammaMin, gammaMax, gammaSum = 0.0;
+  int opt, i;
+
+  while ((opt = getopt(argc, argv, "m:n:k:x:y:b:L:o:g:G:")) != -1) {
+    switch (opt) {
+    case 'm': dims[0] = atoi(optarg); break;
+    case 'n': dims[1] = atoi(optarg); break;
+    case 'k': dims[2] = atoi(optarg); break;
+    case 'x': dims[3] = atoi(optarg); break;
+    case 'y': dims[4] = atoi(optarg); break;
+    case 'b': dims[5] = atoi(optarg); break;
+    case 'L': override.L = atof(optarg); break;
+    case 'o': override.o = atof(optarg); break;
+    case 'g': override.g = atof(optarg); break;
+    case 'G': override.G = atof(optarg); break;
+    default:
+      fprintf(stderr, "Usage: %s [-m M] [-n N] [-k K] [-x PX] [-y PY] "
+          "[-b PB] [-L lat] [-o ovh] [-g gap] [-G gapPerByte] prefix\n",
+          argv[0]);
+      return 1;
+    }
+  }
+  if (optind != argc - 1) {
+    fprintf(stderr, "Missing trace prefix\n");
+    return 1;
+  }
+
+  read_traces(argv[optind], &fit, &net);
+
+  if (override.L >= 0.0) net.L = override.L;
+  if (override.o >= 0.0) net.o = override.o;
+  if (override.g >= 0.0) net.g = override.g;
+  if (override.G >= 0.0) net.G = override.G;
+
+  gammaMin = gammaMax = fit.gamma[0];
+  for (i = 0; i < fit.ranks; i++) {
+    gammaMin = MIN(gammaMin, fit.gamma[i]);
+    gammaMax = MAX(gammaMax, fit.gamma[i]);
+    gammaSum += fit.gamma[i];
+  }
+
+  printf("Traced: m=%d n=%d k=%d px=%d py=%d pb=%d, %d ranks, %d calls, "
+      "%lf s per call\n", fit.dims[0], fit.dims[1], fit.dims[2], fit.dims[3],
+      fit.dims[4], fit.dims[5], fit.ranks, fit.calls, fit.wall);
+  printf("Fitted: gamma=%le (min %le, max %le) L=%le o=%le g=%le G=%le\n",
+      gammaSum / fit.ranks, gammaMin, gammaMax, net.L, net.o, net.g, net.G);
+
+  /* Unspecified dimensions default to the traced run */
+  for (i = 0; i < 6; i++) {
+    if (dims[i] <= 0) {
+      dims[i] = fit.dims[i];
+    }
+  }
+
+  assert(dims[0] % dims[3] == 0);
+  assert(dims[1] % dims[4] == 0);
+  assert(dims[2] % dims[3] == 0);
+  assert(dims[2] % dims[4] == 0);
+  assert(dims[2] % dims[5] == 0);
+
+  simulate(dims[0], dims[1], dims[2], dims[3], dims[4], dims[5], &fit, &net);
+
+  free(fit.gamma);
+  return 0;
+}
@@ -0,0 +1,227 @@
+/**
+ *  \file summa_sparse.c
+ *  \brief SUMMA with a sparse A for Proj1
+ *
+ *  summa() broadcasts every element of every A panel. Here A is held
+ *  in compressed sparse rows and each panel travels as one message
+ *  holding only its nonzero rows:
+ *
+ *    val[nnz] | rowPtr[nrows + 1] | rowIds[nrows] | colIdx[nnz]
+ *
+ *  with colIdx relative to the panel. The panel boundaries are the
+ *  blockSize steps of k, also cut where an A or B band ends, so each
+ *  panel has one owner on either side. One MPI_Allreduce along rowComm
+ *  tells every process the size of every A panel of its row, and one
+ *  along colComm which B panels any process of the column will use;
+ *  A panels without nonzeros and B panels nobody in the column needs
+ *  are never sent. B and C stay dense.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "local_mm.h"
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+#include "summa_trace.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+/**
+ * Bytes of a packed panel
+ **/
+static size_t packed_size(int nnz, int nrows) {
+
+    return (size_t) nnz * sizeof(double) + (size_t) (2 * nrows + 1 + nnz) * sizeof(int);
+}
+
+/**
+ * Points csr at the arrays of a packed rows by width panel
+ **/
+static void unpack_panel(char *buffer, int rows, int width, int nnz,
+        int nrows, mm_csr_t *csr) {
+
+    csr->rows = rows;
+    csr->cols = width;
+    csr->nnz = nnz;
+    csr->nrows = nrows;
+    csr->val = (double *) buffer;
+    csr->rowPtr = (int *) (buffer + (size_t) nnz * sizeof(double));
+    csr->rowIds = csr->rowPtr + nrows + 1;
+    csr->colIdx = csr->rowIds + nrows;
+}
+
+/**
+ * Packs columns [col0, col0 + width) of A, advancing cursor (one
+ *  entry per stored row of A) past them; returns the buffer
+ **/
+static char *pack_panel(const mm_csr_t *A, int col0, int width, int *cursor,
+        int *nnzOut, int *nrowsOut) {
+
+    int r, p, nnz = 0, nrows = 0;
+    char *buffer;
+    mm_csr_t panel;
+
+    for(r = 0; r < A->nrows; ++r)
+    {
+        int count = 0;
+
+        for(p = cursor[r]; p < A->rowPtr[r + 1] && A->colIdx[p] < col0 + width; ++p)
+            count++;
+        nnz += count;
+        nrows += (count > 0);
+    }
+
+    buffer = (char *) malloc(packed_size(nnz, nrows));
+    assert(buffer != NULL);
+    unpack_panel(buffer, A->rows, width, nnz, nrows, &panel);
+
+    nnz = 0;
+    nrows = 0;
+    for(r = 0; r < A->nrows; ++r)
+    {
+        int start = nnz;
+
+        for(p = cursor[r]; p < A->rowPtr[r + 1] && A->colIdx[p] < col0 + width; ++p)
+        {
+            panel.val[nnz] = A->val[p];
+            panel.colIdx[nnz] = A->colIdx[p] - col0;
+            nnz++;
+        }
+        cursor[r] = p;
+
+        if(nnz > start)
+        {
+            panel.rowPtr[nrows] = start;
+            panel.rowIds[nrows] = (A->rowIds != NULL) ? A->rowIds[r] : r;
+            nrows++;
+        }
+    }
+    panel.rowPtr[nrows] = nnz;
+
+    *nnzOut = nnz;
+    *nrowsOut = nrows;
+    return buffer;
+}
+
+/**
+ * SUMMA with a sparse A, C = A*B + C
+ **/
+void summa_sparse(int m, int n, int k, const mm_csr_t *Ablock,
+        double *Bblock, double *Cblock, int procGridX, int procGridY, int pb) {
+
+    int i, panels, kStart;
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    int widthB = k / procGridX;
+    int *counts; /* nnz and stored rows of every A panel of the row */
+    int *needB; /* largest nnz of each panel over the column */
+    int *cursor;
+    size_t maxBytes = 1;
+    char **mine; /* packed panels of this process, NULL if not its own */
+    char *received;
+    double *panelB;
+    summa_grid_t grid;
+
+    assert(Ablock->rows == rows && Ablock->cols == widthA);
+
+    summa_grid_create(procGridX, procGridY, &grid);
+
+    panels = 0;
+    for(kStart = 0; kStart < k;
+            kStart += summa_panel_width(k, kStart, widthA, widthB, pb))
+        panels++;
+
+    counts = (int *) calloc(2 * panels, sizeof(int));
+    needB = (int *) malloc(panels * sizeof(int));
+    cursor = (int *) malloc((Ablock->nrows > 0 ? Ablock->nrows : 1) * sizeof(int));
+    mine = (char **) calloc(panels, sizeof(char *));
+    assert(counts != NULL && needB != NULL && cursor != NULL && mine != NULL);
+
+    for(i = 0; i < Ablock->nrows; ++i)
+        cursor[i] = Ablock->rowPtr[i];
+
+    /* Compress this process's panels, in column order */
+    for(i = 0, kStart = 0; i < panels; ++i)
+    {
+        int width = summa_panel_width(k, kStart, widthA, widthB, pb);
+
+        if(kStart / widthA == grid.indexY)
+            mine[i] = pack_panel(Ablock, kStart % widthA, width, cursor,
+                    &counts[2 * i], &counts[2 * i + 1]);
+        kStart += width;
+    }
+
+    /* Each panel has one owner in the row, the others contribute 0 */
+    MPI_Allreduce(MPI_IN_PLACE, counts, 2 * panels, MPI_INT, MPI_SUM, grid.rowComm);
+    for(i = 0; i < panels; ++i)
+    {
+        size_t bytes = packed_size(counts[2 * i], counts[2 * i + 1]);
+
+        needB[i] = counts[2 * i];
+        if(bytes > maxBytes)
+            maxBytes = bytes;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, needB, panels, MPI_INT, MPI_MAX, grid.colComm);
+
+    received = (char *) malloc(maxBytes);
+    panelB = allocate_matrix(MIN(pb, k), cols);
+    assert(received != NULL);
+
+    for(i = 0, kStart = 0; i < panels; ++i)
+    {
+        int width = summa_panel_width(k, kStart, widthA, widthB, pb);
+        int whoseTurn = kStart / widthA;
+        int nnz = counts[2 * i];
+        int nrows = counts[2 * i + 1];
+        double t_start = 0.0;
+
+        if(needB[i] > 0)
+            summa_bcast_panel_B(&grid, cols, widthB, kStart, width, Bblock,
+                    widthB, panelB, width, MPI_DOUBLE, i);
+
+        if(nnz > 0)
+        {
+            int bytes = (int) packed_size(nnz, nrows);
+            char *buffer = (grid.indexY == whoseTurn) ? mine[i] : received;
+            mm_csr_t panelA;
+
+            summa_bcast_release(&grid.rowBcast, received);
+
+            if(summa_trace_enabled) t_start = MPI_Wtime();
+
+            summa_bcast(&grid.rowBcast, received, buffer, 1, bytes, bytes,
+                    MPI_BYTE, whoseTurn);
+
+            if(summa_trace_enabled)
+            {
+                summa_trace_bcast(SUMMA_TRACE_BCAST_A, i, t_start, MPI_Wtime(),
+                        bytes, procGridY, whoseTurn);
+                t_start = MPI_Wtime();
+            }
+
+            unpack_panel(buffer, rows, width, nnz, nrows, &panelA);
+            local_spmm(cols, 1.0, &panelA, panelB, width, 1.0, Cblock, rows);
+
+            if(summa_trace_enabled)
+                summa_trace_compute(i, t_start, MPI_Wtime(), 2.0 * nnz * cols);
+        }
+
+        kStart += width;
+    }
+
+    summa_grid_free(&grid);
+
+    for(i = 0; i < panels; ++i)
+        free(mine[i]);
+    free(mine);
+    free(counts);
+    free(needB);
+    free(cursor);
+    free(received);
+    deallocate_matrix(panelB);
+}
@@ -0,0 +1,217 @@
+/**
+ *  \file summa_stationary.c
+ *  \brief Stationary-A and stationary-B SUMMA for Proj1
+ *
+ *  summa() keeps C in place and moves panels of A and B. When one
+ *  operand dominates, it is cheaper to keep that operand in place and
+ *  move the other one plus partial results of C instead:
+ *
+ *    stationary-A  process (x, y) multiplies its Ablock, columns
+ *                  [y * k/py, (y + 1) * k/py) of A, by the same rows of
+ *                  B for a panel of columns of every Cblock in its row,
+ *                  and MPI_Reduce_scatter_block along rowComm sums each
+ *                  partial panel on the process that owns it.
+ *    stationary-B  the transpose: process (x, y) multiplies rows
+ *                  [x * k/px, (x + 1) * k/px) of A by its Bblock for a
+ *                  panel of rows of every Cblock in its column, summed
+ *                  along colComm.
+ *
+ *  The rows of B (or columns of A) a process needs are spread over
+ *  the grid, so they are read with MPI_Get from windows on the
+ *  blocks, one panel ahead of the panel being multiplied.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mpi.h>
+
+#include "local_mm.h"
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+/**
+ * Stationary-A: blockSize columns of every Cblock in the row at a time
+ **/
+static void stationary_a(int m, int n, int k, double *Ablock,
+        double *Bblock, double *Cblock, int procGridX, int procGridY, int pb) {
+
+    int s, i;
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    int widthB = k / procGridX;
+    int panels = (cols + pb - 1) / pb;
+    double *panelB[2]; /* widthA by pb columns of each of the procGridY Cblocks */
+    double *partial; /* rows by the same columns */
+    double *sum; /* rows by pb, this process's share */
+    summa_grid_t grid;
+    MPI_Win winB;
+
+    summa_grid_create(procGridX, procGridY, &grid);
+
+    MPI_Win_create(Bblock, (MPI_Aint) widthB * cols * sizeof(double),
+            sizeof(double), MPI_INFO_NULL, summa_comm(), &winB);
+
+    panelB[0] = allocate_matrix(widthA, pb * procGridY);
+    panelB[1] = allocate_matrix(widthA, pb * procGridY);
+    partial = allocate_matrix(rows, pb * procGridY);
+    sum = allocate_matrix(rows, pb);
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, winB);
+
+    for(s = 0; s <= panels; ++s)
+    {
+        /* Read panel s while panel s - 1 is multiplied */
+        if(s < panels)
+        {
+            int c = s * pb;
+            int w = MIN(pb, cols - c);
+            int y;
+
+            for(y = 0; y < procGridY; ++y)
+            {
+                summa_get_block(winB, widthB, cols, procGridX,
+                        grid.indexY * widthA, y * cols + c, widthA, w,
+                        panelB[s % 2] + (size_t) y * w * widthA, widthA);
+            }
+        }
+
+        if(s > 0)
+        {
+            int c = (s - 1) * pb;
+            int w = MIN(pb, cols - c);
+
+            local_mm(rows, w * procGridY, widthA, 1.0, Ablock, rows,
+                    panelB[(s - 1) % 2], widthA, 0.0, partial, rows);
+
+            /* Piece y of partial belongs to rank y of rowComm */
+            MPI_Reduce_scatter_block(partial, sum, rows * w, MPI_DOUBLE,
+                    MPI_SUM, grid.rowComm);
+
+            for(i = 0; i < rows * w; ++i)
+                Cblock[(size_t) c * rows + i] += sum[i];
+        }
+
+        MPI_Win_flush_local_all(winB);
+    }
+
+    MPI_Win_unlock_all(winB);
+    MPI_Win_free(&winB);
+
+    deallocate_matrix(panelB[0]);
+    deallocate_matrix(panelB[1]);
+    deallocate_matrix(partial);
+    deallocate_matrix(sum);
+
+    summa_grid_free(&grid);
+}
+
+/**
+ * Stationary-B: blockSize rows of every Cblock in the column at a time
+ **/
+static void stationary_b(int m, int n, int k, double *Ablock,
+        double *Bblock, double *Cblock, int procGridX, int procGridY, int pb) {
+
+    int s, i, j, x;
+    int rows = m / procGridX;
+    int cols = n / procGridY;
+    int widthA = k / procGridY;
+    int widthB = k / procGridX;
+    int panels = (rows + pb - 1) / pb;
+    double *panelA[2]; /* procGridX pieces, pb rows by widthB */
+    double *partial; /* procGridX pieces, pb rows by cols */
+    double *sum; /* pb rows by cols, this process's share */
+    summa_grid_t grid;
+    MPI_Win winA;
+
+    summa_grid_create(procGridX, procGridY, &grid);
+
+    MPI_Win_create(Ablock, (MPI_Aint) rows * widthA * sizeof(double),
+            sizeof(double), MPI_INFO_NULL, summa_comm(), &winA);
+
+    panelA[0] = allocate_matrix(pb * procGridX, widthB);
+    panelA[1] = allocate_matrix(pb * procGridX, widthB);
+    partial = allocate_matrix(pb * procGridX, cols);
+    sum = allocate_matrix(pb, cols);
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, winA);
+
+    for(s = 0; s <= panels; ++s)
+    {
+        if(s < panels)
+        {
+            int r = s * pb;
+            int h = MIN(pb, rows - r);
+
+            for(x = 0; x < procGridX; ++x)
+            {
+                summa_get_block(winA, rows, widthA, procGridX, x * rows + r,
+                        grid.indexX * widthB, h, widthB,
+                        panelA[s % 2] + (size_t) x * h * widthB, h);
+            }
+        }
+
+        if(s > 0)
+        {
+            int r = (s - 1) * pb;
+            int h = MIN(pb, rows - r);
+            double *panel = panelA[(s - 1) % 2];
+
+            /* Pieces of partial are contiguous, one per rank of colComm */
+            for(x = 0; x < procGridX; ++x)
+            {
+                local_mm(h, cols, widthB, 1.0, panel + (size_t) x * h * widthB,
+                        h, Bblock, widthB, 0.0, partial + (size_t) x * h * cols, h);
+            }
+
+            MPI_Reduce_scatter_block(partial, sum, h * cols, MPI_DOUBLE,
+                    MPI_SUM, grid.colComm);
+
+            for(j = 0; j < cols; ++j)
+                for(i = 0; i < h; ++i)
+                    Cblock[(size_t) j * rows + r + i] += sum[j * h + i];
+        }
+
+        MPI_Win_flush_local_all(winA);
+    }
+
+    MPI_Win_unlock_all(winA);
+    MPI_Win_free(&winA);
+
+    deallocate_matrix(panelA[0]);
+    deallocate_matrix(panelA[1]);
+    deallocate_matrix(partial);
+    deallocate_matrix(sum);
+
+    summa_grid_free(&grid);
+}
+
+/**
+ * SUMMA with a choice of stationary operand, computes C = A*B + C
+ **/
+void summa_stationary(int variant, int m, int n, int k, double *Ablock,
+        double *Bblock, double *Cblock, int procGridX, int procGridY,
+        int blockSize) {
+
+    assert(blockSize > 0);
+
+    switch(variant)
+    {
+        case SUMMA_STATIONARY_A:
+            stationary_a(m, n, k, Ablock, Bblock, Cblock, procGridX,
+                    procGridY, blockSize);
+            break;
+        case SUMMA_STATIONARY_B:
+            stationary_b(m, n, k, Ablock, Bblock, Cblock, procGridX,
+                    procGridY, blockSize);
+            break;
+        default:
+            summa(m, n, k, Ablock, Bblock, Cblock, procGridX, procGridY,
+                    blockSize);
+            break;
+    }
+}
@@ -0,0 +1,237 @@
+/**
+ *  \file summa_topo.c
+ *  \brief Topology-aware placement of the SUMMA process grid for Proj1
+ *
+ *  By default grid rank r is MPI_COMM_WORLD rank r, indexX = r %
+ *  procGridX, so how the launcher numbered the ranks decides whether
+ *  a row or a column of the grid stays on one node.
+ *  summa_set_topology() learns the node (MPI_Comm_split_type), socket
+ *  and core (/sys) of every process, sorts the processes by that
+ *  locality and deals them out so that consecutive processes share
+ *  the communicator that carries more panel words: rowComm when the
+ *  A panels, m / procGridX by k, outweigh the B panels, k by
+ *  n / procGridY, colComm otherwise. The result is a reordered copy of
+ *  MPI_COMM_WORLD that every summa() variant builds its grid on.
+ */
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sched.h>
+#include <mpi.h>
+
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+
+static MPI_Comm gridComm = MPI_COMM_NULL; /*!< MPI_COMM_NULL: MPI_COMM_WORLD */
+
+/**
+ * Locality of one process, compared in this order
+ **/
+typedef struct {
+    int node; /* lowest MPI_COMM_WORLD rank on the node */
+    int socket;
+    int core;
+    int rank; /* MPI_COMM_WORLD rank */
+} locality_t;
+
+/**
+ * Reads an integer from a /sys file, -1 if it cannot
+ **/
+static int read_sys_int(const char *format, int cpu) {
+
+    char path[128];
+    FILE *file;
+    int value = -1;
+
+    snprintf(path, sizeof(path), format, cpu);
+    if((file = fopen(path, "r")) != NULL)
+    {
+        if(fscanf(file, "%d", &value) != 1)
+            value = -1;
+        fclose(file);
+    }
+    return value;
+}
+
+/**
+ * Locality of every process of comm, in rank order of comm
+ *
+ *  SUMMA_NODE_SIZE=<n> replaces the node discovery with blocks of n
+ *  consecutive MPI_COMM_WORLD ranks, to try placements on one machine.
+ **/
+static void gather_locality(MPI_Comm comm, locality_t *all) {
+
+    locality_t self;
+    MPI_Comm nodeComm;
+    int cpu = sched_getcpu();
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &self.rank);
+
+    if(getenv("SUMMA_NODE_SIZE") != NULL && atoi(getenv("SUMMA_NODE_SIZE")) > 0)
+    {
+        int nodeSize = atoi(getenv("SUMMA_NODE_SIZE"));
+
+        self.node = self.rank - self.rank % nodeSize;
+    }
+    else
+    {
+        self.node = self.rank;
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+                MPI_INFO_NULL, &nodeComm);
+        MPI_Allreduce(MPI_IN_PLACE, &self.node, 1, MPI_INT, MPI_MIN, nodeComm);
+        MPI_Comm_free(&nodeComm);
+    }
+
+    self.socket = read_sys_int(
+            "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    self.core = read_sys_int("/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+
+    MPI_Allgather(&self, 4, MPI_INT, all, 4, MPI_INT, comm);
+}
+
+static int compare_locality(const void *a, const void *b) {
+
+    const locality_t *x = (const locality_t *) a;
+    const locality_t *y = (const locality_t *) b;
+
+    if(x->node != y->node)
+        return (x->node < y->node) ? -1 : 1;
+    if(x->socket != y->socket)
+        return (x->socket < y->socket) ? -1 : 1;
+    if(x->core != y->core)
+        return (x->core < y->core) ? -1 : 1;
+    return (x->rank < y->rank) ? -1 : (x->rank > y->rank);
+}
+
+/**
+ * Communicator the process grid is built on
+ **/
+MPI_Comm summa_comm(void) {
+
+    return (gridComm == MPI_COMM_NULL) ? MPI_COMM_WORLD : gridComm;
+}
+
+/**
+ * This process's rank in the process grid
+ **/
+int summa_grid_rank(void) {
+
+    int rank;
+
+    MPI_Comm_rank(summa_comm(), &rank);
+    return rank;
+}
+
+/**
+ * Scatters mat from MPI_COMM_WORLD rank 0 in grid-rank order
+ **/
+void summa_distribute_matrix(int procGridX, int procGridY, int n, int m,
+        double *mat, double *block) {
+
+    /* The grid rank of the process holding mat */
+    int root = summa_grid_rank();
+
+    MPI_Bcast(&root, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    distribute_matrix_comm(procGridX, procGridY, n, m, mat, block,
+            summa_comm(), root);
+}
+
+/**
+ * Reorders the grid for the shape so the heavier communicator stays
+ *  within nodes
+ **/
+void summa_set_topology(int m, int n, int k, int procGridX, int procGridY) {
+
+    int i, np, worldRank, rank = 0;
+    int rowsFirst;
+    locality_t *all;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &np);
+    MPI_Comm_rank(MPI_COMM_WORLD, &worldRank);
+    assert(np == procGridX * procGridY);
+
+    summa_clear_topology();
+
+    all = (locality_t *) malloc(np * sizeof(locality_t));
+    assert(all != NULL);
+    gather_locality(MPI_COMM_WORLD, all);
+    qsort(all, np, sizeof(locality_t), compare_locality);
+
+    /* A panels travel along rowComm (same indexX), B along colComm */
+    rowsFirst = (double) (m / procGridX) * k > (double) k * (n / procGridY);
+
+    for(i = 0; i < np; ++i)
+    {
+        int indexX = rowsFirst ? i / procGridY : i % procGridX;
+        int indexY = rowsFirst ? i % procGridY : i / procGridX;
+
+        if(all[i].rank == worldRank)
+            rank = indexY * procGridX + indexX;
+    }
+    free(all);
+
+    MPI_Comm_split(MPI_COMM_WORLD, 0, rank, &gridComm);
+}
+
+/**
+ * Goes back to grid rank = MPI_COMM_WORLD rank
+ **/
+void summa_clear_topology(void) {
+
+    if(gridComm != MPI_COMM_NULL)
+        MPI_Comm_free(&gridComm);
+}
+
+/**
+ * Bytes of one summa() call that cross nodes with the current grid
+ **/
+double summa_topology_report(FILE *out, int m, int n, int k, int procGridX,
+        int procGridY) {
+
+    int x, y, other, np;
+    int nodes = 0;
+    double bytesA = 0.0, bytesB = 0.0;
+    double bandA = (double) (m / procGridX) * (k / procGridY) * sizeof(double);
+    double bandB = (double) (k / procGridX) * (n / procGridY) * sizeof(double);
+    locality_t *all;
+
+    MPI_Comm_size(summa_comm(), &np);
+    all = (locality_t *) malloc(np * sizeof(locality_t));
+    assert(all != NULL);
+    gather_locality(summa_comm(), all);
+
+    /* Every owner's band reaches every other process of its row or
+     * column once */
+    for(y = 0; y < procGridY; ++y)
+    {
+        for(x = 0; x < procGridX; ++x)
+        {
+            int node = all[y * procGridX + x].node;
+
+            for(other = 0; other < procGridY; ++other)
+                if(all[other * procGridX + x].node != node)
+                    bytesA += bandA;
+            for(other = 0; other < procGridX; ++other)
+                if(all[y * procGridX + other].node != node)
+                    bytesB += bandB;
+
+            if(node == all[y * procGridX + x].rank)
+                nodes++;
+        }
+    }
+    free(all);
+
+    if(out != NULL)
+    {
+        fprintf(out, "Topology: %s grid, nodes=%d, inter-node bytes "
+                "A=%.0lf B=%.0lf total=%.0lf\n",
+                (gridComm == MPI_COMM_NULL) ? "world-order" : "reordered",
+                nodes, bytesA, bytesB, bytesA + bytesB);
+    }
+
+    return bytesA + bytesB;
+}
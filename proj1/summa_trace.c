@@ -0,0 +1,148 @@
+/**
+ *  \file summa_trace.c
+ *  \brief Per-rank phase traces of summa() for Proj1
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "summa_trace.h"
+
+#define TRACE_NAME_LEN 256 /*!< Longest output file name */
+
+/**
+ * One trace record, see summa_trace.h for the meaning of the fields
+ **/
+typedef struct {
+  char kind; /* 'c' for a call, otherwise the phase */
+  int panel;
+  int dims[6]; /* m n k px py pb of a call record */
+  double t_start;
+  double t_end;
+  double amount; /* bytes or flops */
+  int commSize;
+  int root;
+} trace_record_t;
+
+int summa_trace_enabled = 0;
+
+static char trace_name[TRACE_NAME_LEN];
+static trace_record_t *records = NULL;
+static int num_records = 0;
+static int max_records = 0;
+static double origin = 0.0;
+
+/**
+ * Returns a fresh record at the end of the log
+ **/
+static trace_record_t *new_record(char kind) {
+
+  if (num_records == max_records) {
+    max_records = (max_records == 0) ? 1024 : 2 * max_records;
+    records = realloc(records, sizeof(trace_record_t) * max_records);
+    assert(records != NULL);
+  }
+
+  memset(&records[num_records], 0, sizeof(trace_record_t));
+  records[num_records].kind = kind;
+  return &records[num_records++];
+}
+
+/**
+ * Starts recording; output goes to <prefix>.<rank>
+ **/
+void summa_trace_start(const char *prefix) {
+  int rank = 0;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  snprintf(trace_name, TRACE_NAME_LEN, "%s.%d", prefix, rank);
+
+  num_records = 0;
+  summa_trace_enabled = 1;
+}
+
+/**
+ * Writes the recorded events and stops recording
+ **/
+void summa_trace_stop(void) {
+  FILE *fp = NULL;
+  int i;
+
+  if (!summa_trace_enabled) {
+    return;
+  }
+  summa_trace_enabled = 0;
+
+  fp = fopen(trace_name, "w");
+  assert(fp != NULL);
+
+  for (i = 0; i < num_records; i++) {
+    trace_record_t *r = &records[i];
+
+    if (r->kind == 'c') {
+      fprintf(fp, "call %d %d %d %d %d %d\n", r->dims[0], r->dims[1],
+          r->dims[2], r->dims[3], r->dims[4], r->dims[5]);
+    } else if (r->kind == SUMMA_TRACE_COMPUTE) {
+      fprintf(fp, "%c %d %.9lf %.9lf %.0lf\n", r->kind, r->panel, r->t_start,
+          r->t_end, r->amount);
+    } else {
+      fprintf(fp, "%c %d %.9lf %.9lf %.0lf %d %d\n", r->kind, r->panel,
+          r->t_start, r->t_end, r->amount, r->commSize, r->root);
+    }
+  } /* i */
+
+  fclose(fp);
+
+  free(records);
+  records = NULL;
+  num_records = 0;
+  max_records = 0;
+}
+
+/**
+ * Records the start of a summa() call, returns the time origin
+ **/
+double summa_trace_call(int m, int n, int k, int px, int py, int pb) {
+  trace_record_t *r = new_record('c');
+
+  r->dims[0] = m;
+  r->dims[1] = n;
+  r->dims[2] = k;
+  r->dims[3] = px;
+  r->dims[4] = py;
+  r->dims[5] = pb;
+
+  origin = MPI_Wtime();
+  return origin;
+}
+
+/**
+ * Records a broadcast (phase A or B) of bytes among commSize processes
+ **/
+void summa_trace_bcast(char phase, int panel, double t_start, double t_end,
+    long bytes, int commSize, int root) {
+  trace_record_t *r = new_record(phase);
+
+  r->panel = panel;
+  r->t_start = t_start - origin;
+  r->t_end = t_end - origin;
+  r->amount = (double) bytes;
+  r->commSize = commSize;
+  r->root = root;
+}
+
+/**
+ * Records a local_mm() of flops floating-point operations
+ **/
+void summa_trace_compute(int panel, double t_start, double t_end,
+    double flops) {
+  trace_record_t *r = new_record(SUMMA_TRACE_COMPUTE);
+
+  r->panel = panel;
+  r->t_start = t_start - origin;
+  r->t_end = t_end - origin;
+  r->amount = flops;
+}
@@ -0,0 +1,67 @@
+/**
+ *  \file summa_trace.h
+ *  \brief Per-rank phase traces of summa() for Proj1
+ *
+ *  When tracing is on, every summa() call appends one "call" record
+ *  and one record per broadcast and per local_mm() to an in-memory
+ *  log, which summa_trace_stop() writes to <prefix>.<rank>.
+ *  summa_sim replays these files on a single machine.
+ *
+ *  File format, one record per line:
+ *
+ *    call m n k px py pb
+ *    A panel t_start t_end bytes commSize root
+ *    B panel t_start t_end bytes commSize root
+ *    C panel t_start t_end flops
+ *
+ *  Times are MPI_Wtime() seconds relative to the start of the call.
+ */
+
+#ifndef SUMMA_TRACE_H
+#define SUMMA_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SUMMA_TRACE_BCAST_A 'A' /*!< Broadcast along the row communicator */
+#define SUMMA_TRACE_BCAST_B 'B' /*!< Broadcast along the column communicator */
+#define SUMMA_TRACE_COMPUTE 'C' /*!< local_mm() on one panel */
+
+/**
+ * Non-zero while tracing is on; summa() checks it before timing
+ **/
+extern int summa_trace_enabled;
+
+/**
+ * Starts recording; output goes to <prefix>.<rank>
+ **/
+void summa_trace_start(const char *prefix);
+
+/**
+ * Writes the recorded events and stops recording
+ **/
+void summa_trace_stop(void);
+
+/**
+ * Records the start of a summa() call, returns the time origin
+ **/
+double summa_trace_call(int m, int n, int k, int px, int py, int pb);
+
+/**
+ * Records a broadcast (phase A or B) of bytes among commSize processes
+ **/
+void summa_trace_bcast(char phase, int panel, double t_start, double t_end,
+    long bytes, int commSize, int root);
+
+/**
+ * Records a local_mm() of flops floating-point operations
+ **/
+void summa_trace_compute(int panel, double t_start, double t_end,
+    double flops);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUMMA_TRACE_H */
@@ -0,0 +1,255 @@
+/**
+ *  \file summa_tri.c
+ *  \brief Triangular and symmetric SUMMA for Proj1
+ *
+ *  summa() on a lower triangular A, or on C = A*A^T where C is
+ *  symmetric, moves and multiplies about twice the useful data:
+ *
+ *    summa_trmm  panel [kStart, kStart + width) of A is zero above row
+ *                kStart, so process rows above it are skipped, the
+ *                row it starts in broadcasts and multiplies only the
+ *                rows from kStart down, and the B panel goes only to
+ *                the processes of the column from that row down
+ *    summa_syrk  on a p by p grid only the blocks of C on or below the
+ *                diagonal are formed. Process (x, y) of that triangle
+ *                needs the panel of A row band x and, for B = A^T, the
+ *                panel of row band y: row band y's panel is broadcast
+ *                to the processes left of the diagonal in row y, and
+ *                the diagonal process (y, y) forwards it down column y.
+ *
+ *  Both broadcast on communicators of the part of a row or column that
+ *  takes part, split from rowComm and colComm once per call.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "local_mm.h"
+#include "matrix_utils.h"
+#include "summa.h"
+#include "summa_internal.h"
+
+/**
+ * Triangular SUMMA, C = L*B + C
+ **/
+void summa_trmm(int m, int n, double *Ablock, double *Bblock,
+        double *Cblock, int procGridX, int procGridY, int pb) {
+
+    int i, s, kStart;
+    int rows = m / procGridX; /* also the height of a band of B */
+    int cols = n / procGridY;
+    int widthA = m / procGridY;
+    double *bufferA[2], *bufferB[2];
+    MPI_Comm *tailComm; /* colComm from indexX = s down, s >= 1 */
+    summa_bcast_t *tailBcast;
+    summa_grid_t grid;
+
+    summa_grid_create(procGridX, procGridY, &grid);
+
+    tailComm = (MPI_Comm *) malloc(procGridX * sizeof(MPI_Comm));
+    tailBcast = (summa_bcast_t *) malloc(procGridX * sizeof(summa_bcast_t));
+    assert(tailComm != NULL && tailBcast != NULL);
+
+    for(s = 1; s < procGridX; ++s)
+    {
+        MPI_Comm_split(grid.colComm, (grid.indexX >= s) ? 0 : MPI_UNDEFINED,
+                grid.indexX, &tailComm[s]);
+        if(tailComm[s] != MPI_COMM_NULL)
+            summa_bcast_init(&tailBcast[s], tailComm[s]);
+    }
+
+    for(i = 0; i < 2; ++i)
+    {
+        bufferA[i] = allocate_matrix(rows, pb);
+        bufferB[i] = allocate_matrix(pb, cols);
+    }
+
+    for(i = 0, kStart = 0; kStart < m; ++i)
+    {
+        int width = summa_panel_width(m, kStart, widthA, rows, pb);
+        int diagX = kStart / rows; /* the row band the panel starts in */
+        int r0 = (grid.indexX == diagX) ? kStart - diagX * rows : 0;
+        double *panelA = bufferA[i % 2];
+        double *panelB = bufferB[i % 2];
+        summa_bcast_t *bcastB = (diagX == 0) ? &grid.colBcast : &tailBcast[diagX];
+
+        /* Rows above the panel's diagonal block hold only zeros */
+        if(grid.indexX < diagX)
+        {
+            kStart += width;
+            continue;
+        }
+
+        summa_bcast_panel_A(&grid, rows - r0, widthA, kStart, width,
+                Ablock + r0, rows, panelA, rows, MPI_DOUBLE, i);
+
+        /* This buffer may have gone out on any engine this process is in */
+        summa_bcast_release(&grid.colBcast, panelB);
+        for(s = 1; s <= grid.indexX; ++s)
+            summa_bcast_release(&tailBcast[s], panelB);
+
+        if(grid.indexX == diagX)
+        {
+            int c;
+
+            for(c = 0; c < cols; ++c)
+                memcpy(panelB + c * width, Bblock + c * rows + r0,
+                        width * sizeof(double));
+        }
+        summa_bcast(bcastB, panelB, panelB, cols, width, width, MPI_DOUBLE, 0);
+
+        if(grid.indexX == diagX)
+        {
+            local_mm_trmm(width, cols, 1.0, panelA, rows, panelB, width, 1.0,
+                    Cblock + r0, rows);
+            if(rows - r0 - width > 0)
+                local_mm(rows - r0 - width, cols, width, 1.0, panelA + width,
+                        rows, panelB, width, 1.0, Cblock + r0 + width, rows);
+        }
+        else
+        {
+            local_mm(rows, cols, width, 1.0, panelA, rows, panelB, width, 1.0,
+                    Cblock, rows);
+        }
+
+        kStart += width;
+    }
+
+    for(s = 1; s < procGridX; ++s)
+    {
+        if(tailComm[s] != MPI_COMM_NULL)
+        {
+            summa_bcast_free(&tailBcast[s]);
+            MPI_Comm_free(&tailComm[s]);
+        }
+    }
+    summa_grid_free(&grid);
+
+    for(i = 0; i < 2; ++i)
+    {
+        deallocate_matrix(bufferA[i]);
+        deallocate_matrix(bufferB[i]);
+    }
+    free(tailComm);
+    free(tailBcast);
+}
+
+/**
+ * Symmetric SUMMA, C = A*A^T + C on the lower triangle of C
+ **/
+void summa_syrk(int n, int k, double *Ablock, double *Cblock, int procGridX,
+        int procGridY, int pb) {
+
+    int i, j, p, kStart;
+    int rows = n / procGridX;
+    int widthA = k / procGridY;
+    int lower;
+    double *bufferA[2], *bufferB[2], *panelT;
+    MPI_Comm rowComm, colComm; /* the parts of rowComm and colComm on or
+                                  below the diagonal of the grid */
+    summa_bcast_t rowBcast, colBcast;
+    summa_grid_t grid;
+
+    assert(procGridX == procGridY);
+
+    summa_grid_create(procGridX, procGridY, &grid);
+    lower = (grid.indexX >= grid.indexY);
+
+    /* Ordered by indexY in a row (root x is the diagonal) and by
+     * indexX in a column (root 0 is the diagonal) */
+    MPI_Comm_split(grid.rowComm, lower ? 0 : MPI_UNDEFINED, grid.indexY, &rowComm);
+    MPI_Comm_split(grid.colComm, lower ? 0 : MPI_UNDEFINED, grid.indexX, &colComm);
+    if(lower)
+    {
+        summa_bcast_init(&rowBcast, rowComm);
+        summa_bcast_init(&colBcast, colComm);
+    }
+
+    for(i = 0; i < 2; ++i)
+    {
+        bufferA[i] = allocate_matrix(rows, pb);
+        bufferB[i] = allocate_matrix(rows, pb);
+    }
+    panelT = allocate_matrix(pb, rows);
+
+    for(i = 0, kStart = 0; kStart < k; ++i)
+    {
+        int width = summa_panel_width(k, kStart, widthA, widthA, pb);
+        int whoseTurn = kStart / widthA;
+        int root = whoseTurn;
+        double *panelA = bufferA[i % 2];
+        double *panelB = bufferB[i % 2];
+        const double *band = Ablock + (size_t) (kStart % widthA) * rows;
+
+        if(lower)
+            summa_bcast_release(&rowBcast, panelA);
+
+        /* An owner right of the diagonal hands the panel to the
+         * diagonal process, which broadcasts it along the row */
+        if(whoseTurn > grid.indexX)
+        {
+            root = grid.indexX;
+            if(grid.indexY == whoseTurn)
+                MPI_Send(band, rows * width, MPI_DOUBLE, grid.indexX, i,
+                        grid.rowComm);
+            else if(grid.indexY == grid.indexX)
+                MPI_Recv(panelA, rows * width, MPI_DOUBLE, whoseTurn, i,
+                        grid.rowComm, MPI_STATUS_IGNORE);
+        }
+        else if(grid.indexY == whoseTurn)
+        {
+            memcpy(panelA, band, (size_t) rows * width * sizeof(double));
+        }
+
+        if(!lower)
+        {
+            kStart += width;
+            continue;
+        }
+
+        summa_bcast(&rowBcast, panelA, panelA, 1, rows * width, rows * width,
+                MPI_DOUBLE, root);
+
+        /* The diagonal's panel is row band indexY of A, B = its transpose */
+        summa_bcast_release(&colBcast, panelB);
+        if(grid.indexX == grid.indexY)
+            memcpy(panelB, panelA, (size_t) rows * width * sizeof(double));
+        summa_bcast(&colBcast, panelB, panelB, 1, rows * width, rows * width,
+                MPI_DOUBLE, 0);
+
+        if(grid.indexX == grid.indexY)
+        {
+            local_mm_syrk(rows, width, 1.0, panelA, rows, 1.0, Cblock, rows);
+        }
+        else
+        {
+            for(j = 0; j < rows; ++j)
+                for(p = 0; p < width; ++p)
+                    panelT[j * width + p] = panelB[p * rows + j];
+
+            local_mm(rows, rows, width, 1.0, panelA, rows, panelT, width, 1.0,
+                    Cblock, rows);
+        }
+
+        kStart += width;
+    }
+
+    if(lower)
+    {
+        summa_bcast_free(&rowBcast);
+        summa_bcast_free(&colBcast);
+        MPI_Comm_free(&rowComm);
+        MPI_Comm_free(&colComm);
+    }
+    summa_grid_free(&grid);
+
+    for(i = 0; i < 2; ++i)
+    {
+        deallocate_matrix(bufferA[i]);
+        deallocate_matrix(bufferB[i]);
+    }
+    deallocate_matrix(panelT);
+}
@@ -9,10 +9,17 @@
 #include <assert.h>
 #include <time.h>
 #include <math.h>
+#include <unistd.h>
 #include <mpi.h>
 
 #include "matrix_utils.h"
 #include "local_mm.h"
+#include "mm_numa.h"
+#include "mm_q8.h"
+#include "mm_epilogue.h"
+#include "mm_ooc.h"
+#include "mm_jit.h"
+#include "mm_blas.h"
 
 #define NUM_TRIALS 25 /*!< Number of timing trials */
 
@@ -52,6 +59,325 @@ void random_multiply(int m, int n, int k, int iterations) {
   printf("Conf: %d, %d, %d, %lf, %lf\n", m, n, k, t_elapsed, t_elapsed / iterations);
 }
 
+/**
+ * Times local_mm_q8() with every int8 kernel the CPU has, on the
+ *  shape random_multiply() timed
+ **/
+void random_multiply_q8(int m, int n, int k, int iterations) {
+  int i, iter, isa, best;
+  int8_t *A, *B;
+  int32_t *C;
+  double t_start, t_elapsed;
+
+  A = (int8_t *) malloc((size_t) m * k);
+  B = (int8_t *) malloc((size_t) k * n);
+  C = (int32_t *) calloc((size_t) m * n, sizeof(int32_t));
+  assert(A && B && C);
+  for (i = 0; i < m * k; i++) {
+    A[i] = (int8_t) (rand() % 255 - 127);
+  }
+  for (i = 0; i < k * n; i++) {
+    B[i] = (int8_t) (rand() % 255 - 127);
+  }
+
+  best = mm_q8_set_isa(MM_Q8_VNNI);
+  for (isa = MM_Q8_SCALAR; isa <= best; isa++) {
+    mm_q8_set_isa(isa);
+
+    printf("Timing int8 Matrix Multiply m=%d n=%d k=%d iterations=%d....", m,
+        n, k, iterations);
+
+    t_start = MPI_Wtime(); /* Start timer */
+    for (iter = 0; iter < iterations; iter++) {
+      local_mm_q8(m, n, k, A, m, B, k, 1, C, m);
+    } /* iter */
+    t_elapsed = MPI_Wtime() - t_start; /* Stop timer */
+
+    /* kernel, total, per iteration, Gop/s */
+    printf("Conf_q8: %d, %d, %d, %s, %lf, %lf, %.2lf\n", m, n, k,
+        mm_q8_isa_name(isa), t_elapsed, t_elapsed / iterations,
+        2.0 * m * n * k * iterations / t_elapsed * 1e-9);
+  }
+
+  free(A);
+  free(B);
+  free(C);
+}
+
+/**
+ * Times the complex multiply under 4M and 3M, on interleaved
+ *  (local_mm_z) and planar (local_mm_zp) storage
+ **/
+void random_multiply_z(int m, int n, int k, int iterations) {
+  int i, iter, algorithm, planar;
+  double *Ar, *Ai, *Br, *Bi, *Cr, *Ci;
+  mm_complex_double *A, *B, *C;
+  double t_start, t_elapsed;
+
+  Ar = random_matrix(m, k);
+  Ai = random_matrix(m, k);
+  Br = random_matrix(k, n);
+  Bi = random_matrix(k, n);
+  Cr = random_matrix(m, n);
+  Ci = random_matrix(m, n);
+  A = (mm_complex_double *) malloc(sizeof(mm_complex_double) * m * k);
+  B = (mm_complex_double *) malloc(sizeof(mm_complex_double) * k * n);
+  C = (mm_complex_double *) malloc(sizeof(mm_complex_double) * m * n);
+  assert(A && B && C);
+  for (i = 0; i < m * k; i++) {
+    A[i] = Ar[i] + Ai[i] * I;
+  }
+  for (i = 0; i < k * n; i++) {
+    B[i] = Br[i] + Bi[i] * I;
+  }
+  for (i = 0; i < m * n; i++) {
+    C[i] = Cr[i] + Ci[i] * I;
+  }
+
+  for (planar = 0; planar <= 1; planar++) {
+    for (algorithm = MM_COMPLEX_4M; algorithm <= MM_COMPLEX_3M; algorithm++) {
+      local_mm_set_complex(algorithm);
+
+      printf("Timing complex Matrix Multiply m=%d n=%d k=%d iterations=%d....",
+          m, n, k, iterations);
+
+      t_start = MPI_Wtime(); /* Start timer */
+      for (iter = 0; iter < iterations; iter++) {
+        if (planar) {
+          local_mm_zp(m, n, k, 1.0, Ar, Ai, m, Br, Bi, k, 1.0, Cr, Ci, m);
+        } else {
+          local_mm_z(m, n, k, 1.0, A, m, B, k, 1.0, C, m);
+        }
+      } /* iter */
+      t_elapsed = MPI_Wtime() - t_start; /* Stop timer */
+
+      /* layout, algorithm, total, per iteration, GFlop/s of 4M */
+      printf("Conf_z: %d, %d, %d, %s, %s, %lf, %lf, %.2lf\n", m, n, k,
+          planar ? "planar" : "interleaved",
+          (algorithm == MM_COMPLEX_3M) ? "3M" : "4M", t_elapsed,
+          t_elapsed / iterations, 8.0 * m * n * k * iterations / t_elapsed * 1e-9);
+    }
+  }
+  local_mm_set_complex(MM_COMPLEX_4M);
+
+  deallocate_matrix(Ar);
+  deallocate_matrix(Ai);
+  deallocate_matrix(Br);
+  deallocate_matrix(Bi);
+  deallocate_matrix(Cr);
+  deallocate_matrix(Ci);
+  free(A);
+  free(B);
+  free(C);
+}
+
+/**
+ * Times a bias, scale and ReLU epilogue fused into local_mm_epilogue()
+ *  against local_mm() followed by one pass over C per operation
+ **/
+void random_multiply_epilogue(int m, int n, int k, int iterations) {
+  int i, j, iter;
+  double *A, *B, *C, *bias;
+  double t_start, t_fused, t_separate, bytes;
+  mm_epilogue_t epilogue;
+
+  printf("Timing Matrix Multiply with epilogue m=%d n=%d k=%d iterations=%d....",
+      m, n, k, iterations);
+
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  C = random_matrix(m, n);
+  bias = random_matrix(m, 1);
+
+  mm_epilogue_init(&epilogue);
+  mm_epilogue_bias_rows(&epilogue, bias);
+  mm_epilogue_scale(&epilogue, 0.5);
+  mm_epilogue_relu(&epilogue);
+
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    local_mm_epilogue(m, n, k, 1.0, A, m, B, k, 0.0, C, m, &epilogue);
+  }
+  t_fused = MPI_Wtime() - t_start;
+
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    local_mm(m, n, k, 1.0, A, m, B, k, 0.0, C, m);
+    for (j = 0; j < n; j++)
+      for (i = 0; i < m; i++)
+        C[j * m + i] += bias[i];
+    for (i = 0; i < m * n; i++)
+      C[i] *= 0.5;
+    for (i = 0; i < m * n; i++)
+      C[i] = (C[i] > 0.0) ? C[i] : 0.0;
+  }
+  t_separate = MPI_Wtime() - t_start;
+
+  /* Each separate pass reads and writes all of C */
+  bytes = 3.0 * 2.0 * sizeof(double) * m * n;
+
+  /* fused and separate per iteration, MB of C traffic saved per call */
+  printf("Conf_epilogue: %d, %d, %d, %lf, %lf, %.2lf\n", m, n, k,
+      t_fused / iterations, t_separate / iterations, bytes * 1e-6);
+
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(bias);
+}
+
+/**
+ * Maps a new temporary file of random values; the file is unlinked at
+ *  once and goes away with the mapping
+ **/
+static void random_mapped(int rows, int cols, mm_ooc_matrix_t *matrix) {
+  char path[] = "/tmp/time_mm_XXXXXX";
+  int fd = mkstemp(path);
+  size_t i;
+
+  assert(fd >= 0);
+  close(fd);
+  assert(mm_ooc_map(path, rows, cols, MM_OOC_CREATE, matrix) == 0);
+  unlink(path);
+  for (i = 0; i < (size_t) rows * cols; i++) {
+    matrix->data[i] = ((double) rand() / (double) RAND_MAX);
+  }
+}
+
+/**
+ * Times local_mm_ooc() on mapped matrices under a budget of budget MB
+ *  against local_mm() on the same mappings
+ **/
+void random_multiply_ooc(int m, int n, int k, int budget, int iterations) {
+  int iter, mt, nt, kt;
+  double t_start, t_ooc, t_mapped;
+  mm_ooc_matrix_t A, B, C;
+
+  printf("Timing out-of-core Matrix Multiply m=%d n=%d k=%d budget=%dMB....",
+      m, n, k, budget);
+
+  random_mapped(m, k, &A);
+  random_mapped(k, n, &B);
+  random_mapped(m, n, &C);
+  mm_ooc_set_budget((size_t) budget << 20);
+  mm_ooc_tiles(m, n, k, mm_ooc_get_budget(), &mt, &nt, &kt);
+
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    local_mm_ooc(1.0, &A, &B, 0.0, &C);
+  }
+  t_ooc = MPI_Wtime() - t_start;
+
+  /* Everything mapped in at once */
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    local_mm(m, n, k, 1.0, A.data, m, B.data, k, 0.0, C.data, m);
+  }
+  t_mapped = MPI_Wtime() - t_start;
+
+  /* tile, streamed and unbounded per iteration */
+  printf("Conf_ooc: %d, %d, %d, %d, %d, %d, %d, %lf, %lf\n", m, n, k, budget,
+      mt, nt, kt, t_ooc / iterations, t_mapped / iterations);
+
+  mm_ooc_unmap(&A);
+  mm_ooc_unmap(&B);
+  mm_ooc_unmap(&C);
+}
+
+/**
+ * Times local_mm() on one repeated small shape with and without the
+ *  generated kernels
+ **/
+void random_multiply_jit(int m, int n, int k, int iterations) {
+  int iter;
+  double *A, *B, *C;
+  double t_start, t_jit, t_generic;
+
+  printf("Timing JIT Matrix Multiply m=%d n=%d k=%d iterations=%d....",
+      m, n, k, iterations);
+
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  C = random_matrix(m, n);
+
+  mm_jit_set_enabled(0);
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    local_mm(m, n, k, 1.0, A, m, B, k, 1.0, C, m);
+  }
+  t_generic = MPI_Wtime() - t_start;
+
+  /* The first call sees the shape, the second generates its kernel */
+  mm_jit_set_enabled(1);
+  local_mm(m, n, k, 1.0, A, m, B, k, 1.0, C, m);
+  local_mm(m, n, k, 1.0, A, m, B, k, 1.0, C, m);
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    local_mm(m, n, k, 1.0, A, m, B, k, 1.0, C, m);
+  }
+  t_jit = MPI_Wtime() - t_start;
+
+  /* generated and generic per call, in microseconds, and their GFLOPS */
+  printf("Conf_jit: %d, %d, %d, %d, %lf, %lf, %.2lf, %.2lf\n", m, n, k,
+      mm_jit_enabled(), 1e6 * t_jit / iterations, 1e6 * t_generic / iterations,
+      2e-9 * m * n * k * iterations / t_jit,
+      2e-9 * m * n * k * iterations / t_generic);
+
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+}
+
+/**
+ * Times every BLAS backend found on the same A, B and C, and reports
+ *  how far each result is from the native one
+ **/
+void random_multiply_blas(int m, int n, int k, int iterations) {
+  int i, b, iter;
+  double *A, *B, *C0, *C, *CN;
+  double t_start, t_elapsed, diff;
+
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  C0 = random_matrix(m, n);
+  C = allocate_matrix(m, n);
+  CN = allocate_matrix(m, n);
+
+  for (b = 0; b < mm_blas_count(); b++) {
+    printf("Timing %s Matrix Multiply m=%d n=%d k=%d iterations=%d....",
+        mm_blas_name(b), m, n, k, iterations);
+
+    for (i = 0; i < m * n; i++) {
+      C[i] = C0[i];
+    }
+    t_start = MPI_Wtime();
+    for (iter = 0; iter < iterations; iter++) {
+      mm_blas_dgemm(b, m, n, k, 1.0, A, m, B, k, 0.0, C, m);
+    }
+    t_elapsed = MPI_Wtime() - t_start;
+
+    /* Backend 0 is native, the reference */
+    diff = 0.0;
+    for (i = 0; i < m * n; i++) {
+      if (b == MM_BLAS_NATIVE) {
+        CN[i] = C[i];
+      }
+      diff = (fabs(C[i] - CN[i]) > diff) ? fabs(C[i] - CN[i]) : diff;
+    }
+
+    /* seconds per call, GFLOPS, largest difference from native */
+    printf("Conf_blas: %s, %d, %d, %d, %lf, %.2lf, %le\n", mm_blas_name(b),
+        m, n, k, t_elapsed / iterations, 2e-9 * m * n * k * iterations
+        / t_elapsed, diff);
+  }
+
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C0);
+  deallocate_matrix(C);
+  deallocate_matrix(CN);
+}
+
 int main(int argc, char *argv[]) {
 
   int rank = 0;
@@ -65,10 +391,26 @@ int main(int argc, char *argv[]) {
   MPI_Get_processor_name(hostname, &namelen); /* Get hostname of node */
   printf("[Using Host:%s -- Rank %d out of %d]\n", hostname, rank, np);
 
+  /* Pin the local_mm() threads before the matrices are touched */
+  mm_affinity_apply();
+  mm_placement_report(stdout, rank);
+
   if (rank == 0) {
       random_multiply(1024, 256, 256, NUM_TRIALS);
       random_multiply(256, 1024, 256, NUM_TRIALS);
       random_multiply(256, 256, 1024, NUM_TRIALS);
+      random_multiply_q8(1024, 256, 256, NUM_TRIALS);
+      random_multiply_q8(256, 1024, 256, NUM_TRIALS);
+      random_multiply_q8(256, 256, 1024, NUM_TRIALS);
+      random_multiply_z(512, 512, 512, NUM_TRIALS);
+      random_multiply_epilogue(2048, 2048, 64, NUM_TRIALS);
+      random_multiply_epilogue(1024, 256, 256, NUM_TRIALS);
+      random_multiply_ooc(2048, 2048, 2048, 16, 2);
+      random_multiply_jit(32, 32, 32, 100 * NUM_TRIALS);
+      random_multiply_jit(128, 128, 16, 100 * NUM_TRIALS);
+      random_multiply_jit(64, 64, 64, 100 * NUM_TRIALS);
+      random_multiply_blas(1024, 1024, 1024, 5);
+      random_multiply_blas(128, 128, 16, 100 * NUM_TRIALS);
   }
 
   MPI_Finalize();
@@ -8,18 +8,42 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <mpi.h>
+#include <string.h>
 
 #include "matrix_utils.h"
 #include "local_mm.h"
 #include "summa.h"
+#include "mm_numa.h"
+#include "summa_model.h"
+#include "summa_trace.h"
+#include "summa_chain.h"
 
 #define NUM_TRIALS 25 /*!< Number of timing trials */
+#define MODEL_TOLERANCE 0.5 /*!< Flag runs 50% slower or faster than the model */
+
+static summa_model_params_t model_params; /*!< Calibrated in main() */
+static int lookahead = 0; /*!< SUMMA_LOOKAHEAD, times summa_dag() when positive */
+static int use_plan = 0; /*!< SUMMA_PLAN, times summa_plan_execute() */
+static int use_rma = 0; /*!< SUMMA_RMA, also times summa_rma() on the same blocks */
+static double sparse_density = 0.0; /*!< SUMMA_SPARSE, also times summa_sparse() */
+static int use_topology = 0; /*!< SUMMA_TOPOLOGY, summa_set_topology() per shape */
+static int algorithm = SUMMA_STATIONARY_C; /*!< SUMMA_ALGORITHM, see main() */
+static int use_auto = 0; /*!< SUMMA_ALGORITHM=auto, summa_select() per shape */
+static int use_chain = 0; /*!< SUMMA_CHAIN, also times summa_chain() */
+static int multi_terms = 0; /*!< SUMMA_MULTI, terms timed with summa_multi() */
+
+/** Names of the summa_select() algorithms, as SUMMA_ALGORITHM takes them */
+static const char *algorithm_names[] = {"c", "a", "b", "row", "col", "inner"};
 
 void random_summa(int m, int n, int k, int px, int py, int pb, int iterations) {
   int iter;
-  double t_start, t_elapsed;
+  double t_start, t_elapsed, t_rma = 0.0, t_sparse = 0.0;
+  double bytes_world = 0.0, bytes_grid = 0.0;
   int rank = 0;
   double *A_block, *B_block, *C_block;
+  summa_model_prediction_t prediction;
+  double deviation;
+  summa_plan_t plan = NULL;
 
   MPI_Comm_rank(MPI_COMM_WORLD, &rank); /* Get process id */
 
@@ -34,8 +58,17 @@ void random_summa(int m, int n, int k, int px, int py, int pb, int iterations) {
 
   }
 
+  /* Blocks are random, so reordering the grid needs no redistribution */
+  if (use_topology) {
+    bytes_world = summa_topology_report(NULL, m, n, k, px, py);
+    summa_set_topology(m, n, k, px, py);
+    bytes_grid = summa_topology_report(NULL, m, n, k, px, py);
+  }
+
   /*  Initialize matrix blocks */
-  A_block = random_matrix(m / px, k / py);
+  A_block = (sparse_density > 0.0)
+      ? random_matrix_sparse(m / px, k / py, sparse_density)
+      : random_matrix(m / px, k / py);
   assert(A_block);
 
   B_block = random_matrix(k / px, n / py);
@@ -52,20 +85,104 @@ void random_summa(int m, int n, int k, int px, int py, int pb, int iterations) {
    *
    */
 
+  /* A plan is set up once, outside the timed loop */
+  if (use_plan) {
+    plan = summa_plan_create(m, n, k, px, py, pb);
+  }
+
+  if (use_auto) {
+    algorithm = summa_select(m, n, k, px, py);
+  }
+
   t_start = MPI_Wtime(); /* Start timer */
   for (iter = 0; iter < iterations; iter++) {
-    summa(m, n, k, A_block, B_block, C_block, px, py, pb);
+    if (use_plan) {
+      summa_plan_execute(plan, A_block, B_block, C_block);
+    } else if (algorithm != SUMMA_STATIONARY_C) {
+      summa_run(algorithm, m, n, k, A_block, B_block, C_block, px, py, pb);
+    } else if (lookahead > 0) {
+      summa_dag(m, n, k, A_block, B_block, C_block, px, py, pb, lookahead);
+    } else {
+      summa(m, n, k, A_block, B_block, C_block, px, py, pb);
+    }
   } /* iter */
 
   MPI_Barrier(MPI_COMM_WORLD);
   t_elapsed = MPI_Wtime() - t_start; /* Stop timer */
 
+  if (use_plan) {
+    summa_plan_free(&plan);
+  }
+
+  /* The one-sided variant, same blocks and iterations */
+  if (use_rma) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    t_start = MPI_Wtime();
+    for (iter = 0; iter < iterations; iter++) {
+      summa_rma(m, n, k, A_block, B_block, C_block, px, py, pb);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    t_rma = MPI_Wtime() - t_start;
+  }
+
+  /* The sparse variant on the same A, compressed once outside the loop */
+  if (sparse_density > 0.0) {
+    mm_csr_t A_csr;
+
+    mm_csr_from_dense(m / px, k / py, A_block, m / px, &A_csr);
+    MPI_Barrier(MPI_COMM_WORLD);
+    t_start = MPI_Wtime();
+    for (iter = 0; iter < iterations; iter++) {
+      summa_sparse(m, n, k, &A_csr, B_block, C_block, px, py, pb);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    t_sparse = MPI_Wtime() - t_start;
+    mm_csr_free(&A_csr);
+  }
+
   if (rank == 0) {
     /*printf("total_time=%lf, per_iteration=%lf\n", t_elapsed, t_elapsed
         / iterations);
         */
-      printf("%lf, %lf\n", t_elapsed, t_elapsed
-        / iterations);
+      summa_model_predict(m, n, k, px, py, pb, &model_params, &prediction);
+      deviation = summa_model_deviation(&prediction, t_elapsed / iterations);
+
+      /* measured, then predicted (bcastA, bcastB, compute, total) */
+      printf("%lf, %lf, %lf, %lf, %lf, %lf, %+.2lf%s\n", t_elapsed, t_elapsed
+        / iterations, prediction.bcastA, prediction.bcastB,
+        prediction.compute, prediction.total, deviation,
+        (deviation > MODEL_TOLERANCE || deviation < -MODEL_TOLERANCE) ?
+        ", OFF-MODEL" : "");
+
+      /* Inter-node bytes of one summa(), world order and reordered */
+      if (use_topology) {
+        printf("summa_topology, %d, %d, %d, %d, %d, %.0lf, %.0lf\n", m, n, k,
+            px, py, bytes_world, bytes_grid);
+      }
+
+      /* The model above is summa()'s; name the variant that ran */
+      if (use_auto) {
+        printf("summa_select, %d, %d, %d, %d, %d, %s\n", m, n, k, px, py,
+            algorithm_names[algorithm]);
+      }
+
+      /* total, per iteration, and speedup over the broadcast version */
+      if (use_rma) {
+        printf("summa_rma, %d, %d, %d, %d, %d, %d, %d, %lf, %lf, %.2lf\n",
+            m, n, k, px, py, pb, iterations, t_rma, t_rma / iterations,
+            t_elapsed / t_rma);
+      }
+
+      /* density, total, per iteration, and speedup over dense summa() */
+      if (sparse_density > 0.0) {
+        printf("summa_sparse, %d, %d, %d, %d, %d, %d, %d, %.4lf, %lf, %lf, %.2lf\n",
+            m, n, k, px, py, pb, iterations, sparse_density, t_sparse,
+            t_sparse / iterations, t_elapsed / t_sparse);
+      }
+  }
+
+  if (use_topology) {
+    summa_clear_topology();
   }
 
   deallocate_matrix(A_block);
@@ -73,6 +190,122 @@ void random_summa(int m, int n, int k, int px, int py, int pb, int iterations) {
   deallocate_matrix(C_block);
 }
 
+/**
+ * Times summa_chain() on the chain dims against summa_dist() from left
+ *  to right, each intermediate a separate descriptor
+ **/
+void random_chain(int count, const int *dims, int px, int py, int pb,
+    int iterations) {
+  int i, j, iter, rank = 0;
+  int split[64];
+  char order[256];
+  double t_start, t_chain, t_left;
+  dist_matrix_t mats[8], T[8];
+  const dist_matrix_t *factors[8];
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  assert(count <= 8);
+
+  for (i = 0; i < count; i++) {
+    dist_matrix_init(&mats[i], dims[i], dims[i + 1], px, py, 0, 0);
+    for (j = 0; j < mats[i].localRows * mats[i].localCols; j++) {
+      mats[i].data[j] = (double) rand() / RAND_MAX;
+    }
+    factors[i] = &mats[i];
+    dist_matrix_init(&T[i], dims[0], dims[i + 1], px, py, 0, 0);
+  }
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    summa_chain(count, factors, &T[count - 1], pb, &model_params);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  t_chain = MPI_Wtime() - t_start;
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    for (i = 1; i < count; i++) {
+      summa_dist((i == 1) ? &mats[0] : &T[i - 1], &mats[i], &T[i], pb);
+    }
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  t_left = MPI_Wtime() - t_start;
+
+  summa_chain_order(count, dims, px, py, pb, &model_params, split);
+  summa_chain_format(count, split, order, sizeof(order));
+
+  /* order, per iteration chained and left to right, speedup */
+  if (rank == 0) {
+    printf("summa_chain, %d, %d, %d, %d, %s, %lf, %lf, %.2lf\n", count, px,
+        py, pb, order, t_chain / iterations, t_left / iterations,
+        t_left / t_chain);
+  }
+
+  for (i = 0; i < count; i++) {
+    dist_matrix_free(&mats[i]);
+    dist_matrix_free(&T[i]);
+  }
+}
+
+/**
+ * Times summa_multi() on terms products of inner dimension k against
+ *  one summa() call per term
+ **/
+void random_multi(int terms, int m, int n, int k, int px, int py, int pb,
+    int iterations) {
+  int t, iter, rank = 0;
+  int *ks = (int *) malloc(terms * sizeof(int));
+  double **A_blocks = (double **) malloc(terms * sizeof(double *));
+  double **B_blocks = (double **) malloc(terms * sizeof(double *));
+  double *C_block;
+  double t_start, t_multi, t_separate;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  assert(ks != NULL && A_blocks != NULL && B_blocks != NULL);
+
+  for (t = 0; t < terms; t++) {
+    ks[t] = k;
+    A_blocks[t] = random_matrix(m / px, k / py);
+    B_blocks[t] = random_matrix(k / px, n / py);
+  }
+  C_block = zeros_matrix(m / px, n / py);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    summa_multi(terms, m, n, ks, A_blocks, B_blocks, C_block, px, py, pb);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  t_multi = MPI_Wtime() - t_start;
+
+  t_start = MPI_Wtime();
+  for (iter = 0; iter < iterations; iter++) {
+    for (t = 0; t < terms; t++) {
+      summa(m, n, k, A_blocks[t], B_blocks[t], C_block, px, py, pb);
+    }
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  t_separate = MPI_Wtime() - t_start;
+
+  /* per iteration fused and separate, speedup */
+  if (rank == 0) {
+    printf("summa_multi, %d, %d, %d, %d, %d, %d, %d, %lf, %lf, %.2lf\n",
+        terms, m, n, k, px, py, pb, t_multi / iterations,
+        t_separate / iterations, t_separate / t_multi);
+  }
+
+  for (t = 0; t < terms; t++) {
+    deallocate_matrix(A_blocks[t]);
+    deallocate_matrix(B_blocks[t]);
+  }
+  deallocate_matrix(C_block);
+  free(ks);
+  free(A_blocks);
+  free(B_blocks);
+}
+
 /** Program start */
 int main(int argc, char *argv[]) {
   int rank = 0;
@@ -90,12 +323,131 @@ int main(int argc, char *argv[]) {
   if (np != 64) {
   	printf("Error: np=%d. Please use 64 processes\n",np);
   }
+
+  /* Pin the local_mm() threads before the matrices are touched */
+  mm_affinity_apply();
+  if (rank == 0) {
+    mm_placement_report(stdout, rank);
+  }
+
+  summa_model_calibrate(&model_params);
+  if (rank == 0) {
+    printf("Model: alpha=%le, beta=%le, gamma=%le\n", model_params.alpha,
+        model_params.beta, model_params.gamma);
+  }
   
+  /* SUMMA_BCAST=ring selects the pipelined ring broadcast, with
+   * SUMMA_BCAST_SEGMENT bytes per segment */
+  if (getenv("SUMMA_BCAST") != NULL && strcmp(getenv("SUMMA_BCAST"), "ring") == 0) {
+    int segment = SUMMA_BCAST_SEGMENT_DEFAULT;
+
+    if (getenv("SUMMA_BCAST_SEGMENT") != NULL) {
+      segment = atoi(getenv("SUMMA_BCAST_SEGMENT"));
+    }
+    summa_set_bcast(SUMMA_BCAST_RING, segment);
+    if (rank == 0) {
+      printf("Broadcast: ring, segment=%d bytes\n", segment);
+    }
+  } else if (rank == 0) {
+    printf("Broadcast: MPI_Bcast\n");
+  }
+
+  /* SUMMA_LOOKAHEAD=<depth> times the task-graph summa_dag() */
+  if (getenv("SUMMA_LOOKAHEAD") != NULL) {
+    lookahead = atoi(getenv("SUMMA_LOOKAHEAD"));
+    if (rank == 0 && lookahead > 0) {
+      printf("Task-graph summa_dag, lookahead=%d\n", lookahead);
+    }
+  }
+
+  /* SUMMA_PLAN=1 times repeated executions of one persistent plan */
+  if (getenv("SUMMA_PLAN") != NULL && atoi(getenv("SUMMA_PLAN")) != 0) {
+    use_plan = 1;
+    if (rank == 0) {
+      printf("Persistent plan, %s\n", (MPI_VERSION >= 4) ? "MPI_Bcast_init"
+          : "MPI_Ibcast fallback");
+    }
+  }
+
+  /* SUMMA_ALGORITHM=a, b, row, col or inner times that algorithm of
+   * summa_run(), auto the one summa_select() picks for each shape */
+  if (getenv("SUMMA_ALGORITHM") != NULL) {
+    const char *name = getenv("SUMMA_ALGORITHM");
+    int a;
+
+    use_auto = (strcmp(name, "auto") == 0);
+    for (a = 0; a <= SUMMA_INNER; a++) {
+      if (strcmp(name, algorithm_names[a]) == 0) {
+        algorithm = a;
+      }
+    }
+    if (rank == 0) {
+      printf("Algorithm: %s\n", name);
+    }
+  }
+
+  /* SUMMA_TOPOLOGY=1 lays the grid out by node, socket and core for
+   * each shape; SUMMA_NODE_SIZE=<n> emulates nodes of n ranks */
+  if (getenv("SUMMA_TOPOLOGY") != NULL && atoi(getenv("SUMMA_TOPOLOGY")) != 0) {
+    use_topology = 1;
+    if (rank == 0) {
+      printf("Topology-aware grid\n");
+    }
+  }
+
+  /* SUMMA_RMA=1 times the one-sided summa_rma() after each run */
+  if (getenv("SUMMA_RMA") != NULL && atoi(getenv("SUMMA_RMA")) != 0) {
+    use_rma = 1;
+    if (rank == 0) {
+      printf("One-sided summa_rma, compared on the same blocks\n");
+    }
+  }
+
+  /* SUMMA_SPARSE=<density> fills A with that fraction of nonzeros and
+   * times summa_sparse() after each run */
+  if (getenv("SUMMA_SPARSE") != NULL && atof(getenv("SUMMA_SPARSE")) > 0.0) {
+    sparse_density = atof(getenv("SUMMA_SPARSE"));
+    if (rank == 0) {
+      printf("Sparse A, density=%.4lf, compared with summa_sparse\n",
+          sparse_density);
+    }
+  }
+
+  /* SUMMA_CHAIN=1 times summa_chain() against pairwise products */
+  if (getenv("SUMMA_CHAIN") != NULL && atoi(getenv("SUMMA_CHAIN")) != 0) {
+    use_chain = 1;
+  }
+
+  /* SUMMA_MULTI=<terms> times summa_multi() against one summa() per term */
+  if (getenv("SUMMA_MULTI") != NULL) {
+    multi_terms = atoi(getenv("SUMMA_MULTI"));
+  }
+
+  /* SUMMA_TRACE=<prefix> writes per-rank traces for summa_sim */
+  if (getenv("SUMMA_TRACE") != NULL) {
+    summa_trace_start(getenv("SUMMA_TRACE"));
+  }
+
   random_summa(256, 256, 256, 8, 8, 16, NUM_TRIALS);
   random_summa(1024, 256, 256, 8, 8, 16, NUM_TRIALS);
   random_summa(256, 1024, 256, 8, 8, 16, NUM_TRIALS);
   random_summa(256, 256, 1024, 8, 8, 16, NUM_TRIALS);
   random_summa(1024, 1024, 1024, 8, 8, 16, NUM_TRIALS);
+
+  if (use_chain) {
+    int wide[5] = {1024, 64, 1024, 64, 1024};
+    int mixed[7] = {512, 64, 256, 1024, 64, 512, 128};
+
+    random_chain(4, wide, 8, 8, 16, NUM_TRIALS);
+    random_chain(6, mixed, 8, 8, 16, NUM_TRIALS);
+  }
+
+  if (multi_terms > 0) {
+    random_multi(multi_terms, 256, 256, 256, 8, 8, 16, NUM_TRIALS);
+    random_multi(multi_terms, 1024, 1024, 128, 8, 8, 16, NUM_TRIALS);
+  }
+
+  summa_trace_stop();
   
   MPI_Finalize();
   return 0;
@@ -9,9 +9,17 @@
 #include <assert.h>
 #include <time.h>
 #include <math.h>
+#include <unistd.h>
 
 #include "matrix_utils.h"
 #include "local_mm.h"
+#include "mm_pool.h"
+#include "mm_sparse.h"
+#include "mm_q8.h"
+#include "mm_epilogue.h"
+#include "mm_ooc.h"
+#include "mm_jit.h"
+#include "mm_blas.h"
 
 void print_matrix_types() {
 
@@ -127,6 +135,68 @@ void ones_test(int m, int n, int k) {
   printf("passed\n");
 }
 
+/**
+ * Test that a product with k = 0 leaves C = beta * C
+ **/
+void empty_k_test(int m, int n) {
+  int i;
+  double A[1] = {0.0}, B[1] = {0.0};
+  double *C, *C_zeros, *C_tens;
+  float Af[1] = {0.0f}, Bf[1] = {0.0f};
+  float *Cf;
+
+  printf("empty_k_test m=%d n=%d............", m, n);
+
+  /* Allocate matrices */
+  C = allocate_matrix(m, n);
+  C_zeros = zeros_matrix(m, n);
+  C_tens = allocate_matrix(m, n);
+  Cf = (float *) malloc((size_t) m * n * sizeof(float));
+  assert(Cf != NULL);
+  for (i = 0; i < m * n; i++) {
+    C[i] = 5.0;
+    C_tens[i] = 10.0;
+  }
+
+  /* C = 1.0*(A*B) + 2.0*C */
+  local_mm(m, n, 0, 1.0, A, m, B, 1, 2.0, C, m);
+  verify_matrix(m, n, C, C_tens);
+
+  /* C = 1.0*(A*B) + 0.0*C */
+  local_mm(m, n, 0, 1.0, A, m, B, 1, 0.0, C, m);
+  verify_matrix(m, n, C, C_zeros);
+
+  /* The same through the mixed precision kernel */
+  for (i = 0; i < m * n; i++) {
+    C[i] = 5.0;
+  }
+  local_mm_mixed(m, n, 0, 1.0, Af, m, Bf, 1, 2.0, C, m);
+  verify_matrix(m, n, C, C_tens);
+  local_mm_mixed(m, n, 0, 1.0, Af, m, Bf, 1, 0.0, C, m);
+  verify_matrix(m, n, C, C_zeros);
+
+  /* And in single precision */
+  for (i = 0; i < m * n; i++) {
+    Cf[i] = 5.0f;
+  }
+  local_mm_f(m, n, 0, 1.0f, Af, m, Bf, 1, 2.0f, Cf, m);
+  for (i = 0; i < m * n; i++) {
+    assert(Cf[i] == 10.0f);
+  }
+  local_mm_f(m, n, 0, 1.0f, Af, m, Bf, 1, 0.0f, Cf, m);
+  for (i = 0; i < m * n; i++) {
+    assert(Cf[i] == 0.0f);
+  }
+
+  /* deallocate memory */
+  deallocate_matrix(C);
+  deallocate_matrix(C_zeros);
+  deallocate_matrix(C_tens);
+  free(Cf);
+
+  printf("passed\n");
+}
+
 /**
  * Test the multiplication of a lower triangular matrix
  **/
@@ -186,6 +256,734 @@ void lower_triangular_test(int n) {
   printf("passed\n");
 }
 
+/**
+ * Compare local_mm_trmm() on a full random A to local_mm() on its
+ *  lower triangle
+ **/
+void trmm_test(int m, int n) {
+  int i, j;
+  double *A, *L, *B, *C, *CC;
+
+  printf("trmm_test m=%d n=%d ............", m, n);
+
+  /* Allocate matrices, the upper triangle of A must be ignored */
+  A = random_matrix(m, m);
+  L = lowerTri_matrix(m, m);
+  B = random_matrix(m, n);
+  C = random_matrix(m, n);
+  CC = allocate_matrix(m, n);
+  for (i = 0; i < m * m; i++) {
+    L[i] *= A[i];
+  }
+  for (i = 0; i < m * n; i++) {
+    CC[i] = C[i];
+  }
+
+  /* C = 2.0*(L*B) + 3.0*C */
+  local_mm_trmm(m, n, 2.0, A, m, B, m, 3.0, C, m);
+  local_mm(m, n, m, 2.0, L, m, B, m, 3.0, CC, m);
+
+  /* Verfiy the results */
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < m; i++) {
+      assert(C[j * m + i] == CC[j * m + i]);
+    }
+  }
+
+  /* deallocate memory */
+  deallocate_matrix(A);
+  deallocate_matrix(L);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+
+  printf("passed\n");
+}
+
+/**
+ * Compare local_mm_syrk() to local_mm() on A and its transpose; the
+ *  upper triangle of C must be left as it was
+ **/
+void syrk_test(int n, int k) {
+  int i, j;
+  double *A, *At, *C, *C0, *CC;
+
+  printf("syrk_test n=%d k=%d ............", n, k);
+
+  /* Allocate matrices */
+  A = random_matrix(n, k);
+  At = allocate_matrix(k, n);
+  C = random_matrix(n, n);
+  C0 = allocate_matrix(n, n);
+  CC = allocate_matrix(n, n);
+  for (j = 0; j < k; j++) {
+    for (i = 0; i < n; i++) {
+      At[i * k + j] = A[j * n + i];
+    }
+  }
+  for (i = 0; i < n * n; i++) {
+    C0[i] = C[i];
+    CC[i] = C[i];
+  }
+
+  /* C = 1.0*(A*A^T) + 2.0*C, lower triangle */
+  local_mm_syrk(n, k, 1.0, A, n, 2.0, C, n);
+  local_mm(n, n, k, 1.0, A, n, At, k, 2.0, CC, n);
+
+  /* Verfiy the results */
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < n; i++) {
+      assert(C[j * n + i] == ((i >= j) ? CC[j * n + i] : C0[j * n + i]));
+    }
+  }
+
+  /* deallocate memory */
+  deallocate_matrix(A);
+  deallocate_matrix(At);
+  deallocate_matrix(C);
+  deallocate_matrix(C0);
+  deallocate_matrix(CC);
+
+  printf("passed\n");
+}
+
+/**
+ * Compare the single-precision multiply against local_mm()
+ *
+ * The random matrices hold small integers, so both
+ *  products are exact
+ **/
+void single_precision_test(int m, int n, int k) {
+  int i;
+  double *A, *B, *C;
+  float *Af, *Bf, *Cf;
+
+  printf("single_precision_test m=%d n=%d k=%d............", m, n, k);
+
+  /* Allocate matrices */
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  C = random_matrix(m, n);
+
+  Af = convert_matrix_f(m, k, A);
+  Bf = convert_matrix_f(k, n, B);
+  Cf = convert_matrix_f(m, n, C);
+
+  /* C = 1.0*(A*B) + 2.0*C */
+  local_mm(m, n, k, 1.0, A, m, B, k, 2.0, C, m);
+  local_mm_f(m, n, k, 1.0f, Af, m, Bf, k, 2.0f, Cf, m);
+
+  /* Verfiy the results */
+  for (i = 0; i < m * n; i++) {
+    verify_element((double) Cf[i], C[i]);
+  }
+
+  /* deallocate memory */
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix_f(Af);
+  deallocate_matrix_f(Bf);
+  deallocate_matrix_f(Cf);
+
+  printf("passed\n");
+}
+
+/**
+ * Compare the mixed-precision multiply against local_mm()
+ *  on the same single-precision values
+ **/
+void mixed_precision_test(int m, int n, int k) {
+  int i;
+  double *A, *B, *C, *CC;
+  float *Af, *Bf;
+
+  printf("mixed_precision_test m=%d n=%d k=%d............", m, n, k);
+
+  /* Allocate matrices, with values that are not exact in float */
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  for (i = 0; i < m * k; i++) {
+    A[i] /= 3.0;
+  }
+  for (i = 0; i < k * n; i++) {
+    B[i] /= 7.0;
+  }
+
+  Af = convert_matrix_f(m, k, A);
+  Bf = convert_matrix_f(k, n, B);
+
+  /* The reference multiplies the rounded values in double precision */
+  for (i = 0; i < m * k; i++) {
+    A[i] = (double) Af[i];
+  }
+  for (i = 0; i < k * n; i++) {
+    B[i] = (double) Bf[i];
+  }
+
+  C = ones_matrix(m, n);
+  CC = ones_matrix(m, n);
+
+  /* C = 1.0*(A*B) + 1.0*C */
+  local_mm_mixed(m, n, k, 1.0, Af, m, Bf, k, 1.0, C, m);
+  local_mm(m, n, k, 1.0, A, m, B, k, 1.0, CC, m);
+
+  /* Verfiy the results */
+  verify_matrix(m, n, C, CC);
+
+  /* deallocate memory */
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+  deallocate_matrix_f(Af);
+  deallocate_matrix_f(Bf);
+
+  printf("passed\n");
+}
+
+/**
+ * Compare the double-precision complex multiply, interleaved and
+ *  planar, under algorithm (MM_COMPLEX_4M or MM_COMPLEX_3M) against
+ *  four real multiplies: (Ar + iAi)(Br + iBi) = ArBr - AiBi + i(ArBi + AiBr)
+ **/
+void complex_test(int m, int n, int k, int algorithm) {
+  int i;
+  double *Ar, *Ai, *Br, *Bi, *Cr, *Ci, *Pr, *Pi;
+  mm_complex_double *A, *B, *C;
+
+  printf("complex_test m=%d n=%d k=%d %s............", m, n, k,
+      (algorithm == MM_COMPLEX_3M) ? "3M" : "4M");
+
+  local_mm_set_complex(algorithm);
+
+  /* Allocate matrices */
+  Ar = random_matrix(m, k);
+  Ai = random_matrix(m, k);
+  Br = random_matrix(k, n);
+  Bi = random_matrix(k, n);
+  Cr = zeros_matrix(m, n);
+  Ci = zeros_matrix(m, n);
+  Pr = random_matrix(m, n);
+  Pi = random_matrix(m, n);
+
+  A = (mm_complex_double *) malloc(sizeof(mm_complex_double) * m * k);
+  B = (mm_complex_double *) malloc(sizeof(mm_complex_double) * k * n);
+  C = (mm_complex_double *) malloc(sizeof(mm_complex_double) * m * n);
+  assert(A != NULL && B != NULL && C != NULL);
+
+  for (i = 0; i < m * k; i++) {
+    A[i] = Ar[i] + Ai[i] * I;
+  }
+  for (i = 0; i < k * n; i++) {
+    B[i] = Br[i] + Bi[i] * I;
+  }
+  for (i = 0; i < m * n; i++) {
+    C[i] = 0.0;
+  }
+
+  /* C = 1.0*(A*B) + 0.0*C, on interleaved and planar storage */
+  local_mm_z(m, n, k, 1.0, A, m, B, k, 0.0, C, m);
+  local_mm_zp(m, n, k, 1.0, Ar, Ai, m, Br, Bi, k, 0.0, Pr, Pi, m);
+
+  local_mm(m, n, k, 1.0, Ar, m, Br, k, 0.0, Cr, m);
+  local_mm(m, n, k, -1.0, Ai, m, Bi, k, 1.0, Cr, m);
+  local_mm(m, n, k, 1.0, Ar, m, Bi, k, 0.0, Ci, m);
+  local_mm(m, n, k, 1.0, Ai, m, Br, k, 1.0, Ci, m);
+
+  /* Verfiy the results */
+  for (i = 0; i < m * n; i++) {
+    verify_element(creal(C[i]), Cr[i]);
+    verify_element(cimag(C[i]), Ci[i]);
+    verify_element(Pr[i], Cr[i]);
+    verify_element(Pi[i], Ci[i]);
+  }
+
+  /* C = i*(A*B) + 2*C on both, beta = 2 reads C */
+  local_mm_z(m, n, k, 1.0 * I, A, m, B, k, 2.0, C, m);
+  local_mm_zp(m, n, k, 1.0 * I, Ar, Ai, m, Br, Bi, k, 2.0, Pr, Pi, m);
+
+  for (i = 0; i < m * n; i++) {
+    verify_element(creal(C[i]), Cr[i] * 2.0 - Ci[i]);
+    verify_element(cimag(C[i]), Ci[i] * 2.0 + Cr[i]);
+    verify_element(Pr[i], creal(C[i]));
+    verify_element(Pi[i], cimag(C[i]));
+  }
+
+  local_mm_set_complex(MM_COMPLEX_4M);
+
+  /* deallocate memory */
+  deallocate_matrix(Ar);
+  deallocate_matrix(Ai);
+  deallocate_matrix(Br);
+  deallocate_matrix(Bi);
+  deallocate_matrix(Cr);
+  deallocate_matrix(Ci);
+  deallocate_matrix(Pr);
+  deallocate_matrix(Pi);
+  free(A);
+  free(B);
+  free(C);
+
+  printf("passed\n");
+}
+
+/**
+ * Compare local_mm() on a pool of four threads, whatever the
+ *  machine, to the single-threaded product
+ **/
+void pool_test(int m, int n, int k) {
+  double *A, *B, *C, *CC;
+
+  printf("pool_test m=%d n=%d k=%d............", m, n, k);
+
+  /* Allocate matrices */
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  C = ones_matrix(m, n);
+  CC = ones_matrix(m, n);
+
+  /* C = 1.0*(A*B) + 2.0*C */
+  mm_pool_set_threads(4);
+  local_mm(m, n, k, 1.0, A, m, B, k, 2.0, C, m);
+
+  mm_pool_set_threads(1);
+  local_mm(m, n, k, 1.0, A, m, B, k, 2.0, CC, m);
+
+  /* Verfiy the results */
+  verify_matrix(m, n, C, CC);
+
+  /* deallocate memory, the pool restarts at its default size */
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+  mm_pool_shutdown();
+
+  printf("passed\n");
+}
+
+/**
+ * Compare local_spmm() on a sparse A, on four threads, to local_mm()
+ **/
+void spmm_test(int m, int n, int k, double density) {
+  double *A, *B, *C, *CC;
+  mm_csr_t csr;
+
+  printf("spmm_test m=%d n=%d k=%d density=%.2f............", m, n, k, density);
+
+  /* Allocate matrices */
+  A = random_matrix_sparse(m, k, density);
+  B = random_matrix(k, n);
+  C = ones_matrix(m, n);
+  CC = ones_matrix(m, n);
+
+  mm_csr_from_dense(m, k, A, m, &csr);
+
+  /* C = 1.0*(A*B) + 2.0*C */
+  mm_pool_set_threads(4);
+  local_spmm(n, 1.0, &csr, B, k, 2.0, C, m);
+  local_mm(m, n, k, 1.0, A, m, B, k, 2.0, CC, m);
+
+  /* Verfiy the results */
+  verify_matrix(m, n, C, CC);
+
+  /* deallocate memory */
+  mm_csr_free(&csr);
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+  mm_pool_shutdown();
+
+  printf("passed\n");
+}
+
+/**
+ * Epilogue callback: C(i, j) += i - 2j, to check the tile offsets
+ **/
+static void index_epilogue(int row, int col, int rows, int cols, double *C,
+    int ldc, void *arg) {
+  int i, j;
+
+  (void) arg;
+  for (j = 0; j < cols; j++) {
+    for (i = 0; i < rows; i++) {
+      C[j * ldc + i] += (row + i) - 2.0 * (col + j);
+    }
+  }
+}
+
+/**
+ * Compare local_mm_epilogue() on threads pool threads to local_mm()
+ *  followed by a pass per operation
+ **/
+void epilogue_test(int m, int n, int k, int threads) {
+  int i, j;
+  double *A, *B, *C, *CC, *rowBias, *colBias;
+  mm_epilogue_t epilogue;
+
+  printf("epilogue_test m=%d n=%d k=%d threads=%d............", m, n, k,
+      threads);
+
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  C = random_matrix(m, n);
+  CC = allocate_matrix(m, n);
+  rowBias = random_matrix(m, 1);
+  colBias = random_matrix(1, n);
+  for (i = 0; i < m * n; i++) {
+    CC[i] = C[i];
+  }
+
+  mm_epilogue_init(&epilogue);
+  mm_epilogue_scale(&epilogue, 0.5);
+  mm_epilogue_bias_rows(&epilogue, rowBias);
+  mm_epilogue_bias_cols(&epilogue, colBias);
+  mm_epilogue_callback(&epilogue, index_epilogue, NULL);
+  mm_epilogue_clamp(&epilogue, -100.0, 5.0 * k);
+  mm_epilogue_relu(&epilogue);
+
+  /* C = epilogue(1.0*(A*B) - 1.0*C) */
+  mm_pool_set_threads(threads);
+  local_mm_epilogue(m, n, k, 1.0, A, m, B, k, -1.0, C, m, &epilogue);
+
+  local_mm(m, n, k, 1.0, A, m, B, k, -1.0, CC, m);
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < m; i++) {
+      double c = 0.5 * CC[j * m + i] + rowBias[i] + colBias[j] + i - 2.0 * j;
+
+      c = (c < -100.0) ? -100.0 : ((c > 5.0 * k) ? 5.0 * k : c);
+      CC[j * m + i] = (c > 0.0) ? c : 0.0;
+    }
+  }
+
+  /* Verfiy the results */
+  verify_matrix(m, n, C, CC);
+
+  /* deallocate memory */
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+  deallocate_matrix(rowBias);
+  deallocate_matrix(colBias);
+  mm_pool_shutdown();
+
+  printf("passed\n");
+}
+
+/**
+ * Compare every int8 kernel the CPU has to a plain int32 product
+ **/
+void q8_test(int m, int n, int k) {
+  int i, j, p, isa, best;
+  int8_t *A, *B;
+  int32_t *C, *CC;
+
+  printf("q8_test m=%d n=%d k=%d............", m, n, k);
+
+  /* The full quantized range, -127 to 127 */
+  A = (int8_t *) malloc((size_t) m * k);
+  B = (int8_t *) malloc((size_t) k * n);
+  C = (int32_t *) malloc(sizeof(int32_t) * m * n);
+  CC = (int32_t *) malloc(sizeof(int32_t) * m * n);
+  assert(A && B && C && CC);
+  for (i = 0; i < m * k; i++) {
+    A[i] = (int8_t) (rand() % 255 - 127);
+  }
+  for (i = 0; i < k * n; i++) {
+    B[i] = (int8_t) (rand() % 255 - 127);
+  }
+  A[0] = -127;
+  B[0] = -127;
+
+  /* CC = A*B + 1 */
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < m; i++) {
+      CC[j * m + i] = 1;
+      for (p = 0; p < k; p++) {
+        CC[j * m + i] += (int32_t) A[p * m + i] * B[j * k + p];
+      }
+    }
+  }
+
+  best = mm_q8_set_isa(MM_Q8_VNNI);
+  for (isa = MM_Q8_SCALAR; isa <= best; isa++) {
+    mm_q8_set_isa(isa);
+    for (i = 0; i < m * n; i++) {
+      C[i] = 1;
+    }
+    local_mm_q8(m, n, k, A, m, B, k, 1, C, m);
+    for (i = 0; i < m * n; i++) {
+      assert(C[i] == CC[i]);
+    }
+  }
+  printf("%s ", mm_q8_isa_name(best));
+
+  free(A);
+  free(B);
+  free(C);
+  free(CC);
+
+  printf("passed\n");
+}
+
+/**
+ * Quantize, multiply and scale back; the result must be within the
+ *  rounding error of 8 bits of local_mm()
+ **/
+void q8_quantize_test(int m, int n, int k) {
+  int i;
+  double *A, *B, *C, *CC, *rowScale, *colScale;
+  int8_t *Aq, *Bq;
+  int32_t *Cq;
+  double err = 0.0, ref = 0.0;
+
+  printf("q8_quantize_test m=%d n=%d k=%d............", m, n, k);
+
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  C = zeros_matrix(m, n);
+  CC = zeros_matrix(m, n);
+  rowScale = (double *) malloc(sizeof(double) * m);
+  colScale = (double *) malloc(sizeof(double) * n);
+  Aq = (int8_t *) malloc((size_t) m * k);
+  Bq = (int8_t *) malloc((size_t) k * n);
+  Cq = (int32_t *) malloc(sizeof(int32_t) * m * n);
+  assert(rowScale && colScale && Aq && Bq && Cq);
+
+  /* random_matrix() holds integers 0 to 10, which 8 bits hold exactly
+   * only up to the scale; perturb them to exercise rounding */
+  for (i = 0; i < m * k; i++) {
+    A[i] = A[i] * 0.37 - 1.5;
+  }
+
+  mm_q8_row_scales(m, k, A, m, rowScale);
+  mm_q8_col_scales(k, n, B, k, colScale);
+  mm_q8_quantize_rows(m, k, A, m, rowScale, Aq, m);
+  mm_q8_quantize_cols(k, n, B, k, colScale, Bq, k);
+  local_mm_q8(m, n, k, Aq, m, Bq, k, 0, Cq, m);
+  mm_q8_dequantize(m, n, Cq, m, rowScale, colScale, 1.0, 0.0, C, m);
+
+  local_mm(m, n, k, 1.0, A, m, B, k, 0.0, CC, m);
+
+  for (i = 0; i < m * n; i++) {
+    err = fmax(err, fabs(C[i] - CC[i]));
+    ref = fmax(ref, fabs(CC[i]));
+  }
+  /* Each product is off by at most half a step of A's scale times |B| */
+  assert(err <= 0.01 * ref);
+
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+  free(rowScale);
+  free(colScale);
+  free(Aq);
+  free(Bq);
+  free(Cq);
+
+  printf("passed\n");
+}
+
+/**
+ * Maps a new temporary file for a rows by cols matrix; the file is
+ *  unlinked at once and goes away with the mapping
+ **/
+static void temp_matrix(int rows, int cols, mm_ooc_matrix_t *matrix) {
+  char path[] = "/tmp/unittest_mm_XXXXXX";
+  int fd = mkstemp(path);
+
+  assert(fd >= 0);
+  close(fd);
+  assert(mm_ooc_map(path, rows, cols, MM_OOC_CREATE, matrix) == 0);
+  unlink(path);
+}
+
+/**
+ * Compare local_mm_ooc() on mapped A and C, and B mapped or in memory,
+ *  to local_mm() under a budget of a few tiles
+ **/
+void ooc_test(int m, int n, int k, size_t budget, int mapB) {
+  int i, mt, nt, kt;
+  double *A, *B, *C, *CC;
+  mm_ooc_matrix_t mA, mB, mC;
+
+  printf("ooc_test m=%d n=%d k=%d budget=%d mapB=%d............", m, n, k,
+      (int) budget, mapB);
+
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  C = random_matrix(m, n);
+  CC = allocate_matrix(m, n);
+  for (i = 0; i < m * n; i++) {
+    CC[i] = C[i];
+  }
+
+  temp_matrix(m, k, &mA);
+  temp_matrix(m, n, &mC);
+  for (i = 0; i < m * k; i++) {
+    mA.data[i] = A[i];
+  }
+  for (i = 0; i < m * n; i++) {
+    mC.data[i] = C[i];
+  }
+  if (mapB) {
+    temp_matrix(k, n, &mB);
+    for (i = 0; i < k * n; i++) {
+      mB.data[i] = B[i];
+    }
+  } else {
+    mm_ooc_wrap(B, k, n, &mB);
+  }
+
+  /* The tiles and two chunks each of A and B fit the budget */
+  mm_ooc_tiles(m, n, k, budget, &mt, &nt, &kt);
+  assert(mt >= 1 && mt <= m && nt >= 1 && nt <= n && kt <= k);
+  assert((size_t) (mt * nt + 2 * kt * (mt + nt)) * sizeof(double) <= budget);
+
+  mm_ooc_set_budget(budget);
+  local_mm_ooc(2.0, &mA, &mB, -1.0, &mC);
+  local_mm(m, n, k, 2.0, A, m, B, k, -1.0, CC, m);
+
+  /* Verfiy the results */
+  verify_matrix(m, n, mC.data, CC);
+
+  /* deallocate memory */
+  mm_ooc_unmap(&mA);
+  mm_ooc_unmap(&mB);
+  mm_ooc_unmap(&mC);
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+
+  printf("passed\n");
+}
+
+/**
+ * Compare a generated kernel, called directly and through local_mm()
+ *  on a repeated shape, to mm::gemm() with the JIT off; the matrices
+ *  have leading dimensions pad larger than needed
+ **/
+void jit_test(int m, int n, int k, int pad, double alpha, double beta) {
+  int i, iter, before, previous;
+  int lda = m + pad, ldb = k + pad, ldc = m + pad;
+  double *A, *B, *C, *CC, *CCC;
+  double alphaBeta[2] = {alpha, beta};
+  mm_jit_kernel_t kernel;
+
+  printf("jit_test m=%d n=%d k=%d pad=%d alpha=%.1f beta=%.1f............",
+      m, n, k, pad, alpha, beta);
+
+  A = random_matrix(lda, k);
+  B = random_matrix(ldb, n);
+  C = random_matrix(ldc, n);
+  CC = allocate_matrix(ldc, n);
+  CCC = allocate_matrix(ldc, n);
+  for (i = 0; i < ldc * n; i++) {
+    CC[i] = C[i];
+    CCC[i] = C[i];
+  }
+
+  /* The kernels run under the native backend */
+  previous = mm_blas_select(MM_BLAS_NATIVE);
+  mm_jit_set_enabled(0);
+  assert(mm_jit_compile(m, n, k, lda, ldb, ldc, alpha, beta) == NULL);
+  local_mm(m, n, k, alpha, A, lda, B, ldb, beta, CC, ldc);
+  mm_jit_set_enabled(1);
+
+  /* Only where the CPU can run the kernels */
+  if (mm_jit_enabled()) {
+    /* The first call records the shape, the second generates it */
+    before = mm_jit_kernels();
+    for (iter = 0; iter < 2; iter++) {
+      for (i = 0; i < ldc * n; i++) {
+        CCC[i] = C[i];
+      }
+      local_mm(m, n, k, alpha, A, lda, B, ldb, beta, CCC, ldc);
+    }
+    assert(mm_jit_kernels() - before <= 1);
+    assert(mm_jit_lookup(m, n, k, lda, ldb, ldc, alpha, beta) != NULL);
+    assert(mm_jit_lookup(m + 2, n, k, lda + 2, ldb, ldc + 2, alpha, beta)
+        == NULL);
+
+    /* The padding rows of C are not touched */
+    verify_matrix(ldc, n, CCC, CC);
+
+    kernel = mm_jit_compile(m, n, k, lda, ldb, ldc, alpha, beta);
+    assert(kernel != NULL);
+    kernel(A, B, C, alphaBeta);
+    verify_matrix(ldc, n, C, CC);
+  }
+
+  mm_blas_select(previous);
+
+  /* deallocate memory */
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+  deallocate_matrix(CCC);
+
+  printf("passed\n");
+}
+
+/**
+ * Compare every BLAS backend found, and local_mm() under MM_BLAS_AUTO,
+ *  to the native kernel on the same inputs
+ **/
+void blas_test(int m, int n, int k) {
+  int i, b, chosen, previous;
+  double *A, *B, *C0, *C, *CC;
+
+  printf("blas_test m=%d n=%d k=%d backends=%d............", m, n, k,
+      mm_blas_count());
+
+  A = random_matrix(m + 1, k);
+  B = random_matrix(k + 2, n);
+  C0 = random_matrix(m + 3, n);
+  C = allocate_matrix(m + 3, n);
+  CC = allocate_matrix(m + 3, n);
+
+  assert(mm_blas_find("native") == MM_BLAS_NATIVE);
+  assert(mm_blas_find("no such library") == -1);
+
+  for (b = 0; b <= mm_blas_count(); b++) {
+    for (i = 0; i < (m + 3) * n; i++) {
+      C[i] = C0[i];
+      CC[i] = C0[i];
+    }
+
+    /* The last round is local_mm() on the backend auto picks */
+    if (b < mm_blas_count()) {
+      mm_blas_dgemm(b, m, n, k, 2.0, A, m + 1, B, k + 2, -1.0, CC, m + 3);
+    } else {
+      previous = mm_blas_select(MM_BLAS_AUTO);
+      local_mm(m, n, k, 2.0, A, m + 1, B, k + 2, -1.0, CC, m + 3);
+      chosen = mm_blas_choose(m, n, k);
+      assert(chosen >= 0 && chosen < mm_blas_count());
+      assert(mm_blas_choose(m, n, k) == chosen);
+      mm_blas_select(previous);
+    }
+    local_mm_native(m, n, k, 2.0, A, m + 1, B, k + 2, -1.0, C, m + 3);
+
+    /* Verfiy the results */
+    verify_matrix(m + 3, n, CC, C);
+  }
+
+  /* deallocate memory */
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(C0);
+  deallocate_matrix(C);
+  deallocate_matrix(CC);
+
+  printf("passed\n");
+}
+
 int main() {
 
   printf("Hello World\n");
@@ -195,9 +993,53 @@ int main() {
   identity_test(512);
   ones_test(32, 32, 32);
   ones_test(61, 128, 123);
+  empty_k_test(2, 2);
+  empty_k_test(61, 37);
   lower_triangular_test(8);
   lower_triangular_test(92);
   lower_triangular_test(128);
+  trmm_test(8, 3);
+  trmm_test(150, 77);
+  trmm_test(256, 256);
+  syrk_test(8, 5);
+  syrk_test(150, 37);
+  syrk_test(200, 300);
+  syrk_test(40, 0);
+  single_precision_test(32, 32, 32);
+  single_precision_test(61, 128, 123);
+  mixed_precision_test(61, 128, 123);
+  complex_test(32, 32, 32, MM_COMPLEX_4M);
+  complex_test(61, 128, 123, MM_COMPLEX_4M);
+  complex_test(32, 32, 32, MM_COMPLEX_3M);
+  complex_test(61, 128, 123, MM_COMPLEX_3M);
+  complex_test(7, 5, 0, MM_COMPLEX_3M);
+  pool_test(256, 256, 256);
+  pool_test(1000, 3, 300);
+  pool_test(8, 8, 4096);
+  spmm_test(128, 96, 200, 0.05);
+  spmm_test(61, 133, 123, 0.5);
+  spmm_test(40, 7, 30, 0.0);
+  epilogue_test(61, 37, 123, 1);
+  epilogue_test(256, 256, 256, 4);
+  epilogue_test(8, 8, 4096, 4);
+  epilogue_test(13, 9, 0, 1);
+  q8_test(16, 4, 4);
+  q8_test(61, 37, 123);
+  q8_test(256, 256, 1000);
+  q8_quantize_test(128, 64, 200);
+  ooc_test(200, 150, 123, 64 << 10, 1);
+  ooc_test(30, 300, 77, 64 << 10, 0);
+  ooc_test(1000, 9, 600, 256 << 10, 1);
+  ooc_test(64, 64, 0, 64 << 10, 1);
+  jit_test(8, 4, 16, 0, 1.0, 0.0);
+  jit_test(12, 7, 13, 3, 2.0, -1.0);
+  jit_test(64, 61, 30, 5, 1.0, 1.0);
+  jit_test(36, 3, 9, 1, 0.5, 0.5);
+  jit_test(128, 128, 16, 0, 1.0, 1.0);
+  jit_test(20, 9, 1, 2, 1.0, 1.0);
+  blas_test(61, 37, 123);
+  blas_test(256, 256, 256);
+  blas_test(8, 4, 16);
 
   return 0;
 }
@@ -7,12 +7,16 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <mpi.h>
 #include <unistd.h>
+#include <math.h>
 
 #include "matrix_utils.h"
 #include "local_mm.h"
 #include "summa.h"
+#include "dist_matrix.h"
+#include "summa_chain.h"
 
 #define true 1
 #define false 0
@@ -20,6 +24,14 @@
 
 #define EPS 0.0001
 
+static int lookahead = 0; /*!< random_matrix_test() uses summa_dag() when positive */
+static int use_rma = 0; /*!< random_matrix_test() uses summa_rma() when set */
+static int use_topology = 0; /*!< random_matrix_test() distributes by grid rank */
+static int algorithm = SUMMA_STATIONARY_C; /*!< random_matrix_test() uses
+                                              summa_run() otherwise */
+static double sparse_density = 0.0; /*!< random_matrix_test() uses a sparse A
+                                       and summa_sparse() when positive */
+
 /** 
  * Similar to verify_matrix(),
  *  this function verifies that each element of A
@@ -70,7 +82,8 @@ bool random_matrix_test(int m, int n, int k, int px, int py, int panel_size) {
 
   if (rank == 0) {
     /* Allocate matrices */
-    A = random_matrix(m, k);
+    A = (sparse_density > 0.0) ? random_matrix_sparse(m, k, sparse_density)
+        : random_matrix(m, k);
     B = random_matrix(k, n);
     C = zeros_matrix(m, n);
 
@@ -100,10 +113,17 @@ bool random_matrix_test(int m, int n, int k, int px, int py, int panel_size) {
   assert(CC_block);
 
   /* Distrute the matrices */
-  distribute_matrix(px, py, m, k, A, A_block, rank);
-  distribute_matrix(px, py, k, n, B, B_block, rank);
-  distribute_matrix(px, py, m, n, C, C_block, rank);
-  distribute_matrix(px, py, m, n, CC, CC_block, rank);
+  if (use_topology) {
+    summa_distribute_matrix(px, py, m, k, A, A_block);
+    summa_distribute_matrix(px, py, k, n, B, B_block);
+    summa_distribute_matrix(px, py, m, n, C, C_block);
+    summa_distribute_matrix(px, py, m, n, CC, CC_block);
+  } else {
+    distribute_matrix(px, py, m, k, A, A_block, rank);
+    distribute_matrix(px, py, k, n, B, B_block, rank);
+    distribute_matrix(px, py, m, n, C, C_block, rank);
+    distribute_matrix(px, py, m, n, CC, CC_block, rank);
+  }
 
   /* Printing matrices for debugging purposes */
   /*
@@ -157,7 +177,22 @@ bool random_matrix_test(int m, int n, int k, int px, int py, int panel_size) {
    *
    */
 
-  summa(m, n, k, A_block, B_block, C_block, px, py, 1);
+  if (sparse_density > 0.0) {
+    mm_csr_t A_csr;
+
+    mm_csr_from_dense(m / px, k / py, A_block, m / px, &A_csr);
+    summa_sparse(m, n, k, &A_csr, B_block, C_block, px, py, panel_size);
+    mm_csr_free(&A_csr);
+  } else if (algorithm != SUMMA_STATIONARY_C) {
+    summa_run(algorithm, m, n, k, A_block, B_block, C_block, px, py,
+        panel_size);
+  } else if (use_rma) {
+    summa_rma(m, n, k, A_block, B_block, C_block, px, py, panel_size);
+  } else if (lookahead > 0) {
+    summa_dag(m, n, k, A_block, B_block, C_block, px, py, panel_size, lookahead);
+  } else {
+    summa(m, n, k, A_block, B_block, C_block, px, py, 1);
+  }
 
 #ifdef DEBUG
   /* flush output and synchronize the processes */
@@ -246,6 +281,953 @@ bool random_matrix_test(int m, int n, int k, int px, int py, int panel_size) {
   }
 }
 
+/**
+ * Multiplies random matrices with summa_f() and summa_mixed()
+ *  and compares both to the double-precision local solution
+ *
+ * The entries of A and B are not exact in single precision,
+ *  summa_f() is checked to single-precision accuracy and
+ *  summa_mixed() to double-precision accuracy.
+ **/
+bool precision_test(int m, int n, int k, int px, int py, int panel_size) {
+  int i, passed_test = 0, group_passed = 0;
+  int num_procs = px * py;
+  int rank = 0;
+  int block_size = (m * n) / num_procs;
+  double *A, *B, *CC, *A_block, *B_block, *C_block, *CC_block;
+  float *Af_block, *Bf_block, *Cf_block;
+
+  A = NULL;
+  B = NULL;
+  CC = NULL;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank); /* Get process id */
+
+  if (rank == 0) {
+    /* Allocate matrices */
+    A = random_matrix(m, k);
+    B = random_matrix(k, n);
+    for (i = 0; i < m * k; i++) {
+      A[i] /= 3.0;
+    }
+    for (i = 0; i < k * n; i++) {
+      B[i] /= 7.0;
+    }
+
+    /* Stores the solution */
+    CC = zeros_matrix(m, n);
+    local_mm(m, n, k, 1.0, A, m, B, k, 0.0, CC, m);
+  }
+
+  /* Distribute the matrices */
+  A_block = allocate_matrix(m / px, k / py);
+  B_block = allocate_matrix(k / px, n / py);
+  CC_block = allocate_matrix(m / px, n / py);
+
+  distribute_matrix(px, py, m, k, A, A_block, rank);
+  distribute_matrix(px, py, k, n, B, B_block, rank);
+  distribute_matrix(px, py, m, n, CC, CC_block, rank);
+
+  if (rank == 0) {
+    deallocate_matrix(A);
+    deallocate_matrix(B);
+    deallocate_matrix(CC);
+  }
+
+  /* Single precision, relative to the size of the entries */
+  Af_block = convert_matrix_f(m / px, k / py, A_block);
+  Bf_block = convert_matrix_f(k / px, n / py, B_block);
+  Cf_block = allocate_matrix_f(m / px, n / py);
+  for (i = 0; i < block_size; i++) {
+    Cf_block[i] = 0.0f;
+  }
+
+  summa_f(m, n, k, Af_block, Bf_block, Cf_block, px, py, panel_size);
+
+  for (i = 0; i < block_size; i++) {
+    if (fabs(Cf_block[i] - CC_block[i]) > 1e-5 * k * 10.0) {
+      passed_test = 1;
+    }
+  }
+
+  /* Mixed precision, to double-precision accuracy */
+  C_block = zeros_matrix(m / px, n / py);
+
+  summa_mixed(m, n, k, A_block, B_block, C_block, px, py, panel_size);
+
+  for (i = 0; i < block_size; i++) {
+    if (fabs(C_block[i] - CC_block[i]) > 1e-12 * k * 10.0) {
+      passed_test = 1;
+    }
+  }
+
+  deallocate_matrix(A_block);
+  deallocate_matrix(B_block);
+  deallocate_matrix(C_block);
+  deallocate_matrix(CC_block);
+  deallocate_matrix_f(Af_block);
+  deallocate_matrix_f(Bf_block);
+  deallocate_matrix_f(Cf_block);
+
+  /* group_passed == 0 if every process passed */
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf(
+        "precision_test m=%d n=%d k=%d px=%d py=%d pb=%d............%s\n",
+        m, n, k, px, py, panel_size, (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Runs two nonblocking multiplies on the same grid at once, driven by
+ *  summa_test(), and a third through summa_wait(), and compares all
+ *  three to the local solution
+ **/
+bool async_test(int m, int n, int k, int px, int py, int panel_size) {
+  int passed_test = 0, group_passed = 0;
+  int rank = 0;
+  int done1 = 0, done2 = 0;
+  double *A, *B, *CC, *A_block, *B_block, *C1_block, *C2_block, *C3_block,
+      *CC_block;
+  summa_request_t request1, request2, request3;
+
+  A = NULL;
+  B = NULL;
+  CC = NULL;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank); /* Get process id */
+
+  if (rank == 0) {
+    A = random_matrix(m, k);
+    B = random_matrix(k, n);
+    CC = zeros_matrix(m, n);
+    local_mm(m, n, k, 1.0, A, m, B, k, 0.0, CC, m);
+  }
+
+  /* Distribute the matrices */
+  A_block = allocate_matrix(m / px, k / py);
+  B_block = allocate_matrix(k / px, n / py);
+  CC_block = allocate_matrix(m / px, n / py);
+
+  distribute_matrix(px, py, m, k, A, A_block, rank);
+  distribute_matrix(px, py, k, n, B, B_block, rank);
+  distribute_matrix(px, py, m, n, CC, CC_block, rank);
+
+  if (rank == 0) {
+    deallocate_matrix(A);
+    deallocate_matrix(B);
+    deallocate_matrix(CC);
+  }
+
+  C1_block = zeros_matrix(m / px, n / py);
+  C2_block = zeros_matrix(m / px, n / py);
+  C3_block = zeros_matrix(m / px, n / py);
+
+  /* Two in flight, different panel sizes */
+  request1 = summa_begin(m, n, k, A_block, B_block, C1_block, px, py,
+      panel_size);
+  request2 = summa_begin(m, n, k, A_block, B_block, C2_block, px, py, 1);
+  while (!done1 || !done2) {
+    done1 = summa_test(&request1);
+    done2 = summa_test(&request2);
+  }
+
+  request3 = summa_begin(m, n, k, A_block, B_block, C3_block, px, py,
+      panel_size);
+  summa_wait(&request3);
+
+  if (request1 != NULL || request2 != NULL || request3 != NULL
+      || verify_matrix_bool(m / px, n / py, C1_block, CC_block) == false
+      || verify_matrix_bool(m / px, n / py, C2_block, CC_block) == false
+      || verify_matrix_bool(m / px, n / py, C3_block, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  deallocate_matrix(A_block);
+  deallocate_matrix(B_block);
+  deallocate_matrix(C1_block);
+  deallocate_matrix(C2_block);
+  deallocate_matrix(C3_block);
+  deallocate_matrix(CC_block);
+
+  /* group_passed == 0 if every process passed */
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf(
+        "async_test m=%d n=%d k=%d px=%d py=%d pb=%d............%s\n",
+        m, n, k, px, py, panel_size, (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Executes one plan twice on the same C blocks, so C = 2*A*B, and
+ *  compares to the local solution
+ **/
+bool plan_test(int m, int n, int k, int px, int py, int panel_size) {
+  int i, passed_test = 0, group_passed = 0;
+  int rank = 0;
+  double *A, *B, *CC, *A_block, *B_block, *C_block, *CC_block;
+  summa_plan_t plan;
+
+  A = NULL;
+  B = NULL;
+  CC = NULL;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank); /* Get process id */
+
+  if (rank == 0) {
+    A = random_matrix(m, k);
+    B = random_matrix(k, n);
+    CC = zeros_matrix(m, n);
+    local_mm(m, n, k, 2.0, A, m, B, k, 0.0, CC, m);
+  }
+
+  /* Distribute the matrices */
+  A_block = allocate_matrix(m / px, k / py);
+  B_block = allocate_matrix(k / px, n / py);
+  C_block = zeros_matrix(m / px, n / py);
+  CC_block = allocate_matrix(m / px, n / py);
+
+  distribute_matrix(px, py, m, k, A, A_block, rank);
+  distribute_matrix(px, py, k, n, B, B_block, rank);
+  distribute_matrix(px, py, m, n, CC, CC_block, rank);
+
+  if (rank == 0) {
+    deallocate_matrix(A);
+    deallocate_matrix(B);
+    deallocate_matrix(CC);
+  }
+
+  plan = summa_plan_create(m, n, k, px, py, panel_size);
+  for (i = 0; i < 2; i++) {
+    summa_plan_execute(plan, A_block, B_block, C_block);
+  }
+  summa_plan_free(&plan);
+
+  if (plan != NULL
+      || verify_matrix_bool(m / px, n / py, C_block, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  deallocate_matrix(A_block);
+  deallocate_matrix(B_block);
+  deallocate_matrix(C_block);
+  deallocate_matrix(CC_block);
+
+  /* group_passed == 0 if every process passed */
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf(
+        "plan_test m=%d n=%d k=%d px=%d py=%d pb=%d............%s\n",
+        m, n, k, px, py, panel_size, (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Checks that summa_select() keeps the dominant operand in place,
+ *  splits k when it dominates and uses the 1D algorithms on 1D grids
+ **/
+bool select_test() {
+  int rank = 0;
+  bool passed;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  passed = summa_select(1024, 1024, 1024, 4, 4) == SUMMA_STATIONARY_C
+      && summa_select(256, 256, 1024, 8, 8) == SUMMA_STATIONARY_A
+      && summa_select(4096, 128, 1024, 4, 4) == SUMMA_STATIONARY_A
+      && summa_select(128, 4096, 1024, 4, 4) == SUMMA_STATIONARY_B
+      && summa_select(128, 128, 4096, 4, 4) == SUMMA_INNER
+      && summa_select(4096, 64, 64, 16, 1) == SUMMA_1D_ROW
+      && summa_select(64, 4096, 64, 1, 16) == SUMMA_1D_COL;
+
+  if (rank == 0) {
+    printf("select_test............%s\n", passed ? "PASSED" : "FAILED");
+  }
+
+  return passed;
+}
+
+/**
+ * Emulates nodes of 4 ranks and checks that summa_set_topology() keeps
+ *  the heavier A panels within nodes, then multiplies on that grid
+ **/
+bool topology_test() {
+  int rank = 0;
+  double before, after;
+  bool passed;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  setenv("SUMMA_NODE_SIZE", "4", 1);
+
+  /* m / px by k panels of A outweigh k by n / py panels of B */
+  before = summa_topology_report(NULL, 256, 64, 64, 4, 4);
+  summa_set_topology(256, 64, 64, 4, 4);
+  after = summa_topology_report((rank == 0) ? stdout : NULL, 256, 64, 64, 4, 4);
+
+  passed = after < before
+      && after == 4 * 4 * 3 * (64 / 4) * (64 / 4) * sizeof(double);
+
+  if (rank == 0) {
+    printf("topology_test............%s\n", passed ? "PASSED" : "FAILED");
+  }
+
+  use_topology = 1;
+  passed = random_matrix_test(256, 64, 64, 4, 4, 1) && passed;
+  algorithm = SUMMA_STATIONARY_A;
+  passed = random_matrix_test(256, 64, 64, 4, 4, 8) && passed;
+  algorithm = SUMMA_INNER;
+  passed = random_matrix_test(256, 64, 64, 4, 4, 1) && passed;
+  algorithm = SUMMA_STATIONARY_C;
+  use_topology = 0;
+
+  summa_clear_topology();
+  unsetenv("SUMMA_NODE_SIZE");
+
+  return passed;
+}
+
+/**
+ * Moves A (m by n) from the 4 by 4 block layout through block-cyclic
+ *  layouts, on 2 by 8 and on 2 by 2 of the 16 processes, to the 8 by
+ *  2 block layout, then multiplies it there by B (n by n) and
+ *  compares both to distribute_matrix() of the local solution
+ **/
+bool dist_test(int m, int n) {
+  int rank = 0, passed_test = 0, group_passed = 0;
+  double *A = NULL, *B = NULL, *CC = NULL, *CC_block;
+  dist_matrix_t a44, a28, a22, a82, b82, c82;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  if (rank == 0) {
+    A = random_matrix(m, n);
+    B = random_matrix(n, n);
+    CC = zeros_matrix(m, n);
+    local_mm(m, n, n, 1.0, A, m, B, n, 0.0, CC, m);
+  }
+
+  dist_matrix_init(&a44, m, n, 4, 4, 0, 0);
+  dist_matrix_init(&a28, m, n, 2, 8, 3, 5);
+  dist_matrix_init(&a22, m, n, 2, 2, 7, 2);
+  dist_matrix_init(&a82, m, n, 8, 2, 0, 0);
+  dist_matrix_init(&b82, n, n, 8, 2, 0, 0);
+  dist_matrix_init(&c82, m, n, 8, 2, 0, 0);
+  distribute_matrix(4, 4, m, n, A, a44.data, rank);
+  distribute_matrix(8, 2, n, n, B, b82.data, rank);
+
+  dist_matrix_redistribute(&a44, &a28);
+  dist_matrix_redistribute(&a28, &a22);
+  dist_matrix_redistribute(&a22, &a82);
+
+  /* a82 must be what distribute_matrix() gives for that grid */
+  CC_block = allocate_matrix(m / 8, n / 2);
+  distribute_matrix(8, 2, m, n, A, CC_block, rank);
+  if (verify_matrix_bool(m / 8, n / 2, a82.data, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  distribute_matrix(8, 2, m, n, CC, CC_block, rank);
+  memset(c82.data, 0, sizeof(double) * c82.localRows * c82.localCols);
+  summa_dist(&a82, &b82, &c82, 1);
+  if (verify_matrix_bool(m / 8, n / 2, c82.data, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  dist_matrix_free(&a44);
+  dist_matrix_free(&a28);
+  dist_matrix_free(&a22);
+  dist_matrix_free(&a82);
+  dist_matrix_free(&b82);
+  dist_matrix_free(&c82);
+  deallocate_matrix(CC_block);
+  if (rank == 0) {
+    deallocate_matrix(A);
+    deallocate_matrix(B);
+    deallocate_matrix(CC);
+  }
+
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("dist_test m=%d n=%d............%s\n", m, n,
+        (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Compares summa_multi() on terms products with a different k each to
+ *  one summa() call per term
+ **/
+bool multi_test(int terms, int m, int n, const int *k, int px, int py,
+    int panel_size) {
+  int t, rank = 0, passed_test = 0, group_passed = 0;
+  double *A_blocks[4], *B_blocks[4], *C_block, *CC_block;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  assert(terms <= 4);
+
+  /* Only the blocks matter, so each rank makes up its own */
+  srand(m + n + terms + rank);
+  for (t = 0; t < terms; t++) {
+    A_blocks[t] = random_matrix(m / px, k[t] / py);
+    B_blocks[t] = random_matrix(k[t] / px, n / py);
+  }
+  C_block = ones_matrix(m / px, n / py);
+  CC_block = ones_matrix(m / px, n / py);
+
+  summa_multi(terms, m, n, k, A_blocks, B_blocks, C_block, px, py,
+      panel_size);
+  for (t = 0; t < terms; t++) {
+    summa(m, n, k[t], A_blocks[t], B_blocks[t], CC_block, px, py,
+        (k[t] % panel_size == 0) ? panel_size : 1);
+  }
+
+  if (verify_matrix_bool(m / px, n / py, C_block, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  for (t = 0; t < terms; t++) {
+    deallocate_matrix(A_blocks[t]);
+    deallocate_matrix(B_blocks[t]);
+  }
+  deallocate_matrix(C_block);
+  deallocate_matrix(CC_block);
+
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("multi_test terms=%d m=%d n=%d px=%d py=%d pb=%d............%s\n",
+        terms, m, n, px, py, panel_size,
+        (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Checks summa_chain_order() on the textbook six-matrix chain, whose
+ *  cheapest order by flops is ((M0 (M1 M2)) ((M3 M4) M5))
+ **/
+bool chain_order_test() {
+  int rank = 0;
+  int dims[7] = {30, 35, 15, 5, 10, 20, 25};
+  int split[36];
+  char order[64];
+  double cost;
+  bool passed;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  cost = summa_chain_order(6, dims, 1, 1, 5, NULL, split);
+  summa_chain_format(6, split, order, sizeof(order));
+  passed = (cost == 2.0 * 15125) && strcmp(order,
+      "((M0 (M1 M2)) ((M3 M4) M5))") == 0;
+
+  if (rank == 0) {
+    printf("chain_order_test %s............%s\n", order,
+        passed ? "PASSED" : "FAILED");
+  }
+
+  return passed;
+}
+
+/**
+ * Multiplies a chain of count matrices with summa_chain() and compares
+ *  to local_mm() from left to right on rank 0
+ **/
+bool chain_test(int count, const int *dims, int px, int py, int panel_size) {
+  int i, rank = 0, passed_test = 0, group_passed = 0;
+  double *M = NULL, *P = NULL, *T = NULL, *CC_block;
+  dist_matrix_t mats[8], C;
+  const dist_matrix_t *factors[8];
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  assert(count <= 8);
+
+  if (rank == 0) {
+    P = random_matrix(dims[0], dims[1]);
+  }
+  dist_matrix_init(&mats[0], dims[0], dims[1], px, py, 0, 0);
+  distribute_matrix(px, py, dims[0], dims[1], P, mats[0].data, rank);
+  factors[0] = &mats[0];
+
+  for (i = 1; i < count; i++) {
+    if (rank == 0) {
+      M = random_matrix(dims[i], dims[i + 1]);
+      T = zeros_matrix(dims[0], dims[i + 1]);
+      local_mm(dims[0], dims[i + 1], dims[i], 1.0, P, dims[0], M, dims[i],
+          0.0, T, dims[0]);
+      deallocate_matrix(P);
+      P = T;
+    }
+    dist_matrix_init(&mats[i], dims[i], dims[i + 1], px, py, 0, 0);
+    distribute_matrix(px, py, dims[i], dims[i + 1], M, mats[i].data, rank);
+    factors[i] = &mats[i];
+    if (rank == 0) {
+      deallocate_matrix(M);
+    }
+  }
+
+  /* C = 1 + M0 * ... * M(count-1) */
+  dist_matrix_init(&C, dims[0], dims[count], px, py, 0, 0);
+  for (i = 0; i < C.localRows * C.localCols; i++) {
+    C.data[i] = 1.0;
+  }
+  summa_chain(count, factors, &C, panel_size, NULL);
+
+  CC_block = allocate_matrix(dims[0] / px, dims[count] / py);
+  distribute_matrix(px, py, dims[0], dims[count], P, CC_block, rank);
+  for (i = 0; i < C.localRows * C.localCols; i++) {
+    CC_block[i] += 1.0;
+  }
+  if (verify_matrix_bool(C.localRows, C.localCols, C.data, CC_block)
+      == false) {
+    passed_test = 1;
+  }
+
+  for (i = 0; i < count; i++) {
+    dist_matrix_free(&mats[i]);
+  }
+  dist_matrix_free(&C);
+  deallocate_matrix(CC_block);
+  if (rank == 0) {
+    deallocate_matrix(P);
+  }
+
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("chain_test count=%d px=%d py=%d pb=%d............%s\n", count,
+        px, py, panel_size, (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Multiplies a full random A's lower triangle by B with summa_trmm()
+ *  and compares to distribute_matrix() of the local solution
+ **/
+bool trmm_test(int m, int n, int px, int py, int panel_size) {
+  int i, rank = 0, passed_test = 0, group_passed = 0;
+  double *A = NULL, *L = NULL, *B = NULL, *C = NULL, *CC = NULL;
+  double *A_block, *B_block, *C_block, *CC_block;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  if (rank == 0) {
+    /* The upper triangle of A is garbage summa_trmm() must not read */
+    A = random_matrix(m, m);
+    L = lowerTri_matrix(m, m);
+    for (i = 0; i < m * m; i++) {
+      L[i] *= A[i];
+    }
+    B = random_matrix(m, n);
+    C = random_matrix(m, n);
+    CC = allocate_matrix(m, n);
+    for (i = 0; i < m * n; i++) {
+      CC[i] = C[i];
+    }
+    local_mm(m, n, m, 1.0, L, m, B, m, 1.0, CC, m);
+  }
+
+  A_block = allocate_matrix(m / px, m / py);
+  B_block = allocate_matrix(m / px, n / py);
+  C_block = allocate_matrix(m / px, n / py);
+  CC_block = allocate_matrix(m / px, n / py);
+  distribute_matrix(px, py, m, m, A, A_block, rank);
+  distribute_matrix(px, py, m, n, B, B_block, rank);
+  distribute_matrix(px, py, m, n, C, C_block, rank);
+  distribute_matrix(px, py, m, n, CC, CC_block, rank);
+
+  summa_trmm(m, n, A_block, B_block, C_block, px, py, panel_size);
+
+  if (verify_matrix_bool(m / px, n / py, C_block, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  deallocate_matrix(A_block);
+  deallocate_matrix(B_block);
+  deallocate_matrix(C_block);
+  deallocate_matrix(CC_block);
+  if (rank == 0) {
+    deallocate_matrix(A);
+    deallocate_matrix(L);
+    deallocate_matrix(B);
+    deallocate_matrix(C);
+    deallocate_matrix(CC);
+  }
+
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("trmm_test m=%d n=%d px=%d py=%d pb=%d............%s\n", m, n, px,
+        py, panel_size, (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Forms A*A^T + C with summa_syrk() on a p by p grid and checks that
+ *  the lower triangle matches the local solution and the upper
+ *  triangle of C is untouched
+ **/
+bool syrk_test(int n, int k, int p, int panel_size) {
+  int i, j, rank = 0, passed_test = 0, group_passed = 0;
+  double *A = NULL, *At = NULL, *C = NULL, *CC = NULL;
+  double *A_block, *C_block, *CC_block;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  if (rank == 0) {
+    A = random_matrix(n, k);
+    At = allocate_matrix(k, n);
+    for (j = 0; j < k; j++) {
+      for (i = 0; i < n; i++) {
+        At[i * k + j] = A[j * n + i];
+      }
+    }
+    C = random_matrix(n, n);
+    CC = allocate_matrix(n, n);
+    for (i = 0; i < n * n; i++) {
+      CC[i] = C[i];
+    }
+    local_mm(n, n, k, 1.0, A, n, At, k, 1.0, CC, n);
+    for (j = 0; j < n; j++) {
+      for (i = 0; i < j; i++) {
+        CC[j * n + i] = C[j * n + i];
+      }
+    }
+  }
+
+  A_block = allocate_matrix(n / p, k / p);
+  C_block = allocate_matrix(n / p, n / p);
+  CC_block = allocate_matrix(n / p, n / p);
+  distribute_matrix(p, p, n, k, A, A_block, rank);
+  distribute_matrix(p, p, n, n, C, C_block, rank);
+  distribute_matrix(p, p, n, n, CC, CC_block, rank);
+
+  summa_syrk(n, k, A_block, C_block, p, p, panel_size);
+
+  if (verify_matrix_bool(n / p, n / p, C_block, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  deallocate_matrix(A_block);
+  deallocate_matrix(C_block);
+  deallocate_matrix(CC_block);
+  if (rank == 0) {
+    deallocate_matrix(A);
+    deallocate_matrix(At);
+    deallocate_matrix(C);
+    deallocate_matrix(CC);
+  }
+
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("syrk_test n=%d k=%d p=%d pb=%d............%s\n", n, k, p,
+        panel_size, (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Checks summa_q8_int() against the exact int32 product and summa_q8()
+ *  against quantizing and multiplying the whole matrices locally
+ **/
+bool q8_test(int m, int n, int k, int px, int py, int panel_size) {
+  int i, j, p, rank = 0, passed_test = 0, group_passed = 0;
+  double *A = NULL, *B = NULL, *C = NULL, *CC = NULL, *rowScale, *colScale;
+  double *A_block, *B_block, *C_block, *CC_block;
+  int8_t *Aq, *Bq, *Aq_block, *Bq_block;
+  int32_t *Cq, *Cq_block;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  /* Every rank builds the same inputs; int8 blocks are cut locally */
+  srand(m + n + k);
+  A = random_matrix(m, k);
+  B = random_matrix(k, n);
+  for (i = 0; i < m * k; i++) {
+    A[i] = A[i] * 0.37 - 1.5;
+  }
+  rowScale = malloc(sizeof(double) * m);
+  colScale = malloc(sizeof(double) * n);
+  Aq = malloc((size_t) m * k);
+  Bq = malloc((size_t) k * n);
+  Cq = calloc((size_t) m * n, sizeof(int32_t));
+  assert(rowScale && colScale && Aq && Bq && Cq);
+  mm_q8_row_scales(m, k, A, m, rowScale);
+  mm_q8_col_scales(k, n, B, k, colScale);
+  mm_q8_quantize_rows(m, k, A, m, rowScale, Aq, m);
+  mm_q8_quantize_cols(k, n, B, k, colScale, Bq, k);
+  local_mm_q8(m, n, k, Aq, m, Bq, k, 0, Cq, m);
+
+  if (rank == 0) {
+    C = ones_matrix(m, n);
+    CC = ones_matrix(m, n);
+    mm_q8_dequantize(m, n, Cq, m, rowScale, colScale, 1.0, 1.0, CC, m);
+  }
+
+  A_block = allocate_matrix(m / px, k / py);
+  B_block = allocate_matrix(k / px, n / py);
+  C_block = allocate_matrix(m / px, n / py);
+  CC_block = allocate_matrix(m / px, n / py);
+  distribute_matrix(px, py, m, k, A, A_block, rank);
+  distribute_matrix(px, py, k, n, B, B_block, rank);
+  distribute_matrix(px, py, m, n, C, C_block, rank);
+  distribute_matrix(px, py, m, n, CC, CC_block, rank);
+
+  /* Block (x, y) of the int8 matrices */
+  Aq_block = malloc((size_t) (m / px) * (k / py));
+  Bq_block = malloc((size_t) (k / px) * (n / py));
+  Cq_block = calloc((size_t) (m / px) * (n / py), sizeof(int32_t));
+  assert(Aq_block && Bq_block && Cq_block);
+  for (j = 0; j < k / py; j++) {
+    for (i = 0; i < m / px; i++) {
+      Aq_block[j * (m / px) + i] = Aq[(size_t) ((rank / px) * (k / py) + j) * m
+          + (rank % px) * (m / px) + i];
+    }
+  }
+  for (j = 0; j < n / py; j++) {
+    for (p = 0; p < k / px; p++) {
+      Bq_block[j * (k / px) + p] = Bq[(size_t) ((rank / px) * (n / py) + j) * k
+          + (rank % px) * (k / px) + p];
+    }
+  }
+
+  summa_q8_int(m, n, k, Aq_block, Bq_block, Cq_block, px, py, panel_size);
+  for (j = 0; j < n / py; j++) {
+    for (i = 0; i < m / px; i++) {
+      if (Cq_block[j * (m / px) + i] != Cq[(size_t) ((rank / px) * (n / py)
+          + j) * m + (rank % px) * (m / px) + i]) {
+        passed_test = 1;
+      }
+    }
+  }
+
+  summa_q8(m, n, k, A_block, B_block, C_block, px, py, panel_size);
+  if (verify_matrix_bool(m / px, n / py, C_block, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  deallocate_matrix(A);
+  deallocate_matrix(B);
+  deallocate_matrix(A_block);
+  deallocate_matrix(B_block);
+  deallocate_matrix(C_block);
+  deallocate_matrix(CC_block);
+  free(rowScale);
+  free(colScale);
+  free(Aq);
+  free(Bq);
+  free(Cq);
+  free(Aq_block);
+  free(Bq_block);
+  free(Cq_block);
+  if (rank == 0) {
+    deallocate_matrix(C);
+    deallocate_matrix(CC);
+  }
+
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("q8_test m=%d n=%d k=%d px=%d py=%d pb=%d (%s)............%s\n", m,
+        n, k, px, py, panel_size, mm_q8_isa_name(mm_q8_isa()),
+        (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Compares summa_z() and the planar summa_zp() under algorithm
+ *  against four real local multiplies of the whole matrices
+ **/
+bool complex_test(int m, int n, int k, int px, int py, int panel_size,
+    int algorithm) {
+  int i, rank = 0, passed_test = 0, group_passed = 0;
+  int blockA = (m / px) * (k / py);
+  int blockB = (k / px) * (n / py);
+  int blockC = (m / px) * (n / py);
+  double *Ar, *Ai, *Br, *Bi, *Cr = NULL, *Ci = NULL;
+  double *Ar_block, *Ai_block, *Br_block, *Bi_block, *Cr_block, *Ci_block;
+  double *CCr_block, *CCi_block;
+  mm_complex_double *A_block, *B_block, *C_block;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  srand(m + n + k);
+  Ar = random_matrix(m, k);
+  Ai = random_matrix(m, k);
+  Br = random_matrix(k, n);
+  Bi = random_matrix(k, n);
+
+  if (rank == 0) {
+    Cr = ones_matrix(m, n);
+    Ci = ones_matrix(m, n);
+    local_mm(m, n, k, 1.0, Ar, m, Br, k, 1.0, Cr, m);
+    local_mm(m, n, k, -1.0, Ai, m, Bi, k, 1.0, Cr, m);
+    local_mm(m, n, k, 1.0, Ar, m, Bi, k, 1.0, Ci, m);
+    local_mm(m, n, k, 1.0, Ai, m, Br, k, 1.0, Ci, m);
+  }
+
+  Ar_block = allocate_matrix(m / px, k / py);
+  Ai_block = allocate_matrix(m / px, k / py);
+  Br_block = allocate_matrix(k / px, n / py);
+  Bi_block = allocate_matrix(k / px, n / py);
+  Cr_block = ones_matrix(m / px, n / py);
+  Ci_block = ones_matrix(m / px, n / py);
+  CCr_block = allocate_matrix(m / px, n / py);
+  CCi_block = allocate_matrix(m / px, n / py);
+  distribute_matrix(px, py, m, k, Ar, Ar_block, rank);
+  distribute_matrix(px, py, m, k, Ai, Ai_block, rank);
+  distribute_matrix(px, py, k, n, Br, Br_block, rank);
+  distribute_matrix(px, py, k, n, Bi, Bi_block, rank);
+  distribute_matrix(px, py, m, n, Cr, CCr_block, rank);
+  distribute_matrix(px, py, m, n, Ci, CCi_block, rank);
+
+  A_block = malloc(sizeof(mm_complex_double) * blockA);
+  B_block = malloc(sizeof(mm_complex_double) * blockB);
+  C_block = malloc(sizeof(mm_complex_double) * blockC);
+  assert(A_block && B_block && C_block);
+  for (i = 0; i < blockA; i++) {
+    A_block[i] = Ar_block[i] + Ai_block[i] * I;
+  }
+  for (i = 0; i < blockB; i++) {
+    B_block[i] = Br_block[i] + Bi_block[i] * I;
+  }
+  for (i = 0; i < blockC; i++) {
+    C_block[i] = 1.0 + 1.0 * I;
+  }
+
+  local_mm_set_complex(algorithm);
+  summa_z(m, n, k, A_block, B_block, C_block, px, py, panel_size);
+  summa_zp(m, n, k, Ar_block, Ai_block, Br_block, Bi_block, Cr_block,
+      Ci_block, px, py, panel_size);
+  local_mm_set_complex(MM_COMPLEX_4M);
+
+  for (i = 0; i < blockC; i++) {
+    if (creal(C_block[i]) != CCr_block[i] || cimag(C_block[i]) != CCi_block[i]
+        || Cr_block[i] != CCr_block[i] || Ci_block[i] != CCi_block[i]) {
+      passed_test = 1;
+    }
+  }
+
+  deallocate_matrix(Ar);
+  deallocate_matrix(Ai);
+  deallocate_matrix(Br);
+  deallocate_matrix(Bi);
+  deallocate_matrix(Ar_block);
+  deallocate_matrix(Ai_block);
+  deallocate_matrix(Br_block);
+  deallocate_matrix(Bi_block);
+  deallocate_matrix(Cr_block);
+  deallocate_matrix(Ci_block);
+  deallocate_matrix(CCr_block);
+  deallocate_matrix(CCi_block);
+  free(A_block);
+  free(B_block);
+  free(C_block);
+  if (rank == 0) {
+    deallocate_matrix(Cr);
+    deallocate_matrix(Ci);
+  }
+
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("complex_test m=%d n=%d k=%d px=%d py=%d pb=%d %s............%s\n",
+        m, n, k, px, py, panel_size,
+        (algorithm == MM_COMPLEX_3M) ? "3M" : "4M",
+        (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
+/**
+ * Compares summa_epilogue() with summa() followed by the same
+ *  epilogue as a separate pass over Cblock
+ **/
+bool epilogue_test(int m, int n, int k, int px, int py, int panel_size) {
+  int rank = 0, passed_test = 0, group_passed = 0;
+  double *A_block, *B_block, *C_block, *CC_block, *rowBias, *colBias;
+  mm_epilogue_t epilogue;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  /* Only the blocks matter, so each rank makes up its own */
+  srand(m + n + k + rank);
+  A_block = random_matrix(m / px, k / py);
+  B_block = random_matrix(k / px, n / py);
+  C_block = random_matrix(m / px, n / py);
+  CC_block = allocate_matrix(m / px, n / py);
+  memcpy(CC_block, C_block, sizeof(double) * (m / px) * (n / py));
+  rowBias = random_matrix(m / px, 1);
+  colBias = random_matrix(1, n / py);
+
+  mm_epilogue_init(&epilogue);
+  mm_epilogue_bias_rows(&epilogue, rowBias);
+  mm_epilogue_scale(&epilogue, -0.25);
+  mm_epilogue_bias_cols(&epilogue, colBias);
+  mm_epilogue_relu(&epilogue);
+
+  summa_epilogue(m, n, k, A_block, B_block, C_block, px, py, panel_size,
+      &epilogue);
+
+  summa(m, n, k, A_block, B_block, CC_block, px, py, panel_size);
+  mm_epilogue_apply(&epilogue, 0, 0, m / px, n / py, CC_block, m / px);
+
+  if (verify_matrix_bool(m / px, n / py, C_block, CC_block) == false) {
+    passed_test = 1;
+  }
+
+  deallocate_matrix(A_block);
+  deallocate_matrix(B_block);
+  deallocate_matrix(C_block);
+  deallocate_matrix(CC_block);
+  deallocate_matrix(rowBias);
+  deallocate_matrix(colBias);
+
+  MPI_Allreduce(&passed_test, &group_passed, 1, MPI_INT, MPI_SUM,
+      MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("epilogue_test m=%d n=%d k=%d px=%d py=%d pb=%d............%s\n",
+        m, n, k, px, py, panel_size,
+        (group_passed == 0) ? "PASSED" : "FAILED");
+  }
+
+  return (group_passed == 0) ? true : false;
+}
+
 #ifdef DEBUG
 #  define exit_on_fail(passed) if (passed == false) { goto finalize; }
 #else
@@ -285,6 +1267,184 @@ int main(int argc, char *argv[]) {
   exit_on_fail( random_matrix_test(128, 128, 128, 2, 8, 1));
   exit_on_fail( random_matrix_test(128, 128, 128, 1, 16, 16));
   exit_on_fail( random_matrix_test(128, 128, 128, 16, 1, 1));
+
+  /* Test single and mixed precision */
+  exit_on_fail( precision_test(128, 128, 128, 4, 4, 8));
+  exit_on_fail( precision_test(64, 32, 128, 8, 2, 32));
+
+  /* Test the ring broadcast, with segments shorter than one column
+   *  and with one segment per band */
+  summa_set_bcast(SUMMA_BCAST_RING, 64);
+  if (rank == 0) {
+    printf("Ring broadcast, segment=64\n");
+  }
+  exit_on_fail( random_matrix_test(128, 128, 128, 4, 4, 1));
+  exit_on_fail( random_matrix_test(128, 128, 128, 2, 8, 1));
+  exit_on_fail( precision_test(128, 128, 128, 4, 4, 8));
+  exit_on_fail( precision_test(64, 32, 128, 8, 2, 32));
+  exit_on_fail( trmm_test(128, 64, 4, 4, 8));
+  exit_on_fail( syrk_test(128, 64, 4, 8));
+  sparse_density = 0.05;
+  exit_on_fail( random_matrix_test(128, 128, 128, 4, 4, 8));
+  sparse_density = 0.0;
+
+  summa_set_bcast(SUMMA_BCAST_RING, SUMMA_BCAST_SEGMENT_DEFAULT);
+  if (rank == 0) {
+    printf("Ring broadcast, segment=%d\n", SUMMA_BCAST_SEGMENT_DEFAULT);
+  }
+  exit_on_fail( random_matrix_test(128, 128, 128, 16, 1, 1));
+  exit_on_fail( precision_test(128, 128, 128, 4, 4, 8));
+
+  summa_set_bcast(SUMMA_BCAST_MPI, SUMMA_BCAST_SEGMENT_DEFAULT);
+
+  /* Test the task-graph SUMMA, panels straddling owners included */
+  for (lookahead = 1; lookahead <= 4; lookahead *= 4) {
+    if (rank == 0) {
+      printf("Task-graph summa_dag, lookahead=%d\n", lookahead);
+    }
+    exit_on_fail( random_matrix_test(16, 16, 16, 4, 4, 4));
+    exit_on_fail( random_matrix_test(128, 128, 128, 4, 4, 1));
+    exit_on_fail( random_matrix_test(128, 32, 128, 4, 4, 64));
+    exit_on_fail( random_matrix_test(128, 128, 128, 8, 2, 16));
+    exit_on_fail( random_matrix_test(128, 128, 128, 1, 16, 32));
+  }
+  lookahead = 0;
+
+  /* Test the one-sided SUMMA, panels straddling owners included */
+  use_rma = 1;
+  if (rank == 0) {
+    printf("One-sided summa_rma\n");
+  }
+  exit_on_fail( random_matrix_test(16, 16, 16, 4, 4, 4));
+  exit_on_fail( random_matrix_test(128, 128, 128, 4, 4, 1));
+  exit_on_fail( random_matrix_test(128, 32, 128, 4, 4, 64));
+  exit_on_fail( random_matrix_test(128, 128, 128, 8, 2, 16));
+  exit_on_fail( random_matrix_test(128, 128, 128, 16, 1, 32));
+  use_rma = 0;
+
+  /* Test the stationary-A and stationary-B variants, panels of C that
+   *  do not divide the blocks included */
+  for (algorithm = SUMMA_STATIONARY_A; algorithm <= SUMMA_STATIONARY_B;
+      algorithm++) {
+    if (rank == 0) {
+      printf("Stationary-%c summa_stationary\n",
+          (algorithm == SUMMA_STATIONARY_A) ? 'A' : 'B');
+    }
+    exit_on_fail( random_matrix_test(16, 16, 16, 4, 4, 4));
+    exit_on_fail( random_matrix_test(128, 128, 128, 4, 4, 5));
+    exit_on_fail( random_matrix_test(64, 32, 128, 4, 4, 3));
+    exit_on_fail( random_matrix_test(128, 128, 128, 8, 2, 16));
+    exit_on_fail( random_matrix_test(128, 128, 128, 1, 16, 8));
+    exit_on_fail( random_matrix_test(128, 128, 128, 16, 1, 8));
+  }
+
+  /* Test the one-dimensional and inner-product algorithms */
+  algorithm = SUMMA_1D_ROW;
+  if (rank == 0) {
+    printf("Row-distributed summa_1d_row\n");
+  }
+  exit_on_fail( random_matrix_test(128, 128, 128, 16, 1, 1));
+  exit_on_fail( random_matrix_test(1024, 16, 32, 16, 1, 1));
+
+  algorithm = SUMMA_1D_COL;
+  if (rank == 0) {
+    printf("Column-distributed summa_1d_col\n");
+  }
+  exit_on_fail( random_matrix_test(128, 128, 128, 1, 16, 1));
+  exit_on_fail( random_matrix_test(16, 1024, 32, 1, 16, 1));
+
+  algorithm = SUMMA_INNER;
+  if (rank == 0) {
+    printf("Inner-product summa_inner\n");
+  }
+  exit_on_fail( random_matrix_test(16, 16, 16, 4, 4, 1));
+  exit_on_fail( random_matrix_test(16, 32, 2048, 4, 4, 1));
+  exit_on_fail( random_matrix_test(32, 16, 1040, 8, 2, 1));
+  exit_on_fail( random_matrix_test(16, 16, 8, 2, 8, 1));
+  algorithm = SUMMA_STATIONARY_C;
+
+  /* Test the sparse-A variant, mostly-zero and empty panels included */
+  if (rank == 0) {
+    printf("Sparse A summa_sparse\n");
+  }
+  sparse_density = 0.05;
+  exit_on_fail( random_matrix_test(16, 16, 16, 4, 4, 1));
+  exit_on_fail( random_matrix_test(128, 128, 128, 4, 4, 8));
+  exit_on_fail( random_matrix_test(64, 32, 128, 8, 2, 5));
+  exit_on_fail( random_matrix_test(128, 128, 128, 16, 1, 16));
+  sparse_density = 0.001;
+  exit_on_fail( random_matrix_test(128, 128, 256, 2, 8, 4));
+  sparse_density = 0.0;
+
+  /* Test the triangular and symmetric variants */
+  exit_on_fail( trmm_test(16, 16, 4, 4, 1));
+  exit_on_fail( trmm_test(128, 64, 4, 4, 8));
+  exit_on_fail( trmm_test(128, 128, 8, 2, 5));
+  exit_on_fail( trmm_test(96, 32, 2, 8, 16));
+  exit_on_fail( syrk_test(16, 16, 4, 1));
+  exit_on_fail( syrk_test(128, 64, 4, 8));
+  exit_on_fail( syrk_test(96, 160, 4, 7));
+
+  /* Test the int8 SUMMA */
+  exit_on_fail( q8_test(16, 16, 16, 4, 4, 1));
+  exit_on_fail( q8_test(128, 128, 128, 4, 4, 8));
+  exit_on_fail( q8_test(64, 32, 128, 8, 2, 16));
+  exit_on_fail( q8_test(128, 64, 256, 2, 8, 4));
+
+  /* Test fused epilogues */
+  exit_on_fail( epilogue_test(16, 16, 16, 4, 4, 1));
+  exit_on_fail( epilogue_test(128, 128, 256, 4, 4, 8));
+  exit_on_fail( epilogue_test(64, 128, 128, 8, 2, 32));
+
+  /* Test complex SUMMA, interleaved and planar */
+  exit_on_fail( complex_test(16, 16, 16, 4, 4, 1, MM_COMPLEX_4M));
+  exit_on_fail( complex_test(128, 64, 128, 4, 4, 8, MM_COMPLEX_4M));
+  exit_on_fail( complex_test(16, 16, 16, 4, 4, 1, MM_COMPLEX_3M));
+  exit_on_fail( complex_test(128, 64, 128, 8, 2, 16, MM_COMPLEX_3M));
+  exit_on_fail( complex_test(64, 128, 256, 2, 8, 4, MM_COMPLEX_3M));
+
+  exit_on_fail( select_test());
+
+  /* Test distributed matrix descriptors and redistribution */
+  exit_on_fail( dist_test(64, 32));
+  exit_on_fail( dist_test(128, 96));
+
+  /* Test sums of products */
+  {
+    int one[1] = {64};
+    int three[3] = {64, 128, 32};
+    int ragged[4] = {16, 48, 128, 80};
+
+    exit_on_fail( multi_test(1, 64, 64, one, 4, 4, 8));
+    exit_on_fail( multi_test(3, 128, 64, three, 4, 4, 8));
+    exit_on_fail( multi_test(3, 64, 128, three, 8, 2, 1));
+    exit_on_fail( multi_test(4, 128, 128, ragged, 2, 8, 32));
+  }
+
+  /* Test matrix chains */
+  exit_on_fail( chain_order_test());
+  {
+    int two[3] = {64, 32, 48};
+    int four[5] = {16, 64, 8, 96, 32};
+    int six[7] = {32, 48, 16, 8, 64, 16, 32};
+
+    exit_on_fail( chain_test(2, two, 4, 4, 8));
+    exit_on_fail( chain_test(4, four, 4, 4, 4));
+    exit_on_fail( chain_test(6, six, 8, 2, 24));
+    exit_on_fail( chain_test(4, four, 2, 8, 1));
+  }
+
+  /* Test the topology-aware grid */
+  exit_on_fail( topology_test());
+
+  /* Test the split-phase interface */
+  exit_on_fail( async_test(128, 128, 128, 4, 4, 8));
+  exit_on_fail( async_test(128, 64, 128, 8, 2, 64));
+
+  /* Test persistent plans */
+  exit_on_fail( plan_test(128, 128, 128, 4, 4, 1));
+  exit_on_fail( plan_test(128, 32, 128, 4, 4, 64));
+  exit_on_fail( plan_test(128, 128, 128, 2, 8, 16));
   
 finalize: MPI_Finalize();
   return 0;